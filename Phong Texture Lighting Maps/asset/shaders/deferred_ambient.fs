@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gDepth;
+uniform vec3 ambient;
+
+void main()
+{
+    if (texture(gDepth, TexCoords).r == 1.0) discard; // no box here: keep the clear colour
+    FragColor = vec4(ambient * texture(gAlbedoSpecular, TexCoords).rgb, 1.0);
+}
@@ -0,0 +1,58 @@
+#version 330 core
+out vec4 FragColor;
+
+struct Light {
+    vec3 diffuse;
+    vec3 specular;
+};
+
+flat in vec4 Sphere; // view space position, radius
+flat in vec3 Colour;
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gNormalShininess;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+uniform vec2 screenSize;
+uniform Light light;
+
+vec3 decodeNormal(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    float depth = texture(gDepth, uv).r;
+    if (depth == 1.0) discard; // no box here
+
+    // view space position of the surface, from its depth
+    vec4 clip = vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 position = inverseProjection * clip;
+    vec3 fragPos = position.xyz / position.w;
+
+    vec3 toLight = Sphere.xyz - fragPos;
+    float distance = length(toLight);
+    if (distance >= Sphere.w) discard; // outside the light's reach (the box corners)
+
+    vec4 albedoSpecular = texture(gAlbedoSpecular, uv);
+    vec4 normalShininess = texture(gNormalShininess, uv);
+    vec3 norm = decodeNormal(normalShininess.xy);
+    float shininess = normalShininess.z * 256.0;
+
+    // same Phong terms as fragment.fs (the camera sits at the origin in view space)
+    vec3 lightDir = toLight / distance;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 viewDir = normalize(-fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+
+    // fades to 0 at the radius, close to 1 well inside it
+    float ratio = distance / Sphere.w;
+    float fade = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    vec3 result = light.diffuse * diff * albedoSpecular.rgb + light.specular * spec * albedoSpecular.a;
+    FragColor = vec4(Colour * result * fade * fade, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;   // box corner (-1 to 1)
+layout (location = 3) in vec4 aLight; // position, radius (one per instance)
+layout (location = 4) in vec4 aColour;
+
+flat out vec4 Sphere; // view space position, radius
+flat out vec3 Colour;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    // a box just big enough to hold the light's sphere
+    gl_Position = projection * view * vec4(aLight.xyz + aPos * aLight.w, 1.0);
+    Sphere = vec4((view * vec4(aLight.xyz, 1.0)).xyz, aLight.w);
+    Colour = aColour.rgb;
+}
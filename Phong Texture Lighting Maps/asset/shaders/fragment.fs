@@ -0,0 +1,81 @@
+#version 330 core
+out vec4 FragColor;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;    
+    float shininess;
+}; 
+
+struct Light {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+in vec3 FragPos;  
+in vec3 Normal;  
+in vec2 TexCoords;
+  
+uniform vec3 viewPos;
+uniform Material material;
+uniform Light light;        // strengths, the same for every light
+uniform samplerBuffer lights; // 2 texels per point light: position + radius, colour
+uniform int lightCount;
+
+// clustered: only the lights listed for this fragment's cluster (see clusters.h)
+uniform bool clustered;
+uniform mat4 view;
+uniform usamplerBuffer clusterGrid;   // per cluster: first index, light count
+uniform usamplerBuffer clusterLights; // light indices
+uniform ivec3 clusterCount;           // tiles x, tiles y, depth slices
+uniform vec2 tileSize;                // in pixels
+uniform vec2 sliceScaleBias;          // slice = log(depth) * scale + bias
+
+void main()
+{
+    vec3 albedo = texture(material.diffuse, TexCoords).rgb;
+    vec3 specularMap = texture(material.specular, TexCoords).rgb;
+
+    // ambient (once, not per light)
+    vec3 result = light.ambient * albedo;
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    // forward: every light, for every fragment (see deferred.h for the other way round)
+    int first = 0;
+    int count = lightCount;
+    if (clustered) {
+        float depth = -(view * vec4(FragPos, 1.0)).z;
+        ivec2 tile = min(ivec2(gl_FragCoord.xy / tileSize), clusterCount.xy - 1);
+        int slice = clamp(int(log(depth) * sliceScaleBias.x + sliceScaleBias.y), 0, clusterCount.z - 1);
+        uvec2 cluster = texelFetch(clusterGrid, (slice * clusterCount.y + tile.y) * clusterCount.x + tile.x).xy;
+        first = int(cluster.x);
+        count = int(cluster.y);
+    }
+
+    for (int n = 0; n < count; ++n) {
+        int i = clustered ? int(texelFetch(clusterLights, first + n).r) : n;
+        vec4 sphere = texelFetch(lights, i * 2);
+        vec3 colour = texelFetch(lights, i * 2 + 1).rgb;
+        vec3 toLight = sphere.xyz - FragPos;
+        float distance = length(toLight);
+        if (distance >= sphere.w) continue; // out of this light's reach
+
+        // diffuse 
+        vec3 lightDir = toLight / distance;
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = light.diffuse * diff * albedo;
+
+        // specular
+        vec3 reflectDir = reflect(-lightDir, norm);  
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+        vec3 specular = light.specular * spec * specularMap;
+
+        // fades to 0 at the radius, close to 1 well inside it
+        float ratio = distance / sphere.w;
+        float fade = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+        result += colour * (diffuse + specular) * fade * fade;
+    }
+    FragColor = vec4(result, 1.0);
+} 
\ No newline at end of file
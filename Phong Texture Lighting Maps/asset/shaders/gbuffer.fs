@@ -0,0 +1,34 @@
+#version 330 core
+layout (location = 0) out vec4 AlbedoSpecular;
+layout (location = 1) out vec4 NormalShininess;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+uniform Material material;
+uniform mat4 view;
+
+// unit vector -> 2 values in 0..1 (octahedral: the sphere folded onto a square, even precision everywhere)
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return folded * 0.5 + 0.5;
+}
+
+void main()
+{
+    // what fragment.fs would light, stored for the light pass instead
+    vec3 albedo = texture(material.diffuse, TexCoords).rgb;
+    float specular = dot(texture(material.specular, TexCoords).rgb, vec3(0.2126, 0.7152, 0.0722)); // one channel
+    vec3 norm = normalize(mat3(view) * normalize(Normal)); // lighting happens in view space
+
+    AlbedoSpecular = vec4(albedo, specular);
+    NormalShininess = vec4(encodeNormal(norm), material.shininess / 256.0, 1.0);
+}
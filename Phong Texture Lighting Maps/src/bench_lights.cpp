@@ -0,0 +1,239 @@
+// Light count benchmark: draws the boxes headless (surfaceless EGL, see headers/headless.h) with 1, 16, 256 and
+// 1024 point lights, forward, clustered and deferred, and reports GPU and frame times of each run.
+// Forward runs the light loop for every box fragment (cost grows with boxes x lights), clustered only loops over the
+// lights near the fragment, deferred lights each pixel once per light that reaches it (cost grows with
+// boxes + lights): run it with more boxes to see the gap grow.
+// Camera path, light orbits and box layout are seeded and use a fixed timestep, so every run draws the same frames.
+// Compare the frame times: software drivers (llvmpipe) draw the forward frame after the GPU timer query has ended,
+// so its GPU time reads close to 0 there.
+//
+// To run this code (Linux): navigate to "Phong Texture Lighting Maps" folder -> copy/paste below
+// g++ -O2 -std=c++17 -Iinclude src/glad.c src/bench_lights.cpp -lEGL -ldl -pthread -o build/bench_lights && build/bench_lights
+//
+// Options:
+//   --lights N[,N...]  light counts, default 1,16,256,1024
+//   --boxes N[,N...]   box counts (5 = the demo, more = a random cloud around it), default 5,200
+//   --modes LIST       any of forward, clustered, deferred, default all three
+//   --frames N         measured frames per run (one camera lap), default 120
+//   --warmup N         unmeasured frames before each run, default 10
+//   --size WxH         framebuffer size, default 1280x720
+//   --json PATH        results file, default bench_lights.json
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "headers/headless.h"
+#include "headers/shader.h"
+#include "headers/mesh.h"
+#include "headers/camera.h"
+
+struct Settings {
+    int frames = 120;
+    int warmup = 10;
+    int width = 1280, height = 720;
+};
+
+struct Summary {
+    float mean = 0.0f, p50 = 0.0f, p90 = 0.0f, p99 = 0.0f, max = 0.0f;
+};
+
+struct Result {
+    int boxes = 0, lights = 0;
+    std::string mode;
+    Summary gpu, frame;
+    float clusterMs = 0.0f;   // clustered: mean CPU time building the clusters
+    float lightsPerCluster = 0.0f, maxPerCluster = 0.0f; // clustered: mean over the frames
+};
+
+Summary summarize(std::vector<float> values) {
+    Summary s;
+    if (values.empty()) return s;
+    std::sort(values.begin(), values.end());
+    auto at = [&](float q) { return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))]; };
+    for (float v : values) s.mean += v;
+    s.mean /= static_cast<float>(values.size());
+    s.p50 = at(0.5f);
+    s.p90 = at(0.9f);
+    s.p99 = at(0.99f);
+    s.max = values.back();
+    return s;
+}
+
+// One lap around the boxes, slightly above them, always looking at the middle of the scene
+void cameraPath(Camera &camera, float t) {
+    const glm::vec3 centre(0.5f, 0.5f, -0.5f);
+    float angle = 2.0f * 3.14159265f * t;
+    camera.Position = centre + glm::vec3(std::cos(angle) * 11.0f, 3.0f, std::sin(angle) * 11.0f);
+    camera.focusOn(centre, glm::length(centre - camera.Position));
+}
+
+Result run(Tri &tri, Shader &light, Shader &shader, HeadlessContext &context, const Settings &settings) {
+    Result result;
+    result.boxes = tri.getBoxCount();
+    result.lights = tri.getLightCount();
+    result.mode = shadingName(tri.getShading());
+
+    GLuint query;
+    glGenQueries(1, &query);
+    std::vector<float> gpu, frame;
+    Camera camera;
+
+    using Clock = std::chrono::steady_clock;
+    for (int i = 0; i < settings.warmup + settings.frames; ++i) {
+        int step = std::max(0, i - settings.warmup); // warm-up frames all draw the first frame
+        float time = static_cast<float>(step) / 60.0f;
+        cameraPath(camera, static_cast<float>(step) / static_cast<float>(settings.frames));
+
+        Clock::time_point start = Clock::now();
+        context.bind();
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        tri.render(light, shader, camera, time);
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish(); // no swapBuffers to wait on: the frame is done when the GPU is done
+        context.endFrame();
+        Clock::time_point end = Clock::now();
+
+        if (i < settings.warmup) continue;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        gpu.push_back(static_cast<float>(nanoseconds) / 1e6f);
+        frame.push_back(std::chrono::duration<float, std::milli>(end - start).count());
+        if (tri.getShading() == Shading::Clustered) {
+            const LightClusters &clusters = tri.getClusters();
+            result.clusterMs += clusters.getBuildMilliseconds() / settings.frames;
+            result.lightsPerCluster += static_cast<float>(clusters.getIndexCount()) / LightClusters::COUNT / settings.frames;
+            result.maxPerCluster += static_cast<float>(clusters.getMaxLightsPerCluster()) / settings.frames;
+        }
+    }
+    glDeleteQueries(1, &query);
+
+    result.gpu = summarize(gpu);
+    result.frame = summarize(frame);
+    return result;
+}
+
+std::vector<std::string> parseNames(const std::string &text) {
+    std::vector<std::string> names;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) names.push_back(item);
+    }
+    return names;
+}
+
+std::vector<int> parseList(const std::string &text) {
+    std::vector<int> values;
+    for (const std::string &item : parseNames(text)) values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+void writeSummary(std::ofstream &json, const char *name, const Summary &s) {
+    json << ", \"" << name << "\": {\"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90
+         << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+}
+
+int main(int argc, char **argv) {
+    std::vector<int> lightCounts = {1, 16, 256, 1024};
+    std::vector<int> boxCounts = {5, 200};
+    std::vector<std::string> modes = {"forward", "clustered", "deferred"};
+    Settings settings;
+    std::string jsonPath = "bench_lights.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lights" && i + 1 < argc) lightCounts = parseList(argv[++i]);
+        else if (arg == "--boxes" && i + 1 < argc) boxCounts = parseList(argv[++i]);
+        else if (arg == "--modes" && i + 1 < argc) modes = parseNames(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc) settings.frames = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && i + 1 < argc) settings.warmup = std::atoi(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &settings.width, &settings.height) != 2) settings.width = settings.height = 0;
+        }
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else {
+            std::cerr << "usage: bench_lights [--lights N[,N...]] [--boxes N[,N...]] [--modes forward,clustered,deferred] [--frames N]"
+                         " [--warmup N] [--size WxH] [--json PATH]\n";
+            return 1;
+        }
+    }
+    if (settings.frames <= 0 || settings.warmup < 0 || lightCounts.empty() || boxCounts.empty() ||
+        settings.width <= 0 || settings.height <= 0) {
+        std::cerr << "bench_lights: need at least one light count, box count and frame, and a positive size\n";
+        return 1;
+    }
+    for (const std::string &mode : modes) {
+        if (mode != "forward" && mode != "clustered" && mode != "deferred") {
+            std::cerr << "bench_lights: unknown mode " << mode << "\n";
+            return 1;
+        }
+    }
+
+    HeadlessContext context(settings.width, settings.height);
+    if (context.Initialise() != 0) {
+        return 1;
+    }
+
+    Tri tri;
+    tri.setViewport(settings.width, settings.height);
+    Shader shader("asset/shaders/vertex.vs", "asset/shaders/fragment.fs");
+    Shader light("asset/shaders/lightver.vs", "asset/shaders/lightfrag.fs");
+    std::cout << "G-buffer: " << tri.getDeferred().getBytes() / 1024 << " KB\n";
+
+    std::vector<Result> results;
+    for (int boxes : boxCounts) {
+        tri.setBoxCount(boxes);
+        for (int lights : lightCounts) {
+            tri.setLightCount(lights);
+            for (const std::string &mode : modes) {
+                tri.setShading(mode == "forward" ? Shading::Forward : mode == "clustered" ? Shading::Clustered : Shading::Deferred);
+                results.push_back(run(tri, light, shader, context, settings));
+                const Result &r = results.back();
+                std::cout << "boxes " << r.boxes << ", lights " << r.lights << ", " << r.mode
+                          << ": GPU mean " << r.gpu.mean << " ms, p50 " << r.gpu.p50 << " ms, p99 " << r.gpu.p99
+                          << " ms; frame mean " << r.frame.mean << " ms, p99 " << r.frame.p99 << " ms";
+                if (mode == "clustered") {
+                    std::cout << "; cluster build " << r.clusterMs << " ms, " << r.lightsPerCluster
+                              << " lights per cluster (max " << r.maxPerCluster << ")";
+                }
+                std::cout << "\n";
+            }
+        }
+    }
+
+    std::ofstream json(jsonPath);
+    if (!json) {
+        std::cerr << "bench_lights: cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    json << "{\n  \"benchmark\": \"bench_lights\",\n  \"renderer\": \"" << glGetString(GL_RENDERER)
+         << "\",\n  \"width\": " << settings.width << ",\n  \"height\": " << settings.height
+         << ",\n  \"frames\": " << settings.frames << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        json << "    {\"boxes\": " << r.boxes << ", \"lights\": " << r.lights << ", \"mode\": \"" << r.mode << "\"";
+        writeSummary(json, "gpu_ms", r.gpu);
+        writeSummary(json, "frame_ms", r.frame);
+        if (r.mode == "clustered") {
+            json << ", \"cluster_build_ms\": " << r.clusterMs << ", \"lights_per_cluster\": " << r.lightsPerCluster
+                 << ", \"max_lights_per_cluster\": " << r.maxPerCluster;
+        }
+        json << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    std::cout << "results written to " << jsonPath << "\n";
+
+    tri.del();
+    glDeleteProgram(shader.ID);
+    glDeleteProgram(light.ID);
+    return 0;
+}
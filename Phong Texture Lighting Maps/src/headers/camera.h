@@ -57,6 +57,15 @@ public:
         return glm::perspective(glm::radians(Fov), aspectRatio, nearPlane, farPlane);
     }
 
+    // Turn to face `target` and move to `distance` away from it
+    void focusOn(const glm::vec3 &target, float distance) {
+        glm::vec3 direction = glm::normalize(target - Position);
+        Position = target - direction * distance;
+        Pitch = glm::degrees(asin(direction.y));
+        Yaw = glm::degrees(atan2(direction.z, direction.x));
+        updateCameraVectors();
+    }
+
     // Key control method using bool keys[1024];
     void keyControl(bool* keys, float deltaTime) {
         float velocity = MovementSpeed * deltaTime;
@@ -103,28 +112,33 @@ public:
         updateCameraVectors();
     }
 
-    void movelight(glm::vec3& lightPos) {
+    void movelight(glm::vec3& lightPos) { movelight(lightPos, glfwGetTime()); }
+
+    // time: seconds since the start (the benchmark passes a fixed timestep instead of the clock)
+    void movelight(glm::vec3& lightPos, float time) {
         float radius = 5.0f; // Radius of the circle
         float speed = 2.0f;   // Speed of light's movement
-        float angle = glfwGetTime() * speed;
+        float angle = time * speed;
 
         lightPos.x = radius * cos(angle);  // Circular motion in the X direction
         lightPos.z = radius * sin(angle);  // Circular motion in the Z direction
 
         // Vertical oscillation (light moves up and down over time)
-        lightPos.y = 2.0f + sin(glfwGetTime()) * 2.0f;  // Adds vertical movement
+        lightPos.y = 2.0f + sin(time) * 2.0f;  // Adds vertical movement
     }
 
-    void movelight2(glm::vec3& lightPos2) { // move in different direction
+    void movelight2(glm::vec3& lightPos2) { movelight2(lightPos2, glfwGetTime()); }
+
+    void movelight2(glm::vec3& lightPos2, float time) { // move in different direction
         float radius = 5.0f; // Radius of the circle
         float speed = 1.0f;   // Speed of light's movement
-        float angle = glfwGetTime() * speed;
+        float angle = time * speed;
 
         lightPos2.y = radius * cos(angle);  // Circular motion in the X direction
         lightPos2.z = radius * sin(angle);  // Circular motion in the Z direction
 
         // Vertical oscillation (light moves up and down over time)
-        lightPos2.x = 2.0f + sin(glfwGetTime()) * 2.0f;  // Adds vertical movement
+        lightPos2.x = 2.0f + sin(time) * 2.0f;  // Adds vertical movement
     }
 
 private:
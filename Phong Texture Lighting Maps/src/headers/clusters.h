@@ -0,0 +1,248 @@
+#ifndef CLUSTERS_H
+#define CLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "shader.h"
+#include "lights.h"
+#include "jobs.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Clustered forward shading: the view frustum is cut into TILES_X x TILES_Y screen tiles and SLICES depth slices
+// (exponential, so a cluster is about as deep as it is wide), and every frame the CPU lists the lights touching each
+// cluster. fragment.fs then only loops over its own cluster's list: a fragment pays for the lights near it, not for
+// all of them. It still shades while drawing (no G-buffer), so blending and MSAA work like plain forward shading.
+//
+// GPU data (texture buffers, so GL 3.3 is enough):
+//   grid:    RG32UI per cluster: first index, light count
+//   indices: R16UI light indices, every cluster's list one after another
+//
+// Frame:
+//   clusters.build(lights, view, projection, 0.1f, 100.0f, jobs); // after lights.update(), one job per depth slice
+//   clusters.upload();
+//   clusters.bind(shader, 3, 4, width, height);                // texture units for the grid and the indices
+class LightClusters {
+public:
+    static const int TILES_X = 16, TILES_Y = 9, SLICES = 24;
+    static const int COUNT = TILES_X * TILES_Y * SLICES;
+    static_assert(PointLights::MAX_LIGHTS <= 65536, "light indices are stored in 16 bits");
+    static_assert(TILES_X % 4 == 0, "a row of tiles is tested 4 at a time");
+
+    void create() {
+        grid.assign(COUNT * 2, 0);
+        lists.assign(COUNT, std::vector<uint16_t>());
+
+        glGenBuffers(1, &gridBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, grid.size() * sizeof(GLuint), grid.data(), GL_STREAM_DRAW);
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+        indexCapacity = 4096;
+        glBufferData(GL_TEXTURE_BUFFER, indexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        glGenTextures(1, &gridTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, gridBuffer);
+        glGenTextures(1, &indexTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, indexBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Lists the lights touching each cluster. `projection` must be a glm::perspective with these near / far planes.
+    void build(const PointLights &lights, const glm::mat4 &view, const glm::mat4 &projection, float nearZ, float farZ,
+               JobSystem &jobs) {
+        auto start = std::chrono::steady_clock::now();
+        if (projection != lastProjection || nearZ != nearPlane || farZ != farPlane) {
+            computeBounds(projection, nearZ, farZ);
+        }
+
+        // view space spheres and the depth slices each one reaches (first > last = in front of / behind the frustum)
+        const std::vector<PointLight> &all = lights.get();
+        size_t count = all.size();
+        sphereX.resize(count);
+        sphereY.resize(count);
+        sphereZ.resize(count);
+        sphereRadius.resize(count);
+        firstSlice.resize(count);
+        lastSlice.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 centre = glm::vec3(view * glm::vec4(all[i].position, 1.0f));
+            float radius = all[i].radius;
+            sphereX[i] = centre.x;
+            sphereY[i] = centre.y;
+            sphereZ[i] = centre.z;
+            sphereRadius[i] = radius;
+            float depth = -centre.z;
+            if (depth + radius < nearPlane || depth - radius > farPlane) {
+                firstSlice[i] = 1;
+                lastSlice[i] = 0;
+                continue;
+            }
+            firstSlice[i] = sliceOf(depth - radius);
+            lastSlice[i] = sliceOf(depth + radius);
+        }
+
+        // every slice only writes its own clusters' lists, so the slices need no locking
+        jobs.parallelFor(SLICES, [&](size_t begin, size_t end) {
+            for (size_t slice = begin; slice < end; ++slice) buildSlice(static_cast<int>(slice));
+        }, 1);
+
+        // pack the lists one after another, in cluster order
+        indices.clear();
+        maxPerCluster = 0;
+        for (int cluster = 0; cluster < COUNT; ++cluster) {
+            const std::vector<uint16_t> &list = lists[cluster];
+            grid[cluster * 2] = static_cast<GLuint>(indices.size());
+            grid[cluster * 2 + 1] = static_cast<GLuint>(list.size());
+            indices.insert(indices.end(), list.begin(), list.end());
+            maxPerCluster = std::max(maxPerCluster, static_cast<int>(list.size()));
+        }
+        buildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Copies the grid and the lists into their buffers (new storage every frame, like PointLights::upload)
+    void upload() {
+        glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, grid.size() * sizeof(GLuint), grid.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+        if (indices.size() > indexCapacity) indexCapacity = std::max(indices.size(), indexCapacity * 2);
+        glBufferData(GL_TEXTURE_BUFFER, indexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, indices.size() * sizeof(uint16_t), indices.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Binds the grid and index buffers and sets fragment.fs's cluster uniforms (width / height: the viewport)
+    void bind(Shader &shader, int gridUnit, int indexUnit, int width, int height) {
+        glActiveTexture(GL_TEXTURE0 + gridUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+        glActiveTexture(GL_TEXTURE0 + indexUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+        shader.setInt("clusterGrid", gridUnit);
+        shader.setInt("clusterLights", indexUnit);
+        glUniform3i(glGetUniformLocation(shader.ID, "clusterCount"), TILES_X, TILES_Y, SLICES);
+        glUniform2f(glGetUniformLocation(shader.ID, "tileSize"), static_cast<float>(width) / TILES_X,
+                    static_cast<float>(height) / TILES_Y);
+        // slice = log(depth) * scale + bias, the inverse of the slice depths in computeBounds()
+        float scale = SLICES / std::log(farPlane / nearPlane);
+        glUniform2f(glGetUniformLocation(shader.ID, "sliceScaleBias"), scale, -std::log(nearPlane) * scale);
+    }
+
+    size_t getIndexCount() const { return indices.size(); }     // light / cluster pairs this frame
+    int getMaxLightsPerCluster() const { return maxPerCluster; }
+    float getBuildMilliseconds() const { return buildMilliseconds; } // CPU time of the last build()
+
+    void del() {
+        glDeleteTextures(1, &gridTexture);
+        glDeleteTextures(1, &indexTexture);
+        glDeleteBuffers(1, &gridBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+        gridTexture = indexTexture = gridBuffer = indexBuffer = 0;
+    }
+
+private:
+    GLuint gridBuffer = 0, indexBuffer = 0, gridTexture = 0, indexTexture = 0;
+    size_t indexCapacity = 0; // in indices
+    std::vector<GLuint> grid;
+    std::vector<uint16_t> indices;
+    std::vector<std::vector<uint16_t>> lists; // per cluster, kept between frames so they stop allocating
+    int maxPerCluster = 0;
+    float buildMilliseconds = 0.0f;
+
+    // view space bounds of the clusters: x per slice and column, y per slice and row, z per slice
+    glm::mat4 lastProjection = glm::mat4(0.0f);
+    float nearPlane = 0.0f, farPlane = 0.0f;
+    float tileMinX[SLICES * TILES_X], tileMaxX[SLICES * TILES_X];
+    float tileMinY[SLICES * TILES_Y], tileMaxY[SLICES * TILES_Y];
+    float sliceMinZ[SLICES], sliceMaxZ[SLICES];
+
+    // this frame's lights in view space
+    std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+    std::vector<int> firstSlice, lastSlice;
+
+    int sliceOf(float depth) const {
+        float slice = std::log(std::max(depth, nearPlane) / nearPlane) / std::log(farPlane / nearPlane) * SLICES;
+        return std::min(SLICES - 1, std::max(0, static_cast<int>(slice)));
+    }
+
+    void computeBounds(const glm::mat4 &projection, float nearZ, float farZ) {
+        lastProjection = projection;
+        nearPlane = nearZ;
+        farPlane = farZ;
+        for (int slice = 0; slice < SLICES; ++slice) {
+            float front = nearZ * std::pow(farZ / nearZ, static_cast<float>(slice) / SLICES);
+            float back = nearZ * std::pow(farZ / nearZ, static_cast<float>(slice + 1) / SLICES);
+            sliceMinZ[slice] = -back;
+            sliceMaxZ[slice] = -front;
+
+            // a tile's side walls go through the camera, so its widest point is at the back of the slice
+            // (view x = ndc x * depth / projection[0][0], same for y)
+            for (int x = 0; x < TILES_X; ++x) {
+                float left = -1.0f + 2.0f * x / TILES_X, right = -1.0f + 2.0f * (x + 1) / TILES_X;
+                float a = left * front, b = left * back, c = right * front, d = right * back;
+                tileMinX[slice * TILES_X + x] = std::min(std::min(a, b), std::min(c, d)) / projection[0][0];
+                tileMaxX[slice * TILES_X + x] = std::max(std::max(a, b), std::max(c, d)) / projection[0][0];
+            }
+            for (int y = 0; y < TILES_Y; ++y) {
+                float bottom = -1.0f + 2.0f * y / TILES_Y, top = -1.0f + 2.0f * (y + 1) / TILES_Y;
+                float a = bottom * front, b = bottom * back, c = top * front, d = top * back;
+                tileMinY[slice * TILES_Y + y] = std::min(std::min(a, b), std::min(c, d)) / projection[1][1];
+                tileMaxY[slice * TILES_Y + y] = std::max(std::max(a, b), std::max(c, d)) / projection[1][1];
+            }
+        }
+    }
+
+    // distance from v to [min, max] on one axis, 0 inside
+    static float outside(float v, float min, float max) { return std::max(0.0f, std::max(min - v, v - max)); }
+
+    // Sphere vs cluster box for every light that reaches this slice. A row of tiles shares its y and z range, so
+    // only x differs along it: that part is done 4 tiles at a time.
+    void buildSlice(int slice) {
+        int base = slice * TILES_X * TILES_Y;
+        for (int i = 0; i < TILES_X * TILES_Y; ++i) lists[base + i].clear();
+
+        const float *minX = &tileMinX[slice * TILES_X];
+        const float *maxX = &tileMaxX[slice * TILES_X];
+        for (size_t light = 0; light < sphereX.size(); ++light) {
+            if (slice < firstSlice[light] || slice > lastSlice[light]) continue;
+            float cx = sphereX[light], cy = sphereY[light], cz = sphereZ[light];
+            float radius2 = sphereRadius[light] * sphereRadius[light];
+            float dz = outside(cz, sliceMinZ[slice], sliceMaxZ[slice]);
+
+            for (int y = 0; y < TILES_Y; ++y) {
+                float dy = outside(cy, tileMinY[slice * TILES_Y + y], tileMaxY[slice * TILES_Y + y]);
+                float rest = radius2 - dy * dy - dz * dz; // what dx^2 may still use
+                if (rest <= 0.0f) continue;
+                std::vector<uint16_t> *row = &lists[base + y * TILES_X];
+
+#if defined(__SSE2__) || defined(_M_X64)
+                __m128 centre = _mm_set1_ps(cx), limit = _mm_set1_ps(rest), zero = _mm_setzero_ps();
+                for (int x = 0; x < TILES_X; x += 4) {
+                    __m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[x]), centre),
+                                                            _mm_sub_ps(centre, _mm_loadu_ps(&maxX[x]))));
+                    int hit = _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(dx, dx), limit));
+                    for (int lane = 0; hit; ++lane, hit >>= 1) {
+                        if (hit & 1) row[x + lane].push_back(static_cast<uint16_t>(light));
+                    }
+                }
+#else
+                for (int x = 0; x < TILES_X; ++x) {
+                    float dx = outside(cx, minX[x], maxX[x]);
+                    if (dx * dx < rest) row[x].push_back(static_cast<uint16_t>(light));
+                }
+#endif
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include "shader.h"
+#include "lights.h"
+#include "meshopt.h"
+
+// Deferred shading: the boxes are drawn once into a G-buffer (what each pixel's surface looks like), then every
+// light only shades the pixels it reaches. Forward shading runs the whole light loop for every fragment of every
+// box (cost = fragments drawn x lights); here the light cost is pixels inside each light's radius, whatever the
+// boxes cost to draw.
+//
+// G-buffer (12 bytes a pixel):
+//   0: RGBA8     albedo (diffuse map) rgb, specular map intensity a
+//   1: RGB10_A2  view space normal (octahedral encoding) rg, shininess / 256 b
+//   depth: DEPTH24_STENCIL8 texture, the position is rebuilt from it
+//
+// Frame:
+//   deferred.beginGeometry();                       // G-buffer bound and cleared
+//   ... draw the boxes with deferred.getGeometryShader() (vertex.vs + gbuffer.fs) ...
+//   deferred.light(lights, view, projection, ambient, diffuse, specular); // ambient + a light volume per light
+//   ... forward drawing on top (the boxes' depth is copied into the framebuffer bound before) ...
+class Deferred {
+public:
+    // lightBuffer: PointLights::getBuffer(), read once per light volume
+    void create(int width, int height, GLuint lightBuffer) {
+        geometryShader = new Shader("asset/shaders/vertex.vs", "asset/shaders/gbuffer.fs");
+        ambientShader = new Shader("asset/shaders/fullscreen.vs", "asset/shaders/deferred_ambient.fs");
+        lightShader = new Shader("asset/shaders/deferred_light.vs", "asset/shaders/deferred_light.fs");
+        glGenVertexArrays(1, &emptyVAO);
+
+        // light volume: a -1..1 box, every face counter-clockwise seen from outside (the demo's box isn't, and
+        // the light pass culls by winding). Corner i is at x = bit 0, y = bit 1, z = bit 2.
+        std::vector<float> corners(8 * 3);
+        for (int i = 0; i < 8; ++i) {
+            corners[i * 3 + 0] = (i & 1) ? 1.0f : -1.0f;
+            corners[i * 3 + 1] = (i & 2) ? 1.0f : -1.0f;
+            corners[i * 3 + 2] = (i & 4) ? 1.0f : -1.0f;
+        }
+        std::vector<unsigned int> faces = {
+            0, 2, 3,  0, 3, 1, // back
+            4, 5, 7,  4, 7, 6, // front
+            0, 4, 6,  0, 6, 2, // left
+            1, 3, 7,  1, 7, 5, // right
+            0, 1, 5,  0, 5, 4, // bottom
+            2, 6, 7,  2, 7, 3  // top
+        };
+        MeshOptimizer::optimize(corners, 3, faces, "light volume"); // keeps every triangle's winding
+        glGenBuffers(1, &volumeVBO);
+        glGenBuffers(1, &volumeEBO);
+
+        // box corners at location 0, each light's position / radius and colour at 3 and 4 (once per instance)
+        glGenVertexArrays(1, &volumeVAO);
+        glBindVertexArray(volumeVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, volumeVBO);
+        glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(float), corners.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, volumeEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(unsigned int), faces.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, lightBuffer);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (void*)0);
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(4);
+        glVertexAttribDivisor(4, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        resize(width, height);
+    }
+
+    // Reallocates the G-buffer for a new framebuffer size
+    void resize(int newWidth, int newHeight) {
+        if (newWidth == width && newHeight == height) return;
+        release();
+        width = newWidth;
+        height = newHeight;
+
+        glGenTextures(1, &albedoSpecular);
+        glGenTextures(1, &normalShininess);
+        glGenTextures(1, &depth);
+        allocate(albedoSpecular, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        allocate(normalShininess, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV);
+        allocate(depth, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoSpecular, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalShininess, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+        GLenum buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, buffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "G-buffer " << width << "x" << height << " incomplete!\n";
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Shader for the geometry pass: same uniforms as fragment.fs's material, nothing about lights
+    Shader &getGeometryShader() { return *geometryShader; }
+
+    // Binds and clears the G-buffer (restore the output framebuffer before drawing anything else: light() does)
+    void beginGeometry() {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, width, height);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // Lights the G-buffer into the framebuffer that was bound at beginGeometry() (its colour is kept where there are
+    // no boxes, its depth becomes the boxes' depth). `ambient`, `diffuse`, `specular`: like fragment.fs's light.
+    void light(const PointLights &lights, const glm::mat4 &view, const glm::mat4 &projection,
+               const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular) {
+        // the boxes' depth goes into the output, so light volumes (and forward drawing after) are depth tested
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(output));
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(output));
+        glViewport(0, 0, width, height);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, albedoSpecular);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, normalShininess);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, depth);
+        glDepthMask(GL_FALSE);
+
+        // ambient: every box pixel once (full-screen triangle, pixels without a box are skipped)
+        glDisable(GL_DEPTH_TEST);
+        ambientShader->use();
+        ambientShader->setInt("gAlbedoSpecular", 0);
+        ambientShader->setInt("gDepth", 2);
+        ambientShader->setVec3("ambient", ambient);
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // one box around each light, added on top. Only the back faces are drawn, and only where a surface is in
+        // front of them (depth GEQUAL): pixels behind the light's reach are never shaded, and it still works with
+        // the camera inside the box.
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GEQUAL);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        lightShader->use();
+        lightShader->setInt("gAlbedoSpecular", 0);
+        lightShader->setInt("gNormalShininess", 1);
+        lightShader->setInt("gDepth", 2);
+        lightShader->setMat4("view", view);
+        lightShader->setMat4("projection", projection);
+        lightShader->setMat4("inverseProjection", glm::inverse(projection));
+        glUniform2f(glGetUniformLocation(lightShader->ID, "screenSize"), static_cast<float>(width), static_cast<float>(height));
+        lightShader->setVec3("light.diffuse", diffuse);
+        lightShader->setVec3("light.specular", specular);
+        glBindVertexArray(volumeVAO);
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, lights.getCount());
+
+        // back to the state the forward drawing expects
+        glDisable(GL_BLEND);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glBindVertexArray(0);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getBytes() const { return static_cast<size_t>(width) * height * 12; }
+
+    void del() {
+        release();
+        glDeleteVertexArrays(1, &volumeVAO);
+        glDeleteVertexArrays(1, &emptyVAO);
+        glDeleteBuffers(1, &volumeVBO);
+        glDeleteBuffers(1, &volumeEBO);
+        volumeVAO = emptyVAO = volumeVBO = volumeEBO = 0;
+        for (Shader **shader : {&geometryShader, &ambientShader, &lightShader}) {
+            if (!*shader) continue;
+            glDeleteProgram((*shader)->ID);
+            delete *shader;
+            *shader = nullptr;
+        }
+    }
+
+private:
+    Shader *geometryShader = nullptr, *ambientShader = nullptr, *lightShader = nullptr;
+    GLuint FBO = 0, albedoSpecular = 0, normalShininess = 0, depth = 0;
+    GLuint volumeVAO = 0, volumeVBO = 0, volumeEBO = 0, emptyVAO = 0;
+    int width = 0, height = 0;
+    GLint output = 0; // framebuffer bound before the geometry pass, lit into by light()
+
+    void allocate(GLuint texture, GLenum internalFormat, GLenum format, GLenum type) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void release() {
+        if (!FBO) return;
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteTextures(1, &albedoSpecular);
+        glDeleteTextures(1, &normalShininess);
+        glDeleteTextures(1, &depth);
+        FBO = albedoSpecular = normalShininess = depth = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef LIGHTS_H
+#define LIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// A point light: lights everything closer than `radius`, fading out to nothing at the radius
+struct PointLight {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 colour;
+    float unused = 0.0f; // keeps every light at 2 vec4s in the GPU buffer
+};
+
+// The scene's point lights, and one GL buffer with all of them (2 vec4s each: position + radius, colour).
+// The same buffer is read two ways: as a texture buffer by the forward shader (loops over every light) and
+// as per-instance attributes by the deferred light volumes (one instance per light).
+//
+// Light 0 and 1 are the two animated lights (Camera::movelight / movelight2), the rest orbit around the boxes
+// (same seed = same lights every run).
+class PointLights {
+public:
+    static constexpr int MAX_LIGHTS = 4096;
+
+    void create() {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, MAX_LIGHTS * sizeof(PointLight), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Number of lights (1 to MAX_LIGHTS): the extra orbits are made here, their positions in update()
+    void setCount(int count, unsigned int seed = 7u) {
+        count = std::max(1, std::min(MAX_LIGHTS, count));
+        lights.assign(count, PointLight());
+        orbits.assign(count, Orbit());
+
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (int i = 2; i < count; ++i) {
+            Orbit &orbit = orbits[i];
+            orbit.centre = glm::vec3(-4.0f + 9.0f * unit(random), -3.5f + 8.0f * unit(random), -4.5f + 8.0f * unit(random));
+            orbit.distance = 0.5f + 1.5f * unit(random);
+            orbit.speed = (0.3f + 1.2f * unit(random)) * (unit(random) < 0.5f ? -1.0f : 1.0f);
+            orbit.phase = 6.2831853f * unit(random);
+            glm::vec3 colour(unit(random), unit(random), unit(random));
+            lights[i].colour = colour / std::max(colour.r, std::max(colour.g, colour.b)); // saturated, brightest channel = 1
+            lights[i].radius = EXTRA_RADIUS;
+        }
+    }
+
+    // Positions at `time`; the two main lights come from the camera's light animation
+    void update(float time, const glm::vec3 &mainLight, const glm::vec3 &secondLight) {
+        for (size_t i = 0; i < lights.size(); ++i) {
+            if (i < 2) {
+                lights[i].position = i == 0 ? mainLight : secondLight;
+                lights[i].radius = MAIN_RADIUS;
+                lights[i].colour = glm::vec3(1.0f);
+                continue;
+            }
+            const Orbit &orbit = orbits[i];
+            float angle = orbit.phase + orbit.speed * time;
+            lights[i].position = orbit.centre + glm::vec3(std::cos(angle), 0.4f * std::sin(angle * 1.7f), std::sin(angle)) * orbit.distance;
+        }
+    }
+
+    // Copies the lights into the GL buffer (a new buffer every frame, so this never waits for the last frame's draws)
+    void upload() {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, MAX_LIGHTS * sizeof(PointLight), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, lights.size() * sizeof(PointLight), lights.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    int getCount() const { return static_cast<int>(lights.size()); }
+    const std::vector<PointLight> &get() const { return lights; }
+    GLuint getBuffer() const { return buffer; }
+    GLuint getTexture() const { return texture; } // GL_TEXTURE_BUFFER, 2 RGBA32F texels per light
+
+    void del() {
+        glDeleteTextures(1, &texture);
+        glDeleteBuffers(1, &buffer);
+        texture = buffer = 0;
+    }
+
+private:
+    static constexpr float MAIN_RADIUS = 15.0f;  // the two main lights reach the whole scene
+    static constexpr float EXTRA_RADIUS = 2.5f;
+
+    struct Orbit {
+        glm::vec3 centre = glm::vec3(0.0f);
+        float distance = 0.0f, speed = 0.0f, phase = 0.0f;
+    };
+
+    std::vector<PointLight> lights;
+    std::vector<Orbit> orbits;
+    GLuint buffer = 0, texture = 0;
+};
+
+#endif
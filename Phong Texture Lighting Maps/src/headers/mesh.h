@@ -4,6 +4,11 @@
 #include "config.h"
 #include "shader.h"
 #include "camera.h"
+#include "lights.h"
+#include "deferred.h"
+#include "clusters.h"
+#include "jobs.h"
+#include "meshopt.h"
 #include <math.h>
 void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
                float* vertices, size_t size, unsigned int* indices, size_t indexSize, unsigned int &lightVAO);
@@ -43,6 +48,17 @@ void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
     return textureID;
 }
 
+// How the boxes are lit (R in the demo switches between them)
+enum class Shading {
+    Forward,   // every box fragment loops over every light
+    Clustered, // every box fragment loops over the lights of its cluster (clusters.h)
+    Deferred   // G-buffer, then a light volume per light (deferred.h)
+};
+
+inline const char *shadingName(Shading shading) {
+    return shading == Shading::Forward ? "forward" : shading == Shading::Clustered ? "clustered" : "deferred";
+}
+
 class Tri {
 private:
     unsigned int VBO, VAO, EBO, lightVAO;
@@ -50,6 +66,13 @@ private:
     float cameraAngle = 0.0f;     // Which direction around the triangle
     float deltaTime = 0.0f;	// time between current frame and last frame
     float lastFrame = 0.0f;
+    int width = 1200, height = 800; // framebuffer size
+    std::vector<glm::vec3> cubePositions; // diff locations
+    PointLights lights;   // the two moving lights and any extra ones
+    Deferred deferred;    // G-buffer and light volumes
+    LightClusters clusters; // lights per cluster, for clustered shading
+    JobSystem jobs;       // builds the clusters on every core
+    Shading shading = Shading::Deferred;
 
 public:
     // Set up texture:
@@ -113,64 +136,137 @@ public:
             20,21,22, 22,23,20
         };
 
-        setupMesh(VAO, VBO, EBO, vertices, sizeof(vertices), indices, sizeof(indices), lightVAO); 
+        // vertex cache, overdraw and fetch order (prints ACMR / ATVR before and after)
+        std::vector<float> boxVertices(vertices, vertices + sizeof(vertices) / sizeof(float));
+        std::vector<unsigned int> boxIndices(indices, indices + sizeof(indices) / sizeof(unsigned int));
+        MeshOptimizer::optimize(boxVertices, 8, boxIndices, "box");
+
+        setupMesh(VAO, VBO, EBO, boxVertices.data(), boxVertices.size() * sizeof(float),
+                  boxIndices.data(), boxIndices.size() * sizeof(unsigned int), lightVAO);
+
+        setBoxCount(5);
+        lights.create();
+        lights.setCount(2); // the two moving lights
+        deferred.create(width, height, lights.getBuffer());
+        clusters.create();
 }
 
-    void draw(Shader &light, Shader &shader, Camera &camera) { 
+    // Framebuffer size (aspect ratio, G-buffer size)
+    void setViewport(int newWidth, int newHeight) {
+        if (newWidth <= 0 || newHeight <= 0) return; // minimised
+        width = newWidth;
+        height = newHeight;
+        deferred.resize(width, height);
+    }
 
-        // Light source starting positions
-        glm::vec3 lightPos(1.2f, 1.0f, -2.0f);
-        glm::vec3 lightPos2(-10.0f, 1.0f, 2.0f);
+    // Forward, clustered or deferred shading
+    void setShading(Shading newShading) { shading = newShading; }
+    Shading getShading() const { return shading; }
 
-        // enable this to move sunlight over time
-        camera.movelight(lightPos); 
-        camera.movelight2(lightPos2);
-        glm::mat4 view = camera.GetViewMatrix(); // initlize
-        glm::mat4 projection = camera.GetProjectionMatrix(1200.0f / 800.0f);
-   
-        glm::vec3 cubePositions[] = { // diff locations
+    // 1 = only the first moving light, 2 = both, more = extra lights orbiting the boxes
+    void setLightCount(int count) { lights.setCount(count); }
+    int getLightCount() const { return lights.getCount(); }
+
+    // The 5 boxes of the demo, then more in a seeded random cloud around them (for benchmarks)
+    void setBoxCount(int count, unsigned int seed = 11u) {
+        cubePositions = {
             glm::vec3( 0.0f,  0.0f,  0.0f),
             glm::vec3( 1.5f, -2.2f, -2.5f),
             glm::vec3( -1.7f, 2.0f, 2.0f),
             glm::vec3( 2.5f,  1.2f, 1.5f),
             glm::vec3(3.4f,  3.0f, -1.5f)
         };
+        cubePositions.resize(std::max(1, count));
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (size_t i = 5; i < cubePositions.size(); ++i) {
+            cubePositions[i] = glm::vec3(-4.0f + 9.0f * unit(random), -3.5f + 8.0f * unit(random), -4.5f + 8.0f * unit(random));
+        }
+    }
+    int getBoxCount() const { return static_cast<int>(cubePositions.size()); }
+
+    const Deferred &getDeferred() const { return deferred; }
+    const LightClusters &getClusters() const { return clusters; }
+
+    void draw(Shader &light, Shader &shader, Camera &camera) { 
+        render(light, shader, camera, glfwGetTime());
+    }
+
+    // Draws the frame at `time` seconds (lights and animation only depend on it)
+    void render(Shader &light, Shader &shader, Camera &camera, float time) {
+        // Light source starting positions
+        glm::vec3 lightPos(1.2f, 1.0f, -2.0f);
+        glm::vec3 lightPos2(-10.0f, 1.0f, 2.0f);
+
+        // enable this to move sunlight over time
+        camera.movelight(lightPos, time); 
+        camera.movelight2(lightPos2, time);
+        lights.update(time, lightPos, lightPos2);
+        lights.upload();
+        glm::mat4 view = camera.GetViewMatrix(); // initlize
+        const float nearPlane = 0.1f, farPlane = 100.0f;
+        glm::mat4 projection = camera.GetProjectionMatrix(static_cast<float>(width) / static_cast<float>(height), nearPlane, farPlane);
+
+        // light structure 
+        glm::vec3 ambient(0.2f, 0.2f, 0.2f);
+        glm::vec3 diffuse(0.5f, 0.5f, 0.5f);
+        glm::vec3 specular(1.5f, 1.5f, 1.5f);
 
         // Draw the main colored object FIRST
+        // deferred: only what the surface looks like goes into the G-buffer, the lights come after
+        bool deferredShading = shading == Shading::Deferred;
+        Shader &boxShader = deferredShading ? deferred.getGeometryShader() : shader;
+        if (deferredShading) deferred.beginGeometry();
+
         // define shine output and reflection output
-        shader.use();  // Use the main shader for colored object
+        boxShader.use();  // Use the main shader for colored object
          // texture
-        shader.setInt("material.diffuse", 0); // texture
-        shader.setInt("material.specular", 1);
-        shader.setFloat("material.shininess", 64.0f); // higher = sharper shine spot
-
-        shader.setVec3("viewPos", camera.Position); // view position (specular)
-        shader.setVec3("light.position", lightPos);
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-   
-        // light structure 
-        shader.setVec3("light.ambient", 0.2f, 0.2f, 0.2f); 
-        shader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
-        shader.setVec3("light.specular", 1.5f, 1.5f, 1.5f);
+        boxShader.setInt("material.diffuse", 0); // texture
+        boxShader.setInt("material.specular", 1);
+        boxShader.setFloat("material.shininess", 64.0f); // higher = sharper shine spot
+        boxShader.setMat4("view", view);
+        boxShader.setMat4("projection", projection);
+
+        if (!deferredShading) {
+            boxShader.setVec3("viewPos", camera.Position); // view position (specular)
+            boxShader.setVec3("light.ambient", ambient); 
+            boxShader.setVec3("light.diffuse", diffuse);
+            boxShader.setVec3("light.specular", specular);
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_BUFFER, lights.getTexture());
+            boxShader.setInt("lights", 2);
+            boxShader.setInt("lightCount", lights.getCount());
+            boxShader.setInt("clustered", shading == Shading::Clustered);
+            // the cluster buffers always get their own units: samplers of different types can't share one
+            boxShader.setInt("clusterGrid", 3);
+            boxShader.setInt("clusterLights", 4);
+            if (shading == Shading::Clustered) {
+                clusters.build(lights, view, projection, nearPlane, farPlane, jobs);
+                clusters.upload();
+                clusters.bind(boxShader, 3, 4, width, height);
+            }
+        }
+
+        // Texture:
+        glActiveTexture(GL_TEXTURE0); 
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1); 
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+        glBindVertexArray(VAO);
 
         //draw single model:
-        for (unsigned i = 0; i < 5; i ++) {
+        for (const glm::vec3 &position : cubePositions) {
             glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            float angle = glfwGetTime() * 20.0f + 25.0f; // rotate over time
+            model = glm::translate(model, position);
             //model = glm::rotate(model, glm::radians(angle), lightPos);
-            shader.setMat4("model",model);
-            // Texture:
-            glActiveTexture(GL_TEXTURE0); 
-            glBindTexture(GL_TEXTURE_2D, diffuseMap);
-            glActiveTexture(GL_TEXTURE1); 
-            glBindTexture(GL_TEXTURE_2D, specularMap);
-
-            glBindVertexArray(VAO);
+            boxShader.setMat4("model",model);
             glDrawElements(GL_TRIANGLES,36, GL_UNSIGNED_INT, 0);
         }
 
+        if (deferredShading) {
+            deferred.light(lights, view, projection, ambient, diffuse, specular);
+        }
+
         // Draw light cube SECOND
         light.use();   // Use the light shader for light source
         light.setMat4("view", view);
@@ -184,6 +280,7 @@ public:
         glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
 
         // second light source
+        if (lights.getCount() < 2) return;
         model = glm::mat4(1.0f);
         model = glm::translate(model, lightPos2);
         model = glm::scale(model, glm::vec3(1.1f)); // smaller cube
@@ -197,6 +294,9 @@ public:
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
         glDeleteVertexArrays(1, &lightVAO);
+        lights.del();
+        deferred.del();
+        clusters.del();
     }
 };
 
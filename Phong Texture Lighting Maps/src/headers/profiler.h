@@ -0,0 +1,244 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// CPU zone profiler with Chrome trace export (open the file in chrome://tracing or ui.perfetto.dev).
+//
+// Only compiled in with -DPROFILE. Without it every macro below expands to nothing, so zones cost nothing.
+//
+//   void loadStuff() {
+//       PROFILE_ZONE("loadStuff");     // measures until the end of the enclosing block
+//       ...
+//   }
+//   PROFILE_THREAD("render");          // names the calling thread in the trace
+//   PROFILE_DUMP("trace.json");        // writes everything recorded so far
+//
+// Each thread writes its zones into its own chunked buffer, so recording never takes a lock:
+// one timestamp at the start, one at the end and a 24 byte store. Timestamps come from the CPU's time stamp
+// counter (rdtsc) on x86 and steady_clock elsewhere. A dump may run while other threads keep recording;
+// it only reads zones that were completely written.
+// Each thread keeps at most MAX_CHUNKS * CHUNK zones, later ones are dropped and counted.
+// Most of a zone's cost is the two clock reads (rdtsc is a few ns on bare metal, slower in some VMs).
+
+#ifdef PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) CpuZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) CpuProfiler::setThreadName(name)
+#define PROFILE_DUMP(path) CpuProfiler::writeChromeTrace(path)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_DUMP(path) ((void)0)
+#endif
+
+#ifdef PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILE_RDTSC 1
+#endif
+
+class CpuProfiler {
+public:
+    static const size_t CHUNK = 4096;     // zones per chunk
+    static const size_t MAX_CHUNKS = 256; // per thread (about 1M zones, 24 MB)
+    static const size_t PREALLOCATED = 16; // chunks allocated (and touched) when a thread records its first zone
+
+    // Raw timestamp: TSC ticks or steady_clock nanoseconds
+    static uint64_t now() {
+#ifdef PROFILE_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // `name` must stay valid until the dump (string literals)
+    static void record(const char *name, uint64_t begin, uint64_t end) {
+        ThreadBuffer *buffer = threadBuffer();
+        Chunk *chunk = buffer->tail;
+        size_t count = chunk->count.load(std::memory_order_relaxed);
+        if (count == CHUNK) {
+            chunk = buffer->grow();
+            if (!chunk) {
+                ++buffer->dropped;
+                return;
+            }
+            count = 0;
+        }
+        Zone &zone = chunk->zones[count];
+        zone.name = name;
+        zone.begin = begin;
+        zone.end = end;
+        chunk->count.store(count + 1, std::memory_order_release); // the dump may read it now
+    }
+
+    static void setThreadName(const std::string &name) {
+        ThreadBuffer *buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffer->name = name;
+    }
+
+    // Writes every zone recorded so far as Chrome trace JSON. Returns false if the file can't be written.
+    static bool writeChromeTrace(const std::string &path) {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "Profiler: cannot write " << path << "\n";
+            return false;
+        }
+
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        double usPerTick = microsecondsPerTick(reg);
+        size_t zones = 0, dropped = 0;
+
+        // trace time 0 = the earliest zone (the first one started before the registry existed)
+        uint64_t origin = reg.originTicks;
+        for (const std::unique_ptr<ThreadBuffer> &buffer : reg.threads) {
+            size_t chunkCount = buffer->chunkCount.load(std::memory_order_acquire);
+            for (size_t c = 0; c < chunkCount; ++c) {
+                const Chunk &chunk = *buffer->chunks[c];
+                size_t count = chunk.count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i) {
+                    if (chunk.zones[i].begin < origin) origin = chunk.zones[i].begin;
+                }
+            }
+        }
+
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        const char *separator = "";
+        for (size_t t = 0; t < reg.threads.size(); ++t) {
+            ThreadBuffer &buffer = *reg.threads[t];
+            out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t
+                << ", \"args\": {\"name\": \"" << buffer.name << "\"}}";
+            separator = ",\n";
+
+            size_t chunkCount = buffer.chunkCount.load(std::memory_order_acquire);
+            for (size_t c = 0; c < chunkCount; ++c) {
+                const Chunk &chunk = *buffer.chunks[c];
+                size_t count = chunk.count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i) {
+                    const Zone &zone = chunk.zones[i];
+                    out << ",\n{\"name\": \"" << zone.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << t
+                        << ", \"ts\": " << static_cast<double>(zone.begin - origin) * usPerTick
+                        << ", \"dur\": " << static_cast<double>(zone.end - zone.begin) * usPerTick << "}";
+                }
+                zones += count;
+            }
+            dropped += buffer.dropped.load(std::memory_order_relaxed);
+        }
+        out << "\n]}\n";
+
+        std::cout << "Profiler: " << zones << " zones from " << reg.threads.size() << " threads written to " << path;
+        if (dropped) std::cout << " (" << dropped << " dropped, buffers full)";
+        std::cout << "\n";
+        return true;
+    }
+
+private:
+    struct Zone {
+        const char *name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    struct Chunk {
+        Zone zones[CHUNK];
+        std::atomic<size_t> count{0};
+    };
+
+    struct ThreadBuffer {
+        std::string name;                           // guarded by the registry mutex
+        std::unique_ptr<Chunk> chunks[MAX_CHUNKS];  // written by the owning thread only
+        std::atomic<size_t> chunkCount{0};          // chunks in use (visible to the dump)
+        size_t allocated = 0;
+        Chunk *tail = nullptr;
+        std::atomic<size_t> dropped{0};
+
+        // Fresh memory page-faults on first write, which would cost more than the zone itself,
+        // so the first chunks are allocated and zeroed up front
+        void preallocate(size_t count) {
+            for (; allocated < count && allocated < MAX_CHUNKS; ++allocated) chunks[allocated].reset(new Chunk());
+        }
+
+        Chunk *grow() {
+            size_t count = chunkCount.load(std::memory_order_relaxed);
+            if (count == MAX_CHUNKS) return nullptr;
+            preallocate(count + 1);
+            tail = chunks[count].get();
+            chunkCount.store(count + 1, std::memory_order_release);
+            return tail;
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> threads; // kept after a thread exits, so its zones still get dumped
+        uint64_t originTicks = now();                       // clock rate reference
+        std::chrono::steady_clock::time_point originTime = std::chrono::steady_clock::now();
+    };
+
+    static Registry &registry() {
+        static Registry reg;
+        return reg;
+    }
+
+    static ThreadBuffer *threadBuffer() {
+        static thread_local ThreadBuffer *buffer = nullptr;
+        if (!buffer) buffer = addThread();
+        return buffer;
+    }
+
+    static ThreadBuffer *addThread() {
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+        buffer->preallocate(PREALLOCATED);
+        buffer->grow();
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffer->name = reg.threads.empty() ? "main" : "thread " + std::to_string(reg.threads.size());
+        reg.threads.push_back(std::move(buffer));
+        return reg.threads.back().get();
+    }
+
+    // TSC rate measured against steady_clock over the whole run (no calibration pause at startup)
+    static double microsecondsPerTick(const Registry &reg) {
+#ifdef PROFILE_RDTSC
+        uint64_t ticks = now() - reg.originTicks;
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - reg.originTime).count();
+        return ticks > 0 ? us / static_cast<double>(ticks) : 0.0;
+#else
+        (void)reg;
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::duration(1)).count();
+#endif
+    }
+};
+
+// Measures from construction to the end of the enclosing block (use PROFILE_ZONE)
+struct CpuZone {
+    const char *name;
+    uint64_t begin;
+
+    explicit CpuZone(const char *zoneName) : name(zoneName), begin(CpuProfiler::now()) {}
+    ~CpuZone() { CpuProfiler::record(name, begin, CpuProfiler::now()); }
+
+    CpuZone(const CpuZone &) = delete;
+    CpuZone &operator=(const CpuZone &) = delete;
+};
+
+#endif // PROFILE
+
+#endif
@@ -14,11 +14,29 @@ Camera camera;
 
 GLfloat deltaTime = 0.0f;
 GLfloat lastTime = 0.0f;
+bool lastKeys[1024] = {}; // keys held last frame (R / L act once per press)
 
 // User input
-void userinput() {
-        camera.keyControl(mainWindow.getsKeys(), deltaTime); // getKeys() returns bool keys[1024];
+void userinput(Tri &tri) {
+        bool *keys = mainWindow.getsKeys();
+        camera.keyControl(keys, deltaTime); // getKeys() returns bool keys[1024];
         camera.mouseControl(mainWindow.getXChange(), mainWindow.getYChange());
+
+        // R: next shading (deferred -> forward -> clustered -> deferred)
+        if (keys[GLFW_KEY_R] && !lastKeys[GLFW_KEY_R]) {
+            Shading shading = tri.getShading();
+            tri.setShading(shading == Shading::Deferred ? Shading::Forward :
+                           shading == Shading::Forward ? Shading::Clustered : Shading::Deferred);
+            std::cout << shadingName(tri.getShading()) << " shading, " << tri.getLightCount() << " lights\n";
+        }
+
+        // L: next light count (2 -> 16 -> 256 -> 1024 -> 1 -> 2)
+        if (keys[GLFW_KEY_L] && !lastKeys[GLFW_KEY_L]) {
+            int count = tri.getLightCount();
+            tri.setLightCount(count == 1 ? 2 : count == 2 ? 16 : count == 16 ? 256 : count == 256 ? 1024 : 1);
+            std::cout << tri.getLightCount() << " lights\n";
+        }
+        std::copy(keys, keys + 1024, lastKeys);
 }
 
 int main() {
@@ -30,6 +48,7 @@ int main() {
 
     // 2. Create objects and shaders
     Tri tri;
+    tri.setViewport(mainWindow.getBufferWidth(), mainWindow.getBufferHeight());
     Shader shader("asset/shaders/vertex.vs","asset/shaders/fragment.fs");
     Shader light("asset/shaders/lightver.vs","asset/shaders/lightfrag.fs");
 
@@ -47,7 +66,7 @@ int main() {
         glfwPollEvents();  // call this first before userinput();
 
         // read / process each user inputs
-        userinput(); 
+        userinput(tri); 
 
         // Set background clear color
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f); 
@@ -5,6 +5,7 @@
 #include "config.h"
 #include "shader.h"
 #include "camera.h"
+#include "meshopt.h"
 #include <math.h>
 
 void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
@@ -75,7 +76,13 @@ public:
             20,21,22, 22,23,20
         };
         
-        setupMesh(TVAO, TVBO, EBO, vertices, sizeof(vertices), indices, sizeof(indices), lightVAO); 
+        // vertex cache, overdraw and fetch order (prints ACMR / ATVR before and after)
+        std::vector<float> cubeVertices(vertices, vertices + sizeof(vertices) / sizeof(float));
+        std::vector<unsigned int> cubeIndices(indices, indices + sizeof(indices) / sizeof(unsigned int));
+        MeshOptimizer::optimize(cubeVertices, 6, cubeIndices, "cube");
+
+        setupMesh(TVAO, TVBO, EBO, cubeVertices.data(), cubeVertices.size() * sizeof(float),
+                  cubeIndices.data(), cubeIndices.size() * sizeof(unsigned int), lightVAO); 
 }
 
     void draw(Shader &light, Shader &shader, Camera &camera) { 
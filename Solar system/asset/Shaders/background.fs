@@ -1,9 +0,0 @@
-#version 330 core
-out vec4 FragColor;
-in vec2 TexCoords;
-
-uniform sampler2D background;
-
-void main() {
-    FragColor = texture(background, TexCoords);
-}
\ No newline at end of file
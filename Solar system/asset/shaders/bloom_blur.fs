@@ -0,0 +1,25 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+uniform vec2 usedSize;   // part of the texture in use (0..1)
+uniform vec2 texelSize;  // 1 / texture size
+uniform vec2 direction;  // (1, 0) = horizontal, (0, 1) = vertical
+
+// 9-tap gaussian as 5 bilinear taps (weights and offsets merged in pairs)
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+
+void main() {
+    vec2 low = texelSize * 0.5, high = usedSize - texelSize * 0.5; // don't sample the unused rest of the texture
+    vec2 uv = TexCoords * usedSize;
+    vec3 sum = texture(image, clamp(uv, low, high)).rgb * weights[0];
+    for (int i = 1; i < 3; ++i) {
+        vec2 step = direction * texelSize * offsets[i];
+        sum += texture(image, clamp(uv + step, low, high)).rgb * weights[i];
+        sum += texture(image, clamp(uv - step, low, high)).rgb * weights[i];
+    }
+    FragColor = vec4(sum, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D scene;
+uniform vec2 usedSize;   // part of the texture the scene was drawn into (0..1)
+uniform vec2 texelSize;  // 1 / texture size
+uniform float threshold; // brightness where the glow starts
+
+void main() {
+    // drawn at half resolution: the 4 scene pixels under this one, averaged by one bilinear tap
+    vec2 uv = clamp(TexCoords * usedSize, texelSize, usedSize - texelSize);
+    vec3 colour = texture(scene, uv).rgb;
+
+    // only what is brighter than the threshold glows (soft start, so the edge doesn't pop)
+    float brightness = max(colour.r, max(colour.g, colour.b));
+    float amount = clamp((brightness - threshold) / max(1.0 - threshold, 0.001), 0.0, 1.0);
+    FragColor = vec4(colour * amount * amount, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D glow;
+uniform vec2 usedSize;   // part of the texture in use (0..1)
+uniform vec2 texelSize;  // 1 / texture size
+uniform float intensity;
+
+void main() {
+    // added on top of the scene (blending GL_ONE, GL_ONE)
+    vec2 uv = clamp(TexCoords * usedSize, texelSize * 0.5, usedSize - texelSize * 0.5);
+    FragColor = vec4(texture(glow, uv).rgb * intensity, 1.0);
+}
@@ -5,7 +5,12 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
 
-uniform vec3 viewPos;
+// Camera matrices, written once per frame by CameraBuffer (and overwritten just before submit in late-latch mode)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // xyz = camera position
+};
 uniform vec3 lightPos;
 
 struct Material {
@@ -38,7 +43,7 @@ void main() {
     vec3 diffuse = light.diffuse * diff * diffuseColor;
     
     // Specular lighting (Phong)
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     vec3 specular = light.specular * spec * specularColor;
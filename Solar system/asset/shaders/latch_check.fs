@@ -0,0 +1,7 @@
+#version 330 core
+flat in float Value;
+out float FragValue;
+
+void main() {
+    FragValue = Value;
+}
@@ -0,0 +1,15 @@
+#version 330 core
+// Late-latch self check (CameraBuffer::verifyLateLatch): one point in the middle of a 1x1 target
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+flat out float Value;
+
+void main() {
+    Value = view[0][0];
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+    gl_PointSize = 1.0;
+}
@@ -4,8 +4,12 @@ layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Camera matrices, written once per frame by CameraBuffer (and overwritten just before submit in late-latch mode)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // xyz = camera position
+};
 
 void main() {
     TexCoords = aTexCoords;
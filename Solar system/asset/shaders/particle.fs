@@ -0,0 +1,10 @@
+#version 330 core
+out vec4 FragColor;
+in vec4 Color;
+
+void main() {
+    // round soft sprite, drawn with additive blending
+    vec2 d = gl_PointCoord * 2.0 - 1.0;
+    float falloff = max(1.0 - dot(d, d), 0.0);
+    FragColor = vec4(Color.rgb * Color.a * falloff, 1.0);
+}
@@ -0,0 +1,41 @@
+#version 330 core
+layout (location = 0) in vec4 aPositionAge;  // xyz = position, w = age
+layout (location = 1) in vec4 aVelocityLife; // xyz = velocity, w = lifetime
+
+out vec4 Color;
+
+// Camera matrices, written once per frame by CameraBuffer (and overwritten just before submit in late-latch mode)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // xyz = camera position
+};
+uniform float pointScale; // sprite size in pixels at 1 unit away
+uniform float intensity;
+
+void main() {
+    float age = aPositionAge.w;
+    float life = aVelocityLife.w;
+
+    // not born yet / dead (transform feedback path keeps them in the pool): move outside clip space
+    if (age < 0.0 || age >= life) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        gl_PointSize = 0.0;
+        Color = vec4(0.0);
+        return;
+    }
+
+    vec4 viewPos = view * vec4(aPositionAge.xyz, 1.0);
+    gl_Position = projection * viewPos;
+    float size = pointScale / max(-viewPos.z, 0.1);
+    gl_PointSize = clamp(size, 1.0, 16.0);
+
+    // slow corona particles glow orange, fast solar wind is pale yellow; fade in quickly and out slowly
+    float t = age / life;
+    float speed = length(aVelocityLife.xyz);
+    Color.rgb = mix(vec3(1.0, 0.55, 0.15), vec3(1.0, 0.9, 0.6), smoothstep(8.0, 20.0, speed));
+    Color.a = intensity * (1.0 - t) * smoothstep(0.0, 0.1, t);
+    // sprites smaller than a pixel still cover a whole one, so dim them to their real area
+    // (keeps the glow equally bright at any resolution, see dynamic resolution)
+    Color.a *= min(size * size, 1.0);
+}
@@ -0,0 +1,89 @@
+#version 430 core
+// Compute particle update (OpenGL 4.3 path).
+// Reads the living particles of the source buffer, writes the survivors plus this frame's new particles
+// compacted into the destination buffer. The destination count is built with an atomic counter that sits
+// inside the indirect draw command, so the draw call never needs the count on the CPU.
+layout (local_size_x = 256) in;
+
+struct Particle {
+    vec4 positionAge;  // xyz = position, w = age in seconds
+    vec4 velocityLife; // xyz = velocity, w = lifetime in seconds
+};
+
+layout (std430, binding = 0) readonly buffer Source { Particle source[]; };
+layout (std430, binding = 1) writeonly buffer Destination { Particle destination[]; };
+
+// DrawArraysIndirectCommand { count, instanceCount, first, baseInstance }
+layout (std430, binding = 2) readonly buffer SourceCommand { uint sourceCount; uint sourceRest[3]; };
+layout (std430, binding = 3) buffer DestinationCommand { uint destinationCount; uint destinationRest[3]; };
+
+uniform uint capacity;
+uniform uint emitCount;     // new particles this frame
+uniform float deltaTime;
+uniform int seed;           // changes every frame
+uniform vec3 sunCenter;
+uniform float sunRadius;
+uniform float gravity;      // acceleration at the sun's surface
+uniform float windFraction; // share of particles that escape as solar wind
+
+float hash(uint n) {
+    n = (n << 13u) ^ n;
+    n = n * (n * n * 15731u + 789221u) + 1376312589u;
+    return float(n & 0x7fffffffu) / float(0x7fffffff);
+}
+
+vec3 randomDirection(uint n) {
+    float z = hash(n) * 2.0 - 1.0;
+    float a = hash(n + 1u) * 6.2831853;
+    float r = sqrt(max(1.0 - z * z, 0.0));
+    return vec3(r * cos(a), z, r * sin(a));
+}
+
+// Corona particles leave slowly and fall back in loops, solar wind particles are fast enough to escape
+Particle spawn(uint n) {
+    vec3 dir = randomDirection(n);
+    vec3 velocity;
+    float life;
+    if (hash(n + 2u) < windFraction) {
+        velocity = dir * mix(20.0, 40.0, hash(n + 3u));
+        life = mix(4.0, 8.0, hash(n + 4u));
+    } else {
+        vec3 tangent = normalize(cross(dir, randomDirection(n + 5u)) + vec3(1e-4));
+        velocity = dir * mix(4.0, 9.0, hash(n + 3u)) + tangent * 3.0 * hash(n + 6u);
+        life = mix(0.8, 2.5, hash(n + 4u));
+    }
+    Particle p;
+    p.positionAge = vec4(sunCenter + dir * sunRadius * 1.01, 0.0);
+    p.velocityLife = vec4(velocity, life);
+    return p;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    uint alive = min(sourceCount, capacity);
+    Particle p;
+
+    if (i < alive) {
+        p = source[i];
+        p.positionAge.w += deltaTime;
+        if (p.positionAge.w >= p.velocityLife.w) {
+            return; // died of old age
+        }
+
+        // sun gravity, then move (semi-implicit Euler)
+        vec3 r = p.positionAge.xyz - sunCenter;
+        float distance2 = max(dot(r, r), sunRadius * sunRadius);
+        p.velocityLife.xyz -= normalize(r) * gravity * sunRadius * sunRadius / distance2 * deltaTime;
+        p.positionAge.xyz += p.velocityLife.xyz * deltaTime;
+
+        if (length(p.positionAge.xyz - sunCenter) < sunRadius) {
+            return; // fell back into the sun
+        }
+    } else if (i < min(alive + emitCount, capacity)) {
+        p = spawn(i * 747796405u + uint(seed) * 2891336453u);
+    } else {
+        return;
+    }
+
+    destination[atomicAdd(destinationCount, 1u)] = p;
+}
@@ -0,0 +1,70 @@
+#version 330 core
+// Transform feedback particle update (OpenGL 3.3 path).
+// Every particle in the pool is processed each frame: dead ones are respawned on the sun's surface,
+// so the pool never shrinks and nothing has to be read back on the CPU.
+layout (location = 0) in vec4 aPositionAge;  // xyz = position, w = age in seconds (negative = not born yet)
+layout (location = 1) in vec4 aVelocityLife; // xyz = velocity, w = lifetime in seconds
+
+out vec4 outPositionAge;
+out vec4 outVelocityLife;
+
+uniform float deltaTime;
+uniform int seed;           // changes every frame
+uniform vec3 sunCenter;
+uniform float sunRadius;
+uniform float gravity;      // acceleration at the sun's surface
+uniform float windFraction; // share of particles that escape as solar wind
+
+float hash(uint n) {
+    n = (n << 13u) ^ n;
+    n = n * (n * n * 15731u + 789221u) + 1376312589u;
+    return float(n & 0x7fffffffu) / float(0x7fffffff);
+}
+
+vec3 randomDirection(uint n) {
+    float z = hash(n) * 2.0 - 1.0;
+    float a = hash(n + 1u) * 6.2831853;
+    float r = sqrt(max(1.0 - z * z, 0.0));
+    return vec3(r * cos(a), z, r * sin(a));
+}
+
+// Corona particles leave slowly and fall back in loops, solar wind particles are fast enough to escape
+void spawn(uint n, out vec4 positionAge, out vec4 velocityLife) {
+    vec3 dir = randomDirection(n);
+    vec3 velocity;
+    float life;
+    if (hash(n + 2u) < windFraction) {
+        velocity = dir * mix(20.0, 40.0, hash(n + 3u));
+        life = mix(4.0, 8.0, hash(n + 4u));
+    } else {
+        vec3 tangent = normalize(cross(dir, randomDirection(n + 5u)) + vec3(1e-4));
+        velocity = dir * mix(4.0, 9.0, hash(n + 3u)) + tangent * 3.0 * hash(n + 6u);
+        life = mix(0.8, 2.5, hash(n + 4u));
+    }
+    positionAge = vec4(sunCenter + dir * sunRadius * 1.01, 0.0);
+    velocityLife = vec4(velocity, life);
+}
+
+void main() {
+    vec4 positionAge = aPositionAge;
+    vec4 velocityLife = aVelocityLife;
+    positionAge.w += deltaTime;
+
+    if (positionAge.w >= velocityLife.w) {
+        spawn(uint(gl_VertexID) * 747796405u + uint(seed) * 2891336453u, positionAge, velocityLife);
+    } else if (positionAge.w >= 0.0) {
+        // sun gravity, then move (semi-implicit Euler)
+        vec3 r = positionAge.xyz - sunCenter;
+        float distance2 = max(dot(r, r), sunRadius * sunRadius);
+        velocityLife.xyz -= normalize(r) * gravity * sunRadius * sunRadius / distance2 * deltaTime;
+        positionAge.xyz += velocityLife.xyz * deltaTime;
+
+        // fell back into the sun
+        if (length(positionAge.xyz - sunCenter) < sunRadius) {
+            positionAge.w = velocityLife.w;
+        }
+    }
+
+    outPositionAge = positionAge;
+    outVelocityLife = velocityLife;
+}
@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 FragColor;
+in vec3 Direction;
+
+uniform samplerCube sky;
+
+void main() {
+    FragColor = texture(sky, Direction);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+// Full-screen triangle at the far plane without a vertex buffer: vertex 0, 1, 2 -> (-1,-1), (3,-1), (-1,3)
+out vec3 Direction;
+
+// Camera matrices, written once per frame by CameraBuffer (and overwritten just before submit in late-latch mode)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // xyz = camera position
+};
+
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    gl_Position = vec4(corner, 1.0, 1.0); // z = w: depth 1.0, the far plane
+
+    // view space point on the far plane behind this corner, turned into a world space direction by the
+    // view's rotation only (the sky is infinitely far away: moving the camera never moves it)
+    vec4 target = inverse(projection) * vec4(corner, 1.0, 1.0);
+    Direction = transpose(mat3(view)) * (target.xyz / target.w);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D scene;
+uniform vec2 usedSize;   // part of the texture the scene was drawn into (0..1)
+uniform vec2 texelSize;  // 1 / texture size
+uniform float sharpness; // 0 = plain bilinear
+
+void main() {
+    // stay half a texel inside the used part, so nothing bleeds in from the unused rest of the texture
+    vec2 uv = clamp(TexCoords * usedSize, texelSize * 0.5, usedSize - texelSize * 0.5);
+    vec3 centre = texture(scene, uv).rgb;
+    if (sharpness <= 0.0) {
+        FragColor = vec4(centre, 1.0);
+        return;
+    }
+
+    // Unsharp mask on the 4 neighbours, clamped to their range so edges don't get bright / dark halos
+    vec3 up = texture(scene, min(uv + vec2(0.0, texelSize.y), usedSize - texelSize * 0.5)).rgb;
+    vec3 down = texture(scene, max(uv - vec2(0.0, texelSize.y), texelSize * 0.5)).rgb;
+    vec3 right = texture(scene, min(uv + vec2(texelSize.x, 0.0), usedSize - texelSize * 0.5)).rgb;
+    vec3 left = texture(scene, max(uv - vec2(texelSize.x, 0.0), texelSize * 0.5)).rgb;
+    vec3 blurred = (up + down + left + right) * 0.25;
+    vec3 lowest = min(centre, min(min(up, down), min(left, right)));
+    vec3 highest = max(centre, max(max(up, down), max(left, right)));
+    FragColor = vec4(clamp(centre + (centre - blurred) * sharpness * 2.0, lowest, highest), 1.0);
+}
@@ -0,0 +1,38 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel; // per instance (locations 3 to 6), one body each
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+
+// Camera matrices, written once per frame by CameraBuffer
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // xyz = camera position
+};
+
+// How aNormal is stored (PackedMesh::normalEncoding in vertexformat.h):
+// 0 = float normal, 1 = octahedral in aNormal.xy, 2 = none, the normalised position (spheres around the origin)
+uniform int normalEncoding;
+
+vec3 decodeNormal() {
+    if (normalEncoding == 2) return normalize(aPos);
+    if (normalEncoding == 1) {
+        vec3 n = vec3(aNormal.xy, 1.0 - abs(aNormal.x) - abs(aNormal.y));
+        float t = max(-n.z, 0.0); // lower half was folded over the diagonals
+        n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+        return normalize(n);
+    }
+    return aNormal;
+}
+
+void main() {
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(aModel))) * decodeNormal();
+    TexCoord = aTexCoord;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
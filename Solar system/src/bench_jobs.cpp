@@ -0,0 +1,140 @@
+// Job system microbenchmark: scheduling overhead per job and parallelFor scaling from 1 to 64 threads.
+//
+// To run this code: navigate to "Solar system" folder -> copy/paste below
+// g++ -O2 -std=c++17 -pthread -Iinclude src/bench_jobs.cpp -o build/bench_jobs && build/bench_jobs
+//
+// Options:
+//   --max-threads N   largest thread count in the scaling curve, default 64
+//   --bodies N        bodies simulated in the scaling workload, default 200000
+//   --json PATH       results file, default bench_jobs.json
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "headers/jobs.h"
+#include "headers/solar.h"
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+void emptyJob(void *, size_t, size_t) {}
+
+// Cost of run() + execute + wait() for jobs that do nothing.
+// Submitted in batches small enough to fit a worker's deque, so nothing falls back to running inline.
+double overheadPerJob(JobSystem &jobs, size_t jobCount) {
+    const size_t batch = 1024;
+    auto start = Clock::now();
+    for (size_t done = 0; done < jobCount; done += batch) {
+        JobSystem::Counter counter;
+        for (size_t i = 0; i < batch; ++i) {
+            jobs.run(&emptyJob, nullptr, 0, 0, counter);
+        }
+        jobs.wait(counter);
+    }
+    size_t total = (jobCount + batch - 1) / batch * batch;
+    return elapsedNs(start) / static_cast<double>(total);
+}
+
+// parallelFor with grain 1 over empty iterations: every iteration becomes its own job.
+// Only meaningful with 2+ threads: with one, parallelFor calls the body inline and schedules nothing.
+double overheadPerParallelForJob(JobSystem &jobs, size_t count) {
+    auto start = Clock::now();
+    jobs.parallelFor(count, [](size_t, size_t) {}, 1);
+    return elapsedNs(start) / static_cast<double>(count);
+}
+
+struct ScalingPoint {
+    unsigned threads = 0;
+    double msPerStep = 0.0;
+    double speedup = 1.0;
+    double overheadNs = 0.0;
+    double parallelForOverheadNs = -1.0; // -1 = not measured (1 thread)
+};
+
+int main(int argc, char **argv) {
+    unsigned maxThreads = 64;
+    size_t bodyCount = 200000;
+    std::string jsonPath = "bench_jobs.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-threads" && i + 1 < argc) maxThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--bodies" && i + 1 < argc) bodyCount = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else {
+            std::cerr << "usage: bench_jobs [--max-threads N] [--bodies N] [--json PATH]\n";
+            return 1;
+        }
+    }
+    if (maxThreads == 0) maxThreads = 1;
+
+    // same workload for every thread count: body update + cull of a big asteroid belt
+    SolarSystem solar;
+    solar.addAsteroidBelt(bodyCount);
+    glm::mat4 projection = glm::perspective(glm::radians(55.0f), 1200.0f / 800.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.5f, 22.0f), glm::vec3(0.0f, 10.5f, 21.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+    std::vector<int> visible;
+    const int steps = 20;
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+
+    std::vector<ScalingPoint> curve;
+    for (unsigned threads = 1; threads <= maxThreads; threads = std::min(threads * 2, maxThreads)) {
+        JobSystem jobs(threads);
+        ScalingPoint point;
+        point.threads = threads;
+        point.overheadNs = overheadPerJob(jobs, 100000);
+        if (threads > 1) point.parallelForOverheadNs = overheadPerParallelForJob(jobs, 100000);
+
+        solar.update(0.0f, &jobs); // warm up
+        auto start = Clock::now();
+        for (int step = 1; step <= steps; ++step) {
+            solar.update(step / 60.0f, &jobs);
+            solar.cull(frustum, visible, &jobs);
+        }
+        point.msPerStep = elapsedNs(start) / steps / 1.0e6;
+        point.speedup = curve.empty() ? 1.0 : curve[0].msPerStep / point.msPerStep;
+        curve.push_back(point);
+
+        std::cout << threads << " threads: " << point.msPerStep << " ms/step, speedup " << point.speedup
+                  << ", overhead " << point.overheadNs << " ns/job (run+wait), ";
+        if (threads > 1) std::cout << point.parallelForOverheadNs << " ns/job (parallelFor grain 1)\n";
+        else std::cout << "n/a (parallelFor grain 1 runs inline on 1 thread)\n";
+
+        if (threads == maxThreads) break; // doubling stops at maxThreads, so the sweep always finishes on it
+    }
+
+    std::ofstream json(jsonPath);
+    if (!json) {
+        std::cerr << "bench_jobs: cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    json << "{\n  \"benchmark\": \"bench_jobs\",\n  \"bodies\": " << solar.bodies.size()
+         << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < curve.size(); ++i) {
+        const ScalingPoint &p = curve[i];
+        json << "    {\"threads\": " << p.threads
+             << ", \"ms_per_step\": " << p.msPerStep
+             << ", \"speedup\": " << p.speedup
+             << ", \"overhead_ns_per_job\": " << p.overheadNs
+             << ", \"parallel_for_overhead_ns_per_job\": ";
+        if (p.parallelForOverheadNs >= 0.0) json << p.parallelForOverheadNs;
+        else json << "null";
+        json << "}" << (i + 1 < curve.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    std::cout << "results written to " << jsonPath << "\n";
+    return 0;
+}
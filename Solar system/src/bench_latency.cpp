@@ -0,0 +1,234 @@
+// Input-to-photon latency and frame pacing benchmark: renders the normal scene in a hidden window while a second
+// thread injects synthetic mouse movement at a fixed rate (like a gaming mouse), then reports latency percentiles,
+// present-to-present jitter, CPU usage and the GPU time of each render pass.
+// Every injected event goes through the same path as real input: window event queue -> InputState -> Camera
+// -> frame -> GL_TIMESTAMP / fence.
+//
+// To run this code: navigate to "Solar system" folder -> copy/paste below
+// g++ -O2 -std=c++17 -pthread -Iinclude -Linclude/lib src/glad.c src/window.cpp src/bench_latency.cpp -lglfw3dll -lopengl32 -o build/bench_latency.exe && build/bench_latency.exe
+// Without a window (Linux, no GLFW) run_headless --input-rate HZ measures the same latency on an EGL context.
+//
+// Options:
+//   --frames N     frames to render, default 1000
+//   --rate HZ      synthetic mouse events per second, default 1000
+//   --pacing MODE  uncapped (default), vsync, adaptive or limiter
+//   --fps N        limiter target, default 0 = monitor refresh rate
+//   --late-latch   overwrite the camera with the newest mouse movement just before swapBuffers
+//   --render-thread  simulate on the main thread and draw on a render thread (frame packets, like the app)
+//   --json PATH    results file, default bench_latency.json
+//   --stats PATH   per-frame statistics: CSV (one row per frame) if PATH ends in .csv, JSON otherwise
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "headers/window.h"
+#include "headers/shader.h"
+#include "headers/mesh.h"
+#include "headers/camera.h"
+#include "headers/input.h"
+#include "headers/latency.h"
+#include "headers/framepacer.h"
+#include "headers/renderthread.h"
+#include "headers/framestats.h"
+
+int main(int argc, char **argv) {
+    int frames = 1000;
+    double rate = 1000.0;
+    FramePacer::Mode pacing = FramePacer::Uncapped;
+    double targetFps = 0.0;
+    bool lateLatch = false;
+    bool threaded = false;
+    std::string jsonPath = "bench_latency.json";
+    std::string statsPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) frames = std::atoi(argv[++i]);
+        else if (arg == "--rate" && i + 1 < argc) rate = std::atof(argv[++i]);
+        else if (arg == "--pacing" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "uncapped") pacing = FramePacer::Uncapped;
+            else if (mode == "vsync") pacing = FramePacer::VSync;
+            else if (mode == "adaptive") pacing = FramePacer::AdaptiveVSync;
+            else if (mode == "limiter") pacing = FramePacer::Limiter;
+            else {
+                std::cerr << "bench_latency: unknown pacing mode " << mode << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--fps" && i + 1 < argc) targetFps = std::atof(argv[++i]);
+        else if (arg == "--late-latch") lateLatch = true;
+        else if (arg == "--render-thread") threaded = true;
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--stats" && i + 1 < argc) statsPath = argv[++i];
+        else {
+            std::cerr << "usage: bench_latency [--frames N] [--rate HZ] [--pacing MODE] [--fps N] [--late-latch] [--render-thread] [--json PATH] [--stats PATH]\n";
+            return 1;
+        }
+    }
+    if (frames <= 0 || rate <= 0.0) {
+        std::cerr << "bench_latency: need at least one frame and a positive rate\n";
+        return 1;
+    }
+
+    Window window(1200, 800);
+    if (window.Initialise(false) != 0) {
+        return 1;
+    }
+    FramePacer pacer;
+    pacer.setMode(pacing, targetFps);
+
+    JobSystem jobs;
+    Tri tri(&jobs);
+    Shader shader("asset/shaders/vertex.vs", "asset/shaders/fragment.fs");
+    Shader light("asset/shaders/lightver.vs", "asset/shaders/lightfrag.fs");
+    shader.setBlockBinding("Camera", CameraBuffer::BINDING);
+    light.setBlockBinding("Camera", CameraBuffer::BINDING);
+    if (lateLatch && !tri.supportsLateLatch()) {
+        std::cout << "late latch not supported here, measuring without it\n";
+        lateLatch = false;
+    }
+    Camera camera;
+    InputState input;
+    LatencyTracker latency;
+    latency.create(glfwGetTime());
+
+    // the only producer of the input queue while the benchmark runs (the hidden window gets no real input)
+    std::atomic<bool> injecting{true};
+    std::thread injector([&]() {
+        auto period = std::chrono::duration<double>(1.0 / rate);
+        auto next = std::chrono::steady_clock::now();
+        while (injecting.load()) {
+            InputEvent event;
+            event.type = InputEvent::MouseMove;
+            event.x = 0.5f; // slow constant pan
+            window.injectEvent(event);
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    FrameStats stats(static_cast<size_t>(frames));
+    RenderThread renderer(window, tri, light, shader, pacer, latency);
+    if (threaded) {
+        renderer.setLateLatch(lateLatch);
+        renderer.setFrameStats(&stats);
+        renderer.start();
+    }
+
+    float lastTime = static_cast<float>(glfwGetTime());
+    double start = glfwGetTime();
+    double lastPresent = 0.0;
+    FramePacket singlePacket; // single-threaded mode
+    for (int frame = 0; frame < frames; ++frame) {
+        float now = static_cast<float>(glfwGetTime());
+        float deltaTime = now - lastTime;
+        lastTime = now;
+        double simStart = glfwGetTime();
+
+        glfwPollEvents();
+        input.drain(window.getInputQueue());
+        double inputTime = input.takeInputTime();
+        camera.keyControl(input.keys, deltaTime, inputTime);
+        camera.mouseControl(input.takeXChange(), input.takeYChange(), true, inputTime);
+
+        if (threaded) {
+            // same as the app: latch offer, packet, hand over (rendering overlaps the next iteration)
+            inputTime = camera.takeInputTime();
+            renderer.latchCamera(tri.cameraBlock(camera), inputTime);
+            FramePacket &packet = renderer.beginFrame();
+            packet.inputTime = inputTime;
+            tri.buildPacket(camera, glfwGetTime(), packet);
+            packet.simMs = static_cast<float>((glfwGetTime() - simStart) * 1000.0);
+            renderer.submit();
+            continue;
+        }
+
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // same as tri.draw(), split so simulation and GL submission are timed separately
+        FrameSample sample;
+        tri.buildPacket(camera, glfwGetTime(), singlePacket);
+        double renderStart = glfwGetTime();
+        sample.simMs = static_cast<float>((renderStart - simStart) * 1000.0);
+        tri.render(light, shader, singlePacket);
+        sample.renderMs = static_cast<float>((glfwGetTime() - renderStart) * 1000.0);
+        pacer.waitForPresent();
+        if (lateLatch) {
+            glfwPollEvents();
+            input.drain(window.getInputQueue());
+            float xChange = input.takeXChange();
+            float yChange = input.takeYChange();
+            if (xChange != 0.0f || yChange != 0.0f) {
+                camera.mouseControl(xChange, yChange, true, input.takeInputTime());
+                tri.latchCamera(camera);
+            }
+        }
+        latency.endFrame(camera.takeInputTime(), glfwGetTime());
+        window.swapBuffers();
+        pacer.presented();
+
+        sample.time = glfwGetTime();
+        sample.frameMs = static_cast<float>((sample.time - lastPresent) * 1000.0);
+        sample.gpuMs = tri.getProfiler().getLastMs("frame");
+        sample.counters = tri.getCounters();
+        if (lastPresent > 0.0) stats.record(sample);
+        lastPresent = sample.time;
+    }
+    if (threaded) renderer.stop(); // waits for the last frame
+    double seconds = glfwGetTime() - start;
+    FramePacer::Stats pacingStats = pacer.getStats();
+
+    injecting.store(false);
+    injector.join();
+    latency.finish();
+    latency.printReport("synthetic mouse");
+    pacer.printReport();
+    tri.getProfiler().printReport();
+    stats.printReport();
+    if (!statsPath.empty()) {
+        bool csv = statsPath.size() > 4 && statsPath.compare(statsPath.size() - 4, 4, ".csv") == 0;
+        if (csv ? stats.writeCsv(statsPath) : stats.writeJson(statsPath)) std::cout << "frame statistics written to " << statsPath << "\n";
+    }
+    std::cout << "frames " << frames << ", " << seconds * 1000.0 / frames << " ms/frame, dropped events "
+              << window.getInputQueue().getDropped() << "\n";
+
+    std::ofstream json(jsonPath);
+    if (!json) {
+        std::cerr << "bench_latency: cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    json << "{\n  \"benchmark\": \"bench_latency\",\n  \"frames\": " << frames
+         << ",\n  \"rate_hz\": " << rate
+         << ",\n  \"pacing\": \"" << FramePacer::getModeName(pacer.getMode()) << "\""
+         << ",\n  \"target_fps\": " << (pacer.getMode() == FramePacer::Limiter ? pacer.getTargetFps() : 0.0)
+         << ",\n  \"late_latch\": " << (lateLatch ? "true" : "false")
+         << ",\n  \"render_thread\": " << (threaded ? "true" : "false")
+         << ",\n  \"ms_per_frame\": " << seconds * 1000.0 / frames
+         << ",\n  \"frame_ms\": {\"mean\": " << pacingStats.meanMs << ", \"jitter\": " << pacingStats.jitterMs
+         << ", \"p99\": " << pacingStats.p99Ms << ", \"max\": " << pacingStats.maxMs << "}"
+         << ",\n  \"cpu_usage\": " << pacingStats.cpuUsage
+         << ",\n  \"samples\": " << latency.getSampleCount()
+         << ",\n  \"latency_ms\": {\"mean\": " << latency.getMeanMs()
+         << ", \"p50\": " << latency.getPercentileMs(50.0)
+         << ", \"p90\": " << latency.getPercentileMs(90.0)
+         << ", \"p99\": " << latency.getPercentileMs(99.0)
+         << ", \"max\": " << latency.getPercentileMs(100.0) << "}"
+         << ",\n  \"gpu_passes\": [";
+    // GPU time per pass (timestamp queries, mean over the run)
+    const std::vector<GpuProfiler::Pass> &passes = tri.getProfiler().getPasses();
+    for (size_t i = 0; i < passes.size(); ++i) {
+        json << (i ? "," : "") << "\n    {\"name\": \"" << passes[i].name << "\", \"mean_ms\": " << passes[i].getMeanMs()
+             << ", \"max_ms\": " << passes[i].maxMs << ", \"samples\": " << passes[i].samples << "}";
+    }
+    json << "\n  ]\n}\n";
+    std::cout << "results written to " << jsonPath << "\n";
+
+    latency.del();
+    tri.del();
+    return 0;
+}
@@ -0,0 +1,661 @@
+// Scene scaling benchmark: generates scenes of increasing size (the solar system plus a seeded asteroid belt),
+// flies the same scripted camera path through each one headless (surfaceless EGL, see headless.h) and reports
+// frame time percentiles, draw calls, triangles and memory for every vertex format and rendering mode.
+// Seed, timestep, camera path and resolution are fixed, so two runs on the same machine draw exactly the same
+// frames: compare bench_scene.json before and after a change (one result per line, so a plain diff works).
+//
+// Rendering modes: every mode but `instanced` is the engine itself (a Tri per run, Tri::buildPacket then
+// Tri::render: the sun, the sphere per body, the sky and the particles, through the frame graph)
+//   engine        the app's defaults: sky after the bodies, occlusion culling, no bloom, full resolution
+//   sky-first     the sky drawn before the bodies without a depth test (Tri::setSkyFirst)
+//   no-occlusion  frustum culling only (Tri::setOcclusionCulling)
+//   bloom         the bloom passes (Tri::setBloom)
+//   scaled        dynamic resolution with the --budget GPU time (Tri::setDynamicResolution)
+//   instanced     extra, outside the engine: the visible bodies' model matrices are streamed into an instance
+//                 buffer and drawn with one call per frame, for every --mesh (no sun shader, sky or particles)
+//
+// To run this code (Linux): navigate to "Solar system" folder -> copy/paste below
+// g++ -O2 -std=c++17 -pthread -Iinclude src/glad.c src/bench_scene.cpp -lEGL -ldl -o build/bench_scene && build/bench_scene
+//
+// Options:
+//   --bodies N[,N...]  total body count (11 = the solar system alone, more = plus an asteroid belt),
+//                      default 11,1000,100000,1000000
+//   --mesh LIST        meshes of the instanced runs: sphere, cube or both (comma separated), default sphere,cube
+//                      (the engine always draws its sphere)
+//   --modes LIST       engine, sky-first, no-occlusion, bloom, scaled, instanced (comma separated), default all
+//   --frames N         measured frames per run (the camera path is stretched over them), default 300
+//   --warmup N         unmeasured frames before each run, default 10
+//   --timestep S       simulated seconds per frame, default 1/60
+//   --seed N           asteroid belt seed, default 1234
+//   --segments N       sphere segments around and top to bottom, default 16 (the app uses 128)
+//   --size WxH         framebuffer size, default 1280x720
+//   --threads T        job system threads for update and cull, default 1 (no job system)
+//   --budget MS        GPU time budget of the scaled mode, default 8
+//   --no-mesh-opt      upload the instanced meshes in the order they are built (no MeshOptimizer), to compare;
+//                      the engine always optimizes its sphere
+//   --vertex-format LIST  float, snorm16, snorm8, derived (vertexformat.h; derived only for the sphere),
+//                      default float,derived
+//   --gl-trace         count the real GL state changes of every frame (GlTrace, costs some CPU time per call);
+//                      without it state_changes_avg is null
+//   --json PATH        results file, default bench_scene.json
+//
+// Vertex bandwidth: besides the GPU time, every run reports the bytes its draws read from the vertex and index
+// buffers per frame, estimated from the FIFO cache model (MeshOptimizer::analyze): each instance reads every index,
+// and the vertices the cache misses. Compare it between vertex formats.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include "headers/headless.h"
+#include "headers/shader.h"
+#include "headers/mesh.h"
+#include "headers/camera.h"
+#include "headers/camerabuffer.h"
+#include "headers/gpuprofiler.h"
+#include "headers/framestats.h"
+#include "headers/solar.h"
+#include "headers/jobs.h"
+#include "headers/occlusion.h"
+#include "headers/meshopt.h"
+#include "headers/vertexformat.h"
+#include "headers/gltrace.h"
+#include "headers/framepacket.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+enum class RenderMode { Engine, SkyFirst, NoOcclusion, Bloom, Scaled, Instanced };
+
+const char *renderModeName(RenderMode mode) {
+    switch (mode) {
+    case RenderMode::SkyFirst: return "sky-first";
+    case RenderMode::NoOcclusion: return "no-occlusion";
+    case RenderMode::Bloom: return "bloom";
+    case RenderMode::Scaled: return "scaled";
+    case RenderMode::Instanced: return "instanced";
+    default: return "engine";
+    }
+}
+
+const RenderMode allModes[] = {RenderMode::Engine, RenderMode::SkyFirst, RenderMode::NoOcclusion, RenderMode::Bloom,
+                               RenderMode::Scaled, RenderMode::Instanced};
+
+// false (mode unchanged) for an unknown name
+bool parseRenderMode(const std::string &name, RenderMode &mode) {
+    for (RenderMode m : allModes) {
+        if (name == renderModeName(m)) {
+            mode = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Settings {
+    size_t frames = 300;
+    size_t warmup = 10;
+    double timestep = 1.0 / 60.0;
+    uint32_t seed = 1234u;
+    unsigned segments = 16;
+    int width = 1280, height = 720;
+    float budgetMs = 8.0f; // scaled mode
+    bool meshOpt = true;
+    bool glTrace = false;
+};
+
+// A mesh of the instanced runs (`instanceVAO` reads a mat4 per instance next to the vertex), or, measured but
+// never uploaded, the sphere a Tri builds for itself (sizes and vertex cache of the engine runs)
+struct BenchMesh {
+    std::string name;
+    VertexFormat format = VertexFormat::Float;
+    unsigned int instanceVAO = 0, VBO = 0, EBO = 0, instanceVBO = 0;
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    int normalEncoding = 0;
+    size_t vertexBytes = 0, indexBytes = 0;
+    size_t fetchBytes = 0;           // vertex + index bytes one draw of it reads (FIFO cache estimate)
+    MeshOptimizer::CacheStats cache; // FIFO vertex cache as uploaded
+
+    void measure(const PackedMesh &mesh) {
+        format = mesh.format;
+        indexCount = mesh.indexCount;
+        indexType = mesh.indexType;
+        normalEncoding = mesh.normalEncoding();
+        vertexBytes = mesh.vertices.size();
+        indexBytes = mesh.indices.size();
+        fetchBytes = cache.misses * mesh.stride + indexBytes;
+    }
+
+    void upload(const PackedMesh &mesh) {
+        measure(mesh);
+
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &instanceVBO);
+        glGenVertexArrays(1, &instanceVAO);
+        glBindVertexArray(instanceVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, mesh.vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh.indices.data(), GL_STATIC_DRAW);
+        mesh.setAttributes(0, 1, 2);
+
+        // model matrix = 4 vec4 attributes (locations 3 to 6), advanced once per instance
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (int column = 0; column < 4; ++column) {
+            glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribDivisor(3 + column, 1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void del() {
+        glDeleteVertexArrays(1, &instanceVAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &instanceVBO);
+    }
+};
+
+struct Result {
+    size_t bodies = 0;
+    std::string mesh;
+    std::string format; // vertex format
+    std::string mode;
+    MeshOptimizer::CacheStats cache; // the mesh's vertex cache efficiency (ACMR / ATVR)
+    FrameStats stats;
+    double visibleAvg = 0.0;
+    size_t gpuBufferBytes = 0;   // mesh + instance buffer
+    size_t gpuTargetBytes = 0;   // frame graph render targets of the largest frame (what bloom and scaled add)
+    size_t gpuParticleBytes = 0; // particle buffers (engine runs)
+    size_t gpuTextureBytes = 0;  // body and sky textures
+    double fetchBytesAvg = 0.0;  // vertex and index bytes read per frame (FIFO cache estimate)
+    size_t cpuSceneBytes = 0;    // bodies, scene graph and per-frame draw lists
+    long rssDeltaKb = 0;         // resident memory the run added (Linux only, see residentKb)
+    bool hasRss = false;
+
+    explicit Result(size_t frames) : stats(frames) {}
+};
+
+// Scripted camera: one lap around the sun, diving from high above into the asteroid belt halfway through and
+// climbing out again, always looking ahead along the belt. `t` runs from 0 to 1 over the measured frames.
+void cameraPath(Camera &camera, const glm::vec3 &sun, float t) {
+    const float pi = 3.14159265f;
+    float angle = 2.0f * pi * t;
+    float dive = std::sin(pi * t);                 // 0 at the ends, 1 halfway
+    float radius = 90.0f - 50.0f * dive;           // the belt lies between 35 and 45
+    float height = 30.0f - 28.0f * dive;
+    camera.Position = sun + glm::vec3(std::cos(angle) * radius, height, std::sin(angle) * radius);
+
+    glm::vec3 target = sun + glm::vec3(std::cos(angle + 0.6f) * 40.0f, 0.0f, std::sin(angle + 0.6f) * 40.0f);
+    camera.focusOn(target, glm::length(target - camera.Position));
+}
+
+// drawListBytes: what the run copies per frame for drawing (the packet's draw items, or the visible list and matrices)
+size_t sceneBytes(const SolarSystem &solar, size_t drawListBytes) {
+    size_t perNode = sizeof(int) + 2 * sizeof(glm::vec3) + sizeof(glm::quat) + sizeof(glm::mat4) + 1 + sizeof(unsigned int);
+    return solar.bodies.capacity() * sizeof(Body) + solar.scene.size() * perNode + drawListBytes;
+}
+
+// Resident memory of the process right now (/proc/self/statm), -1 = unavailable. Memory freed by an earlier run is
+// handed back first (malloc_trim), so a run that reuses it still shows what it needs.
+long residentKb() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    if (statm >> size >> resident) return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+    return -1;
+}
+
+void measureRss(Result &result, long beforeKb) {
+    long afterKb = residentKb();
+    result.hasRss = beforeKb >= 0 && afterKb >= 0;
+    result.rssDeltaKb = result.hasRss ? afterKb - beforeKb : 0;
+}
+
+// One engine run: a new Tri with the scene, set to `mode`, draws every frame like the app
+Result runEngine(size_t bodies, const BenchMesh &sphere, RenderMode mode, const Settings &settings,
+                 HeadlessContext &context, Shader &light, Shader &shader, JobSystem *jobs) {
+    Result result(settings.frames);
+    long startKb = residentKb();
+    result.mesh = "sphere";
+    result.format = vertexFormatName(sphere.format);
+    result.cache = sphere.cache;
+    result.mode = renderModeName(mode);
+
+    Tri tri(jobs, sphere.format, settings.segments);
+    size_t planets = tri.getSolar().bodies.size();
+    if (bodies > planets) tri.addAsteroidBelt(bodies - planets, settings.seed);
+    tri.setViewport(settings.width, settings.height);
+    tri.setSkyFirst(mode == RenderMode::SkyFirst);
+    tri.setOcclusionCulling(mode != RenderMode::NoOcclusion);
+    tri.setBloom(mode == RenderMode::Bloom);
+    tri.setDynamicResolution(mode == RenderMode::Scaled, settings.budgetMs);
+
+    const SolarSystem &solar = tri.getSolar();
+    result.bodies = solar.bodies.size();
+    const glm::vec3 sun = solar.getPosition(solar.bodies[solar.findBody("Sun")]);
+    Camera camera;
+    FramePacket packet;
+    size_t visibleTotal = 0;
+
+    using Clock = std::chrono::steady_clock;
+    for (size_t frame = 0; frame < settings.warmup + settings.frames; ++frame) {
+        bool measured = frame >= settings.warmup;
+        size_t step = measured ? frame - settings.warmup : 0; // warm-up frames all draw the first frame
+        double time = static_cast<double>(step) * settings.timestep;
+        cameraPath(camera, sun, static_cast<float>(step) / static_cast<float>(settings.frames));
+
+        Clock::time_point frameStart = Clock::now();
+        tri.buildPacket(camera, time, packet);
+        Clock::time_point renderStart = Clock::now();
+
+        context.bind();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        tri.render(light, shader, packet);
+        Clock::time_point renderEnd = Clock::now();
+
+        // the frame is done when the GPU is done (there is no swapBuffers to wait on)
+        glFinish();
+        context.endFrame();
+        GlTrace::endFrame();
+        Clock::time_point frameEnd = Clock::now();
+
+        if (!measured) continue;
+        FrameSample sample;
+        sample.time = time;
+        sample.frameMs = std::chrono::duration<float, std::milli>(frameEnd - frameStart).count();
+        sample.simMs = std::chrono::duration<float, std::milli>(renderStart - frameStart).count();
+        sample.renderMs = std::chrono::duration<float, std::milli>(renderEnd - renderStart).count();
+        sample.gpuMs = tri.getProfiler().getLastMs("frame");
+        sample.counters = tri.getCounters();
+        sample.counters.stateChanges = GlTrace::getLastStateChanges(); // -1 without --gl-trace
+        result.stats.record(sample);
+        visibleTotal += packet.suns.size() + packet.bodies.size();
+        result.gpuTargetBytes = std::max(result.gpuTargetBytes, tri.getFrameGraph().getTargetBytes(true));
+    }
+
+    result.visibleAvg = static_cast<double>(visibleTotal) / static_cast<double>(settings.frames);
+    result.gpuBufferBytes = sphere.vertexBytes + sphere.indexBytes;
+    result.gpuParticleBytes = tri.getParticleBytes();
+    result.gpuTextureBytes = tri.getTextureBytes();
+    result.fetchBytesAvg = result.visibleAvg * static_cast<double>(sphere.fetchBytes);
+    result.cpuSceneBytes = sceneBytes(solar, (packet.suns.capacity() + packet.bodies.capacity()) * sizeof(DrawItem));
+    measureRss(result, startKb); // the Tri, its scene and (on a software renderer) its GPU memory, before freeing it
+
+    tri.del();
+    return result;
+}
+
+// The instanced extra: culled like the engine (frustum, then occlusion), every visible body in one instanced draw
+Result runInstanced(SolarSystem &solar, BenchMesh &mesh, const Settings &settings, HeadlessContext &context,
+                    Shader &shader, unsigned int diffuse, unsigned int specular, JobSystem *jobs) {
+    Result result(settings.frames);
+    long startKb = residentKb();
+    result.bodies = solar.bodies.size();
+    result.mesh = mesh.name;
+    result.format = vertexFormatName(mesh.format);
+    result.cache = mesh.cache;
+    result.mode = renderModeName(RenderMode::Instanced);
+
+    solar.update(0.0f, jobs); // world matrices of a new scene are only built by the first update
+    const glm::vec3 sun = solar.getPosition(solar.bodies[solar.findBody("Sun")]);
+    const float aspect = static_cast<float>(settings.width) / static_cast<float>(settings.height);
+    const uint64_t meshTriangles = mesh.indexCount / 3;
+
+    Camera camera;
+    CameraBuffer cameraBuffer;
+    cameraBuffer.create(false);
+    GpuProfiler profiler;
+    std::vector<int> visible;
+    std::vector<glm::mat4> models;
+    OcclusionCuller occlusion;
+    size_t instanceBytes = 0;
+    size_t visibleTotal = 0;
+
+    using Clock = std::chrono::steady_clock;
+    for (size_t frame = 0; frame < settings.warmup + settings.frames; ++frame) {
+        bool measured = frame >= settings.warmup;
+        size_t step = measured ? frame - settings.warmup : 0; // warm-up frames all draw the first frame
+        double time = static_cast<double>(step) * settings.timestep;
+        cameraPath(camera, sun, static_cast<float>(step) / static_cast<float>(settings.frames));
+
+        // simulation: move the bodies, cull them and copy the visible ones' matrices (like Tri::buildPacket)
+        Clock::time_point frameStart = Clock::now();
+        solar.update(static_cast<float>(time), jobs);
+        CameraBlock block;
+        block.view = camera.GetViewMatrix();
+        block.projection = camera.GetProjectionMatrix(aspect);
+        block.viewPos = glm::vec4(camera.Position, 1.0f);
+        solar.cull(Frustum(block.projection * block.view), visible, jobs);
+        RenderCounters counters;
+        counters.frustumCulled = static_cast<unsigned int>(solar.bodies.size() - visible.size());
+        counters.occlusionCulled = static_cast<unsigned int>(occlusion.cull(solar, block, visible, jobs));
+        models.clear();
+        for (int index : visible) models.push_back(solar.getModel(solar.bodies[index]));
+        Clock::time_point renderStart = Clock::now();
+
+        // rendering: every body with the planet shader and the moon's texture
+        context.bind();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        profiler.beginFrame();
+        profiler.push("frame");
+        cameraBuffer.begin(block);
+
+        shader.use();
+        shader.setVec3("lightPos", solar.lightPos);
+        shader.setInt("normalEncoding", mesh.normalEncoding);
+        shader.setInt("material.diffuse", 0);
+        shader.setInt("material.specular", 1);
+        shader.setFloat("material.shininess", 32.0f);
+        shader.setVec3("light.ambient", 0.25f, 0.25f, 0.25f);
+        shader.setVec3("light.diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuse);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specular);
+
+        if (!models.empty()) {
+            // a new buffer every frame (orphaning), so the upload never waits for the previous frame's draw
+            glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceVBO);
+            glBufferData(GL_ARRAY_BUFFER, models.size() * sizeof(glm::mat4), models.data(), GL_STREAM_DRAW);
+            glBindVertexArray(mesh.instanceVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(mesh.indexCount), mesh.indexType, 0,
+                                    static_cast<GLsizei>(models.size()));
+            instanceBytes = std::max(instanceBytes, models.size() * sizeof(glm::mat4));
+            counters.drawCalls += 1;
+        }
+        counters.triangles += meshTriangles * models.size();
+
+        cameraBuffer.end();
+        profiler.pop();
+        profiler.endFrame();
+        Clock::time_point renderEnd = Clock::now();
+
+        // the frame is done when the GPU is done (there is no swapBuffers to wait on)
+        glFinish();
+        context.endFrame();
+        GlTrace::endFrame();
+        counters.stateChanges = GlTrace::getLastStateChanges(); // -1 without --gl-trace
+        Clock::time_point frameEnd = Clock::now();
+
+        if (!measured) continue;
+        FrameSample sample;
+        sample.time = time;
+        sample.frameMs = std::chrono::duration<float, std::milli>(frameEnd - frameStart).count();
+        sample.simMs = std::chrono::duration<float, std::milli>(renderStart - frameStart).count();
+        sample.renderMs = std::chrono::duration<float, std::milli>(renderEnd - renderStart).count();
+        sample.gpuMs = profiler.getLastMs("frame");
+        sample.counters = counters;
+        result.stats.record(sample);
+        visibleTotal += visible.size();
+    }
+
+    result.visibleAvg = static_cast<double>(visibleTotal) / static_cast<double>(settings.frames);
+    result.gpuBufferBytes = mesh.vertexBytes + mesh.indexBytes + instanceBytes;
+    result.gpuTextureBytes = textureBytes(diffuse) + textureBytes(specular);
+    result.fetchBytesAvg = result.visibleAvg * static_cast<double>(mesh.fetchBytes);
+    result.cpuSceneBytes = sceneBytes(solar, visible.capacity() * sizeof(int) + models.capacity() * sizeof(glm::mat4));
+    measureRss(result, startKb); // the scene is built before the run and shared by its meshes, it isn't counted
+
+    profiler.del();
+    cameraBuffer.del();
+    return result;
+}
+
+std::vector<std::string> parseNames(const std::string &text) {
+    std::vector<std::string> names;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) names.push_back(item);
+    }
+    return names;
+}
+
+std::vector<size_t> parseList(const std::string &text) {
+    std::vector<size_t> values;
+    for (const std::string &item : parseNames(text)) values.push_back(std::strtoull(item.c_str(), nullptr, 10));
+    return values;
+}
+
+void writeSummary(std::ofstream &json, const char *name, const FrameStats::Summary &s) {
+    json << ", \"" << name << "\": {\"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90
+         << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+}
+
+// The sphere a Tri builds for itself (same segments, MeshOptimizer and packing), measured for the engine runs
+BenchMesh engineSphere(unsigned segments, VertexFormat format) {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    createSphere(vertices, indices, segments, segments);
+    MeshOptimizer::optimize(vertices, 8, indices);
+    BenchMesh sphere;
+    sphere.name = "sphere";
+    sphere.cache = MeshOptimizer::analyze(indices, vertices.size() / 8);
+    sphere.measure(PackedMesh::pack(vertices, indices, format));
+    return sphere;
+}
+
+void printResult(const Result &r) {
+    FrameStats::Summary frame = r.stats.summarize(&FrameSample::frameMs);
+    std::cout << "bodies " << r.bodies << ", " << r.mesh << " (" << r.format << "), " << r.mode
+              << ": frame p50 " << frame.p50 << " ms, p90 " << frame.p90 << " ms, p99 " << frame.p99
+              << " ms, max " << frame.max << " ms (sim " << r.stats.summarize(&FrameSample::simMs).mean
+              << ", render " << r.stats.summarize(&FrameSample::renderMs).mean
+              << ", GPU " << r.stats.summarize(&FrameSample::gpuMs).mean << ")"
+              << ", visible " << r.visibleAvg
+              << " (culled " << r.stats.summarize(&RenderCounters::frustumCulled).mean << " off screen, "
+              << r.stats.summarize(&RenderCounters::occlusionCulled).mean << " hidden)"
+              << ", draws " << r.stats.summarize(&RenderCounters::drawCalls).mean
+              << ", triangles " << r.stats.summarize(&RenderCounters::triangles).mean
+              << ", vertex fetch " << r.fetchBytesAvg / (1024.0 * 1024.0) << " MB"
+              << ", GPU buffers " << r.gpuBufferBytes / 1024 << " KB, targets " << r.gpuTargetBytes / 1024
+              << " KB, particles " << r.gpuParticleBytes / 1024 << " KB, textures " << r.gpuTextureBytes / 1024
+              << " KB, scene " << r.cpuSceneBytes / 1024 << " KB, resident ";
+    if (r.hasRss) std::cout << (r.rssDeltaKb >= 0 ? "+" : "") << r.rssDeltaKb << " KB\n";
+    else std::cout << "n/a\n";
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> bodyCounts = {11, 1000, 100000, 1000000};
+    std::vector<std::string> meshNames = {"sphere", "cube"};
+    std::vector<std::string> modeNames;
+    for (RenderMode mode : allModes) modeNames.push_back(renderModeName(mode));
+    std::vector<std::string> formatNames = {"float", "derived"};
+    Settings settings;
+    unsigned threads = 1;
+    std::string jsonPath = "bench_scene.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bodies" && i + 1 < argc) bodyCounts = parseList(argv[++i]);
+        else if (arg == "--mesh" && i + 1 < argc) meshNames = parseNames(argv[++i]);
+        else if (arg == "--modes" && i + 1 < argc) modeNames = parseNames(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc) settings.frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--warmup" && i + 1 < argc) settings.warmup = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--timestep" && i + 1 < argc) settings.timestep = std::atof(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) settings.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--segments" && i + 1 < argc) settings.segments = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &settings.width, &settings.height) != 2) settings.width = settings.height = 0;
+        }
+        else if (arg == "--threads" && i + 1 < argc) threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--budget" && i + 1 < argc) settings.budgetMs = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--no-mesh-opt") settings.meshOpt = false;
+        else if (arg == "--gl-trace") settings.glTrace = true;
+        else if (arg == "--vertex-format" && i + 1 < argc) formatNames = parseNames(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else {
+            std::cerr << "usage: bench_scene [--bodies N[,N...]] [--mesh sphere,cube] [--modes engine,sky-first,no-occlusion,bloom,scaled,instanced]"
+                         " [--frames N] [--warmup N] [--timestep S] [--seed N] [--segments N] [--size WxH] [--threads T] [--budget MS]"
+                         " [--no-mesh-opt] [--vertex-format float,snorm16,snorm8,derived] [--gl-trace] [--json PATH]\n";
+            return 1;
+        }
+    }
+    if (settings.frames == 0 || bodyCounts.empty() || formatNames.empty() || settings.timestep <= 0.0 || settings.segments < 3 ||
+        settings.width <= 0 || settings.height <= 0 || settings.budgetMs <= 0.0f) {
+        std::cerr << "bench_scene: need at least one body count, vertex format and frame, a positive timestep, size and budget, and 3+ segments\n";
+        return 1;
+    }
+    std::vector<VertexFormat> formats;
+    for (const std::string &name : formatNames) {
+        VertexFormat format;
+        if (!parseVertexFormat(name, format)) {
+            std::cerr << "bench_scene: unknown vertex format " << name << "\n";
+            return 1;
+        }
+        formats.push_back(format);
+    }
+    std::vector<RenderMode> engineModes;
+    bool instancedRuns = false;
+    for (const std::string &name : modeNames) {
+        RenderMode mode;
+        if (!parseRenderMode(name, mode)) {
+            std::cerr << "bench_scene: unknown mode " << name << "\n";
+            return 1;
+        }
+        if (mode == RenderMode::Instanced) instancedRuns = true;
+        else engineModes.push_back(mode);
+    }
+
+    HeadlessContext context(settings.width, settings.height, settings.timestep);
+    if (context.Initialise() != 0) {
+        return 1;
+    }
+    if (settings.glTrace) GlTrace::install();
+
+    std::vector<BenchMesh> spheres; // what each engine run's Tri draws, one per vertex format
+    if (!engineModes.empty()) {
+        for (VertexFormat format : formats) spheres.push_back(engineSphere(settings.segments, format));
+    }
+    std::vector<BenchMesh> meshes;  // the instanced runs' meshes
+    if (!instancedRuns) meshNames.clear();
+    for (const std::string &name : meshNames) {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        if (name == "sphere") createSphere(vertices, indices, settings.segments, settings.segments);
+        else if (name == "cube") createCube(vertices, indices);
+        else {
+            std::cerr << "bench_scene: unknown mesh " << name << "\n";
+            return 1;
+        }
+        if (settings.meshOpt) MeshOptimizer::optimize(vertices, 8, indices, name.c_str());
+        MeshOptimizer::CacheStats cache = MeshOptimizer::analyze(indices, vertices.size() / 8);
+        for (VertexFormat format : formats) {
+            // the cube's normals aren't its positions, it would come out lit like a sphere
+            if (format == VertexFormat::Derived && name != "sphere") {
+                std::cout << "bench_scene: derived normals only fit the sphere, no derived " << name << "\n";
+                continue;
+            }
+            BenchMesh mesh;
+            mesh.name = name;
+            mesh.cache = cache;
+            mesh.upload(PackedMesh::pack(vertices, indices, format, name.c_str()));
+            meshes.push_back(mesh);
+        }
+    }
+
+    Shader shader("asset/shaders/vertex.vs", "asset/shaders/fragment.fs");
+    Shader light("asset/shaders/lightver.vs", "asset/shaders/lightfrag.fs");
+    Shader instanced("asset/shaders/vertex_instanced.vs", "asset/shaders/fragment.fs");
+    shader.setBlockBinding("Camera", CameraBuffer::BINDING);
+    light.setBlockBinding("Camera", CameraBuffer::BINDING);
+    instanced.setBlockBinding("Camera", CameraBuffer::BINDING);
+    unsigned int diffuse = loadTexture("asset/textures/moon.png");
+    unsigned int specular = loadTexture("asset/textures/earth_specular.png");
+
+    std::unique_ptr<JobSystem> jobs;
+    if (threads > 1) jobs.reset(new JobSystem(threads));
+
+    std::vector<Result> results;
+    for (size_t count : bodyCounts) {
+        for (const BenchMesh &sphere : spheres) {
+            for (RenderMode mode : engineModes) {
+                results.push_back(runEngine(count, sphere, mode, settings, context, light, shader, jobs.get()));
+                printResult(results.back());
+            }
+        }
+        if (meshes.empty()) continue;
+        SolarSystem solar;
+        if (count > solar.bodies.size()) {
+            solar.addAsteroidBelt(count - solar.bodies.size(), settings.seed);
+        }
+        for (BenchMesh &mesh : meshes) {
+            results.push_back(runInstanced(solar, mesh, settings, context, instanced, diffuse, specular, jobs.get()));
+            printResult(results.back());
+        }
+    }
+
+    std::ofstream json(jsonPath);
+    if (!json) {
+        std::cerr << "bench_scene: cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    json << "{\n  \"benchmark\": \"bench_scene\",\n  \"renderer\": \"" << glGetString(GL_RENDERER)
+         << "\",\n  \"width\": " << settings.width << ",\n  \"height\": " << settings.height
+         << ",\n  \"frames\": " << settings.frames << ",\n  \"warmup\": " << settings.warmup
+         << ",\n  \"timestep\": " << settings.timestep << ",\n  \"seed\": " << settings.seed
+         << ",\n  \"segments\": " << settings.segments << ",\n  \"threads\": " << threads
+         << ",\n  \"budget_ms\": " << settings.budgetMs
+         << ",\n  \"mesh_opt\": " << (settings.meshOpt ? "true" : "false")
+         << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        json << "    {\"bodies\": " << r.bodies << ", \"mesh\": \"" << r.mesh << "\", \"vertex_format\": \"" << r.format
+             << "\", \"mode\": \"" << r.mode << "\""
+             << ", \"acmr\": " << r.cache.acmr << ", \"atvr\": " << r.cache.atvr;
+        writeSummary(json, "frame_ms", r.stats.summarize(&FrameSample::frameMs));
+        json << ", \"sim_ms\": " << r.stats.summarize(&FrameSample::simMs).mean
+             << ", \"render_ms\": " << r.stats.summarize(&FrameSample::renderMs).mean
+             << ", \"gpu_ms\": " << r.stats.summarize(&FrameSample::gpuMs).mean
+             << ", \"visible_avg\": " << r.visibleAvg
+             << ", \"frustum_culled_avg\": " << r.stats.summarize(&RenderCounters::frustumCulled).mean
+             << ", \"occlusion_culled_avg\": " << r.stats.summarize(&RenderCounters::occlusionCulled).mean
+             << ", \"draw_calls_avg\": " << r.stats.summarize(&RenderCounters::drawCalls).mean
+             << ", \"triangles_avg\": " << r.stats.summarize(&RenderCounters::triangles).mean
+             << ", \"state_changes_avg\": ";
+        if (r.stats.hasStateChanges()) json << r.stats.summarize(&RenderCounters::stateChanges).mean;
+        else json << "null";
+        json << ", \"gpu_buffer_bytes\": " << r.gpuBufferBytes
+             << ", \"gpu_target_bytes\": " << r.gpuTargetBytes
+             << ", \"gpu_particle_bytes\": " << r.gpuParticleBytes
+             << ", \"gpu_texture_bytes\": " << r.gpuTextureBytes
+             << ", \"vertex_fetch_bytes_avg\": " << r.fetchBytesAvg
+             << ", \"cpu_scene_bytes\": " << r.cpuSceneBytes
+             << ", \"rss_delta_kb\": ";
+        if (r.hasRss) json << r.rssDeltaKb;
+        else json << "null";
+        json << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    std::cout << "results written to " << jsonPath << "\n";
+
+    for (BenchMesh &mesh : meshes) mesh.del();
+    glDeleteTextures(1, &diffuse);
+    glDeleteTextures(1, &specular);
+    glDeleteProgram(shader.ID);
+    glDeleteProgram(light.ID);
+    glDeleteProgram(instanced.ID);
+    return 0;
+}
@@ -0,0 +1,247 @@
+// Headless simulation benchmark: runs the body update (orbits, spin, world matrices, frustum culling,
+// picking BVH refit and ray picks) without a window or OpenGL context, so the CPU hot path can be profiled on build servers.
+//
+// To run this code: navigate to "Solar system" folder -> copy/paste below
+// g++ -O2 -std=c++17 -pthread -Iinclude src/bench_sim.cpp -o build/bench_sim && build/bench_sim --bodies 1000,100000 --steps 200
+//
+// Options:
+//   --bodies N[,N...]  total body count (the 11 default bodies + an asteroid belt), default 1000,10000,100000
+//   --steps M          simulated frames per run, default 200
+//   --dt SECONDS       fixed timestep, default 1/60
+//   --threads T        job system threads for update and cull, default 1 (no job system)
+//   --json PATH        results file, default bench_sim.json
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "headers/solar.h"
+#include "headers/jobs.h"
+#include "headers/bvh.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware cache-miss counter (Linux perf events). Reports unavailable anywhere else,
+// or when the kernel does not allow it (containers, perf_event_paranoid).
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    uint64_t stop() {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd < 0) return 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int fd = -1;
+};
+
+struct Result {
+    size_t bodies = 0;
+    size_t steps = 0;
+    double updateNs = 0.0; // orbit + spin + world matrices
+    double cullNs = 0.0;   // frustum test
+    double refitNs = 0.0;  // picking BVH refit (and occasional rebuild)
+    double pickNs = 0.0;   // total time of all picks
+    size_t picks = 0;
+    double visibleAvg = 0.0;
+    bool hasCacheMisses = false;
+    uint64_t cacheMisses = 0;
+
+    double perBodyStep(double ns) const { return ns / static_cast<double>(bodies * steps); }
+};
+
+Result runBenchmark(size_t bodyCount, size_t steps, float dt, JobSystem *jobs) {
+    SolarSystem solar;
+    if (bodyCount > solar.bodies.size()) {
+        solar.addAsteroidBelt(bodyCount - solar.bodies.size());
+    }
+
+    // Same view as the default Camera (position, yaw -90, pitch 0, 55 degree fov, 1200x800)
+    glm::vec3 position(0.0f, 10.5f, 22.0f);
+    glm::mat4 view = glm::lookAt(position, position + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(55.0f), 1200.0f / 800.0f, 0.1f, 1000.0f);
+    Frustum frustum(projection * view);
+    std::vector<int> visible;
+    visible.reserve(solar.bodies.size());
+
+    // warm up caches and page in the arrays
+    solar.update(0.0f, jobs);
+    solar.cull(frustum, visible, jobs);
+    BodyBVH bvh;
+    bvh.refit(solar, jobs);
+
+    // pick rays spread over the middle of the screen, same sequence every run
+    const int picksPerStep = 64;
+    std::vector<glm::vec3> rays(picksPerStep);
+    for (int i = 0; i < picksPerStep; ++i) {
+        float x = (static_cast<float>(i % 8) / 7.0f - 0.5f) * 0.5f;
+        float y = (static_cast<float>(i / 8) / 7.0f - 0.5f) * 0.5f;
+        rays[i] = glm::normalize(glm::vec3(0.0f, 0.0f, -1.0f) + glm::vec3(x * 0.78f, y * 0.52f, 0.0f));
+    }
+    volatile int picked = 0;
+
+    Result result;
+    result.bodies = solar.bodies.size();
+    result.steps = steps;
+
+    CacheMissCounter counter;
+    result.hasCacheMisses = counter.available();
+    size_t visibleTotal = 0;
+
+    counter.start();
+    for (size_t step = 0; step < steps; ++step) {
+        float time = static_cast<float>(step + 1) * dt;
+
+        auto t0 = std::chrono::steady_clock::now();
+        solar.update(time, jobs);
+        auto t1 = std::chrono::steady_clock::now();
+        solar.cull(frustum, visible, jobs);
+        auto t2 = std::chrono::steady_clock::now();
+        bvh.refit(solar, jobs);
+        auto t3 = std::chrono::steady_clock::now();
+        for (const glm::vec3 &direction : rays) {
+            picked = picked + bvh.pick(position, direction);
+        }
+        auto t4 = std::chrono::steady_clock::now();
+
+        result.updateNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        result.cullNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        result.refitNs += std::chrono::duration<double, std::nano>(t3 - t2).count();
+        result.pickNs += std::chrono::duration<double, std::nano>(t4 - t3).count();
+        result.picks += rays.size();
+        visibleTotal += visible.size();
+    }
+    result.cacheMisses = counter.stop();
+    result.visibleAvg = static_cast<double>(visibleTotal) / static_cast<double>(steps);
+    return result;
+}
+
+std::vector<size_t> parseList(const std::string &text) {
+    std::vector<size_t> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) values.push_back(std::strtoull(item.c_str(), nullptr, 10));
+    }
+    return values;
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> bodyCounts = {1000, 10000, 100000};
+    size_t steps = 200;
+    float dt = 1.0f / 60.0f;
+    std::string jsonPath = "bench_sim.json";
+    unsigned threads = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bodies" && i + 1 < argc) bodyCounts = parseList(argv[++i]);
+        else if (arg == "--steps" && i + 1 < argc) steps = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--dt" && i + 1 < argc) dt = std::strtof(argv[++i], nullptr);
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc) threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else {
+            std::cerr << "usage: bench_sim [--bodies N[,N...]] [--steps M] [--dt SECONDS] [--threads T] [--json PATH]\n";
+            return 1;
+        }
+    }
+    if (steps == 0 || bodyCounts.empty()) {
+        std::cerr << "bench_sim: need at least one body count and one step\n";
+        return 1;
+    }
+
+    std::unique_ptr<JobSystem> jobs;
+    if (threads > 1) jobs.reset(new JobSystem(threads));
+
+    std::vector<Result> results;
+    for (size_t count : bodyCounts) {
+        Result r = runBenchmark(count, steps, dt, jobs.get());
+        results.push_back(r);
+
+        std::cout << "bodies " << r.bodies << ", steps " << r.steps
+                  << ": " << r.perBodyStep(r.updateNs + r.cullNs) << " ns/body/step"
+                  << " (update " << r.perBodyStep(r.updateNs)
+                  << ", cull " << r.perBodyStep(r.cullNs) << ")"
+                  << ", BVH refit " << r.perBodyStep(r.refitNs) << " ns/body/step"
+                  << ", pick " << r.pickNs / static_cast<double>(r.picks) << " ns"
+                  << ", visible " << r.visibleAvg;
+        if (r.hasCacheMisses) {
+            std::cout << ", cache misses/body/step " << static_cast<double>(r.cacheMisses) / (r.bodies * r.steps);
+        } else {
+            std::cout << ", cache misses n/a";
+        }
+        std::cout << "\n";
+    }
+
+    std::ofstream json(jsonPath);
+    if (!json) {
+        std::cerr << "bench_sim: cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    json << "{\n  \"benchmark\": \"bench_sim\",\n  \"dt\": " << dt << ",\n  \"threads\": " << threads
+         << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        json << "    {\"bodies\": " << r.bodies
+             << ", \"steps\": " << r.steps
+             << ", \"ns_per_body_step\": " << r.perBodyStep(r.updateNs + r.cullNs)
+             << ", \"update_ns_per_body_step\": " << r.perBodyStep(r.updateNs)
+             << ", \"cull_ns_per_body_step\": " << r.perBodyStep(r.cullNs)
+             << ", \"refit_ns_per_body_step\": " << r.perBodyStep(r.refitNs)
+             << ", \"pick_ns\": " << r.pickNs / static_cast<double>(r.picks)
+             << ", \"visible_avg\": " << r.visibleAvg
+             << ", \"cache_misses\": ";
+        if (r.hasCacheMisses) json << r.cacheMisses;
+        else json << "null";
+        json << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    std::cout << "results written to " << jsonPath << "\n";
+    return 0;
+}
@@ -0,0 +1,332 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "solar.h"
+#include "jobs.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Bounding volume hierarchy over the bodies' bounding spheres, used for ray picking.
+// Nodes are boxes, leaves hold up to LANES bodies stored as packets (x[], y[], z[], radius[]),
+// so one leaf is tested against the ray with a single SIMD ray-vs-sphere test (SSE: 4 wide, AVX: 8 wide).
+//
+// Bodies move every frame, so refit() updates the boxes bottom-up instead of rebuilding.
+// The tree is rebuilt when the body set changes, or when moving bodies have stretched the boxes too much.
+//
+// Usage:
+//   BodyBVH bvh;
+//   bvh.refit(solar);                             // after solar.update()
+//   int body = bvh.pick(origin, direction, &distance);  // -1 = nothing hit
+class BodyBVH {
+public:
+#if defined(__AVX__)
+    static const int LANES = 8;
+#else
+    static const int LANES = 4;
+#endif
+
+    // Full rebuild from the bodies' current positions (median split along the longest axis)
+    void build(const SolarSystem &solar) {
+        size_t count = solar.bodies.size();
+        bodyCount = count;
+        nodes.clear();
+        items.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            items[i].center = solar.getPosition(solar.bodies[i]);
+            items[i].body = static_cast<int>(i);
+        }
+        if (count == 0) return;
+
+        nodes.reserve(2 * (count / LANES + 1));
+        nodes.push_back(Node());
+        subdivide(0, 0, count);
+
+        // leaf packets: every leaf starts on a multiple of LANES, empty lanes get radius -1 (never hit)
+        size_t slots = 0;
+        for (Node &node : nodes) {
+            if (node.count > 0) {
+                node.packet = static_cast<int>(slots);
+                slots += LANES;
+            }
+        }
+        packetBody.assign(slots, -1);
+        packetX.assign(slots, 0.0f);
+        packetY.assign(slots, 0.0f);
+        packetZ.assign(slots, 0.0f);
+        packetRadius.assign(slots, -1.0f);
+        for (const Node &node : nodes) {
+            if (node.count == 0) continue;
+            for (int i = 0; i < node.count; ++i) {
+                packetBody[node.packet + i] = items[node.first + i].body;
+            }
+        }
+
+        fillPackets(solar, nullptr);
+        refitNodes();
+        buildCost = cost();
+    }
+
+    // Call once per frame after solar.update(). Rebuilds if bodies were added / removed,
+    // or once the refitted boxes cost 1.5x as much to traverse as freshly built ones (orbiting rocks drift apart).
+    void refit(const SolarSystem &solar, JobSystem *jobs = nullptr) {
+        if (solar.bodies.size() != bodyCount || nodes.empty()) {
+            build(solar);
+            return;
+        }
+        fillPackets(solar, jobs);
+        refitNodes();
+        if (cost() > buildCost * 1.5f) {
+            build(solar);
+        }
+    }
+
+    // Closest body hit by the ray (direction does not need to be normalised), -1 if none.
+    // `distance` receives the distance along the normalised ray to the hit sphere's surface.
+    int pick(const glm::vec3 &origin, const glm::vec3 &direction, float *distance = nullptr) const {
+        if (nodes.empty()) return -1;
+        glm::vec3 dir = glm::normalize(direction);
+        glm::vec3 invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z); // IEEE inf for 0 components is fine for slabs
+
+        float best = std::numeric_limits<float>::max();
+        int bestBody = -1;
+
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            if (rayBox(origin, invDir, node, best) == std::numeric_limits<float>::max()) continue;
+
+            if (node.count > 0) {
+                int lane = raySpheres(origin, dir, node.packet, best);
+                if (lane >= 0) bestBody = packetBody[node.packet + lane];
+                continue;
+            }
+
+            // visit the nearer child first so `best` shrinks early and prunes the other one
+            int left = node.first;
+            int right = node.first + 1;
+            float tLeft = rayBox(origin, invDir, nodes[left], best);
+            float tRight = rayBox(origin, invDir, nodes[right], best);
+            if (tLeft > tRight) {
+                std::swap(left, right);
+                std::swap(tLeft, tRight);
+            }
+            if (tRight != std::numeric_limits<float>::max()) stack[top++] = right;
+            if (tLeft != std::numeric_limits<float>::max()) stack[top++] = left;
+        }
+
+        if (distance && bestBody >= 0) *distance = best;
+        return bestBody;
+    }
+
+    size_t getNodeCount() const { return nodes.size(); }
+
+private:
+    // 32 bytes. Inner node: first = left child (right child = first + 1), count = 0.
+    // Leaf: first = start in `items`, count = bodies, packet = start in the packet arrays.
+    struct Node {
+        glm::vec3 min;
+        int first = 0;
+        glm::vec3 max;
+        int count = 0;
+        int packet = 0;
+    };
+
+    // build scratch: sorted in place, so the split compares contiguous memory instead of chasing body indices
+    struct BuildItem {
+        glm::vec3 center;
+        int body;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<BuildItem> items; // bodies in leaf order after build()
+    size_t bodyCount = 0;
+    float buildCost = 0.0f;
+
+    // leaf packets (structure of arrays so a leaf loads straight into SIMD registers)
+    std::vector<int> packetBody;
+    std::vector<float> packetX, packetY, packetZ, packetRadius;
+
+    void subdivide(int nodeIndex, size_t begin, size_t end) {
+        glm::vec3 centroidMin(std::numeric_limits<float>::max());
+        glm::vec3 centroidMax(-std::numeric_limits<float>::max());
+        for (size_t i = begin; i < end; ++i) {
+            centroidMin = glm::min(centroidMin, items[i].center);
+            centroidMax = glm::max(centroidMax, items[i].center);
+        }
+
+        if (end - begin <= static_cast<size_t>(LANES)) {
+            nodes[nodeIndex].first = static_cast<int>(begin);
+            nodes[nodeIndex].count = static_cast<int>(end - begin);
+            return;
+        }
+
+        glm::vec3 extent = centroidMax - centroidMin;
+        int axis = 0;
+        if (extent.y > extent.x) axis = 1;
+        if (extent.z > extent[axis]) axis = 2;
+
+        size_t mid = begin + (end - begin) / 2;
+        std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                         [axis](const BuildItem &a, const BuildItem &b) { return a.center[axis] < b.center[axis]; });
+
+        // children are always stored after their parent, so refitNodes() can walk the array backwards
+        int left = static_cast<int>(nodes.size());
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        nodes[nodeIndex].first = left;
+        nodes[nodeIndex].count = 0;
+        subdivide(left, begin, mid);
+        subdivide(left + 1, mid, end);
+    }
+
+    void fillPackets(const SolarSystem &solar, JobSystem *jobs) {
+        auto fill = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int body = packetBody[i];
+                if (body < 0) continue;
+                glm::vec3 center = solar.getPosition(solar.bodies[body]);
+                packetX[i] = center.x;
+                packetY[i] = center.y;
+                packetZ[i] = center.z;
+                packetRadius[i] = solar.getRadius(solar.bodies[body]);
+            }
+        };
+        if (jobs) {
+            jobs->parallelFor(packetBody.size(), fill);
+        } else {
+            fill(0, packetBody.size());
+        }
+    }
+
+    void refitNodes() {
+        for (size_t n = nodes.size(); n-- > 0;) {
+            Node &node = nodes[n];
+            if (node.count > 0) {
+                node.min = glm::vec3(std::numeric_limits<float>::max());
+                node.max = glm::vec3(-std::numeric_limits<float>::max());
+                for (int i = 0; i < node.count; ++i) {
+                    size_t slot = node.packet + i;
+                    glm::vec3 center(packetX[slot], packetY[slot], packetZ[slot]);
+                    glm::vec3 r(packetRadius[slot]);
+                    node.min = glm::min(node.min, center - r);
+                    node.max = glm::max(node.max, center + r);
+                }
+            } else {
+                const Node &left = nodes[node.first];
+                const Node &right = nodes[node.first + 1];
+                node.min = glm::min(left.min, right.min);
+                node.max = glm::max(left.max, right.max);
+            }
+        }
+    }
+
+    // Sum of node surface areas: proportional to the expected traversal cost of a random ray
+    float cost() const {
+        float total = 0.0f;
+        for (const Node &node : nodes) {
+            glm::vec3 e = node.max - node.min;
+            total += e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+        return total;
+    }
+
+    // Slab test. Returns the entry distance, or float max when the box is missed or starts beyond `maxT`.
+    static float rayBox(const glm::vec3 &origin, const glm::vec3 &invDir, const Node &node, float maxT) {
+        glm::vec3 t0 = (node.min - origin) * invDir;
+        glm::vec3 t1 = (node.max - origin) * invDir;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+        return enter <= exit ? enter : std::numeric_limits<float>::max();
+    }
+
+    // Ray (normalised direction) vs the LANES spheres of one leaf packet.
+    // Sphere hit: with oc = center - origin and b = dot(oc, dir), the ray passes the centre at distance |oc - b * dir|.
+    // disc = r^2 - |oc - b * dir|^2 >= 0 means a hit at t = b - sqrt(disc) (or b + sqrt(disc) when the origin is inside).
+    // (Same value as b^2 - |oc|^2 + r^2, but without the cancellation that makes far, grazing hits flicker.)
+    // Returns the lane of the closest hit nearer than `best` (and updates `best`), or -1.
+    int raySpheres(const glm::vec3 &origin, const glm::vec3 &dir, int packet, float &best) const {
+#if defined(__AVX__)
+        __m256 ocx = _mm256_sub_ps(_mm256_loadu_ps(&packetX[packet]), _mm256_set1_ps(origin.x));
+        __m256 ocy = _mm256_sub_ps(_mm256_loadu_ps(&packetY[packet]), _mm256_set1_ps(origin.y));
+        __m256 ocz = _mm256_sub_ps(_mm256_loadu_ps(&packetZ[packet]), _mm256_set1_ps(origin.z));
+        __m256 r = _mm256_loadu_ps(&packetRadius[packet]);
+        __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, _mm256_set1_ps(dir.x)), _mm256_mul_ps(ocy, _mm256_set1_ps(dir.y))),
+                                 _mm256_mul_ps(ocz, _mm256_set1_ps(dir.z)));
+        __m256 px = _mm256_sub_ps(ocx, _mm256_mul_ps(b, _mm256_set1_ps(dir.x)));
+        __m256 py = _mm256_sub_ps(ocy, _mm256_mul_ps(b, _mm256_set1_ps(dir.y)));
+        __m256 pz = _mm256_sub_ps(ocz, _mm256_mul_ps(b, _mm256_set1_ps(dir.z)));
+        __m256 disc = _mm256_sub_ps(_mm256_mul_ps(r, r),
+                                    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), _mm256_mul_ps(pz, pz)));
+        __m256 root = _mm256_sqrt_ps(_mm256_max_ps(disc, _mm256_setzero_ps()));
+        __m256 tNear = _mm256_sub_ps(b, root);
+        __m256 tFar = _mm256_add_ps(b, root);
+        __m256 zero = _mm256_setzero_ps();
+        __m256 t = _mm256_blendv_ps(tNear, tFar, _mm256_cmp_ps(tNear, zero, _CMP_LT_OQ));
+        __m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GE_OQ), _mm256_cmp_ps(r, zero, _CMP_GT_OQ)),
+                                   _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, _mm256_set1_ps(best), _CMP_LT_OQ)));
+        if (_mm256_movemask_ps(hit) == 0) return -1;
+        alignas(32) float ts[LANES];
+        _mm256_store_ps(ts, _mm256_blendv_ps(_mm256_set1_ps(std::numeric_limits<float>::max()), t, hit));
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128 ocx = _mm_sub_ps(_mm_loadu_ps(&packetX[packet]), _mm_set1_ps(origin.x));
+        __m128 ocy = _mm_sub_ps(_mm_loadu_ps(&packetY[packet]), _mm_set1_ps(origin.y));
+        __m128 ocz = _mm_sub_ps(_mm_loadu_ps(&packetZ[packet]), _mm_set1_ps(origin.z));
+        __m128 r = _mm_loadu_ps(&packetRadius[packet]);
+        __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, _mm_set1_ps(dir.x)), _mm_mul_ps(ocy, _mm_set1_ps(dir.y))),
+                              _mm_mul_ps(ocz, _mm_set1_ps(dir.z)));
+        __m128 px = _mm_sub_ps(ocx, _mm_mul_ps(b, _mm_set1_ps(dir.x)));
+        __m128 py = _mm_sub_ps(ocy, _mm_mul_ps(b, _mm_set1_ps(dir.y)));
+        __m128 pz = _mm_sub_ps(ocz, _mm_mul_ps(b, _mm_set1_ps(dir.z)));
+        __m128 disc = _mm_sub_ps(_mm_mul_ps(r, r), _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz)));
+        __m128 zero = _mm_setzero_ps();
+        __m128 root = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+        __m128 tNear = _mm_sub_ps(b, root);
+        __m128 tFar = _mm_add_ps(b, root);
+        __m128 inside = _mm_cmplt_ps(tNear, zero); // SSE2 has no blend: select with and / andnot / or
+        __m128 t = _mm_or_ps(_mm_and_ps(inside, tFar), _mm_andnot_ps(inside, tNear));
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmpgt_ps(r, zero)),
+                                _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, _mm_set1_ps(best))));
+        if (_mm_movemask_ps(hit) == 0) return -1;
+        alignas(16) float ts[LANES];
+        _mm_store_ps(ts, _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, _mm_set1_ps(std::numeric_limits<float>::max()))));
+#else
+        float ts[LANES];
+        for (int i = 0; i < LANES; ++i) {
+            size_t slot = packet + i;
+            glm::vec3 oc(packetX[slot] - origin.x, packetY[slot] - origin.y, packetZ[slot] - origin.z);
+            float r = packetRadius[slot];
+            float b = glm::dot(oc, dir);
+            glm::vec3 closest = oc - b * dir;
+            float disc = r * r - glm::dot(closest, closest);
+            ts[i] = std::numeric_limits<float>::max();
+            if (r <= 0.0f || disc < 0.0f) continue;
+            float root = std::sqrt(disc);
+            float t = b - root < 0.0f ? b + root : b - root;
+            if (t >= 0.0f && t < best) ts[i] = t;
+        }
+#endif
+        int lane = -1;
+        for (int i = 0; i < LANES; ++i) {
+            if (ts[i] < best) {
+                best = ts[i];
+                lane = i;
+            }
+        }
+        return lane;
+    }
+};
+
+#endif
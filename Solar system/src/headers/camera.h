@@ -57,8 +57,30 @@ public:
         return glm::perspective(glm::radians(Fov), aspectRatio, nearPlane, farPlane);
     }
 
+    // World-space direction of the ray through a screen point (ndcX, ndcY in -1..1, 0,0 = centre of the screen).
+    // Used for picking: the ray starts at Position.
+    glm::vec3 GetRayDirection(float ndcX, float ndcY, float aspectRatio) {
+        float tanHalfFov = tan(glm::radians(Fov) * 0.5f);
+        return glm::normalize(Front + Right * (ndcX * tanHalfFov * aspectRatio) + Up * (ndcY * tanHalfFov));
+    }
+
+    // Turn to face `target` and move to `distance` away from it (e.g focus on a picked planet)
+    void focusOn(const glm::vec3 &target, float distance) {
+        glm::vec3 direction = glm::normalize(target - Position);
+        Position = target - direction * distance;
+        Pitch = glm::degrees(asin(direction.y));
+        Yaw = glm::degrees(atan2(direction.z, direction.x));
+        updateCameraVectors();
+    }
+
     // Key control method using bool keys[1024];
-    void keyControl(bool* keys, float deltaTime) {
+    // inputTime: arrival time of the input being applied (0 = unknown), kept for latency measurement
+    void keyControl(bool* keys, float deltaTime, double inputTime = 0.0) {
+        if (keys[GLFW_KEY_W] || keys[GLFW_KEY_S] || keys[GLFW_KEY_A] || keys[GLFW_KEY_D] ||
+            keys[GLFW_KEY_SPACE] || keys[GLFW_KEY_C]) {
+            noteInput(inputTime);
+        }
+
         float velocity = MovementSpeed * deltaTime;
         if (keys[GLFW_KEY_W]) {
             Position += Front * velocity;
@@ -87,7 +109,11 @@ public:
     }
 
     // processes input received from a mouse input system. Expects the offset value in both the x and y direction.
-    void mouseControl(float xoffset, float yoffset, bool constrainPitch = true) {
+    void mouseControl(float xoffset, float yoffset, bool constrainPitch = true, double inputTime = 0.0) {
+        if (xoffset != 0.0f || yoffset != 0.0f) {
+            noteInput(inputTime);
+        }
+
         xoffset *= MouseSensitivity;
         yoffset *= MouseSensitivity;
 
@@ -106,6 +132,14 @@ public:
         updateCameraVectors();
     }
 
+    // Oldest input time that moved the camera since the last call (0 = camera not moved by input).
+    // The renderer hands it to the latency tracker together with the frame that shows the movement.
+    double takeInputTime() {
+        double time = pendingInputTime;
+        pendingInputTime = 0.0;
+        return time;
+    }
+
     void movelight(glm::vec3& lightPos) {
         float radius = 5.0f; // Radius of the circle
         float speed = 2.0f;   // Speed of light's movement
@@ -131,6 +165,14 @@ public:
     }
 
 private:
+    double pendingInputTime = 0.0;
+
+    void noteInput(double inputTime) {
+        if (inputTime > 0.0 && (pendingInputTime == 0.0 || inputTime < pendingInputTime)) {
+            pendingInputTime = inputTime;
+        }
+    }
+
     // calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors() {
         // calculate the new Front vector
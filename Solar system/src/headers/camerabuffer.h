@@ -0,0 +1,174 @@
+#ifndef CAMERABUFFER_H
+#define CAMERABUFFER_H
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include <cstring>
+#include <iostream>
+
+// Camera block shared by every shader (std140 layout, matches `uniform Camera` in the shaders)
+struct CameraBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 viewPos;
+};
+
+// Uniform buffer ring holding one CameraBlock per frame in flight.
+//
+// Normal mode: the block is uploaded once at the start of the frame.
+// Late-latch mode (needs OpenGL 4.4 glBufferStorage): the ring is persistently mapped and coherent,
+// so after the frame's draw calls have been issued the application can overwrite the block with a camera
+// built from fresher input. The GPU reads the buffer when it actually runs the draws (after submit),
+// so it renders with the late value: mouse look lands a frame sooner.
+// A fence per slot makes sure the CPU never writes a block the GPU may still be reading.
+//
+// Usage per frame:
+//   cameraBuffer.begin(block);   // before drawing
+//   ... draw ...
+//   cameraBuffer.end();          // after the last draw call of the frame
+//   cameraBuffer.latch(block);   // late-latch mode: freshest camera, just before swapBuffers
+class CameraBuffer {
+public:
+    static const GLuint BINDING = 0; // uniform block binding point of `Camera`
+    static const int FRAMES = 3;     // ring size (frames the GPU can be behind)
+
+    void create(bool wantLateLatch) {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        stride = (static_cast<GLsizeiptr>(sizeof(CameraBlock)) + alignment - 1) / alignment * alignment;
+
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        persistent = wantLateLatch && GLAD_GL_VERSION_4_4;
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, stride * FRAMES, nullptr, flags);
+            mapped = static_cast<unsigned char *>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, stride * FRAMES, flags));
+            if (!mapped) {
+                std::cout << "CameraBuffer: persistent mapping failed, late latch off\n";
+                persistent = false;
+                glDeleteBuffers(1, &UBO);
+                glGenBuffers(1, &UBO);
+                glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+            }
+        }
+        if (!persistent) {
+            glBufferData(GL_UNIFORM_BUFFER, stride * FRAMES, nullptr, GL_DYNAMIC_DRAW);
+            if (wantLateLatch) std::cout << "CameraBuffer: late latch needs OpenGL 4.4, using per-frame uploads\n";
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // Writes the frame's camera into the next ring slot and binds it to BINDING
+    void begin(const CameraBlock &block) {
+        slot = (slot + 1) % FRAMES;
+        if (fences[slot]) { // GPU still using this slot from FRAMES frames ago? (normally long done)
+            glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fences[slot]);
+            fences[slot] = nullptr;
+        }
+
+        write(block);
+        glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, UBO, slot * stride, sizeof(CameraBlock));
+    }
+
+    // After the frame's last draw call: the slot may be rewritten once the GPU passes this point
+    void end() {
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // Late latch: replace the current frame's camera after its draws were issued (returns false if unsupported)
+    bool latch(const CameraBlock &block) {
+        if (!persistent) return false;
+        write(block);
+        return true;
+    }
+
+    bool isLateLatch() const { return persistent; }
+
+    // Checks that this driver really picks up a block overwritten after the draw was issued:
+    // draws one pixel that outputs view[0][0], then latches a different value before reading it back.
+    // Returns false (and turns late latch off) if the GPU saw the early value.
+    bool verifyLateLatch() {
+        if (!persistent) return false;
+
+        Shader check("asset/shaders/latch_check.vs", "asset/shaders/latch_check.fs");
+        check.setBlockBinding("Camera", BINDING);
+
+        GLuint FBO, colour, VAO;
+        glGenFramebuffers(1, &FBO);
+        glGenRenderbuffers(1, &colour);
+        glGenVertexArrays(1, &VAO);
+        glBindRenderbuffer(GL_RENDERBUFFER, colour);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_R32F, 1, 1);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colour);
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glViewport(0, 0, 1, 1);
+
+        CameraBlock block = {};
+        block.view[0][0] = 1.0f; // early value
+        begin(block);
+        check.use();
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_POINTS, 0, 1);
+        end();
+        block.view[0][0] = 2.0f; // late value
+        latch(block);
+
+        float seen = 0.0f;
+        glReadPixels(0, 0, 1, 1, GL_RED, GL_FLOAT, &seen);
+
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindVertexArray(0);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteRenderbuffers(1, &colour);
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteProgram(check.ID);
+
+        if (seen != 2.0f) {
+            std::cout << "CameraBuffer: GPU used the early camera (" << seen << "), late latch off\n";
+            persistent = false;
+            return false;
+        }
+        return true;
+    }
+
+    void del() {
+        for (GLsync &fence : fences) {
+            if (fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (mapped) {
+            glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &UBO);
+    }
+
+private:
+    GLuint UBO = 0;
+    GLsizeiptr stride = 0;
+    unsigned char *mapped = nullptr; // persistent mapping (late latch), stays valid for the buffer's lifetime
+    bool persistent = false;
+    int slot = FRAMES - 1;           // slot of the current frame
+    GLsync fences[FRAMES] = {};
+
+    void write(const CameraBlock &block) {
+        if (mapped) {
+            std::memcpy(mapped + slot * stride, &block, sizeof(CameraBlock)); // coherent: no flush needed
+        } else {
+            glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+            glBufferSubData(GL_UNIFORM_BUFFER, slot * stride, sizeof(CameraBlock), &block);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef CUBEMAP_H
+#define CUBEMAP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "jobs.h"
+
+// Equirectangular star map (longitude across, latitude down) -> mipmapped cubemap, in the .cubemap file layout that
+// Skybox reads (src/headers/skybox.h). make_skybox runs it offline; Tri runs it at startup when the file is missing.
+//
+// Every face texel averages SxS bilinear samples of the map (S = map texels per face texel, at least 1), so the
+// stars don't flicker in and out of the smaller faces. Each mip level is the 2x2 average of the one above it.
+//
+// Usage:
+//   std::vector<char> file = Cubemap::build(rgb, width, height, 1024, &jobs); // rgb = width x height RGB8 texels
+class Cubemap {
+public:
+    static const int FACE_SIZE = 1024; // default face size in texels
+
+    // Map texels averaged per face texel in each direction (a face covers a quarter of the map's width)
+    static int samplesPerTexel(int mapWidth, int size) {
+        return std::max(1, static_cast<int>(std::ceil(mapWidth / 4.0f / size)));
+    }
+
+    // Mip levels of a face of `size` texels (a power of two), down to 1x1
+    static int levelCount(int size) {
+        int levels = 0;
+        for (int s = size; s >= 1; s /= 2) ++levels;
+        return levels;
+    }
+
+    // The whole .cubemap file. jobs (optional) builds the rows of level 0 in parallel.
+    static std::vector<char> build(const unsigned char *rgb, int width, int height, int size, JobSystem *jobs = nullptr) {
+        int samples = samplesPerTexel(width, size);
+        const float pi = 3.14159265358979f;
+
+        // level 0: every row of every face is independent
+        std::vector<std::vector<unsigned char>> faces(6, std::vector<unsigned char>(static_cast<size_t>(size) * size * 3));
+        auto buildRows = [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; ++row) {
+                int face = static_cast<int>(row / size), y = static_cast<int>(row % size);
+                for (int x = 0; x < size; ++x) {
+                    float sum[3] = {0.0f, 0.0f, 0.0f};
+                    for (int sy = 0; sy < samples; ++sy) {
+                        for (int sx = 0; sx < samples; ++sx) {
+                            float sc = 2.0f * (x + (sx + 0.5f) / samples) / size - 1.0f;
+                            float tc = 2.0f * (y + (sy + 0.5f) / samples) / size - 1.0f;
+                            float dir[3], colour[3];
+                            faceDirection(face, sc, tc, dir);
+                            float length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+                            // longitude 0 (the middle of the map) looks down -Z, latitude +90 (the top row) up +Y
+                            float u = (std::atan2(dir[0], -dir[2]) / (2.0f * pi) + 0.5f) * width;
+                            float v = std::acos(std::min(1.0f, std::max(-1.0f, dir[1] / length))) / pi * height;
+                            sample(rgb, width, height, u, v, colour);
+                            for (int i = 0; i < 3; ++i) sum[i] += colour[i];
+                        }
+                    }
+                    unsigned char *texel = &faces[face][(static_cast<size_t>(y) * size + x) * 3];
+                    for (int i = 0; i < 3; ++i) texel[i] = static_cast<unsigned char>(std::min(255.0f, sum[i] / (samples * samples) + 0.5f));
+                }
+            }
+        };
+        if (jobs) {
+            jobs->parallelFor(static_cast<size_t>(6) * size, buildRows);
+        } else {
+            buildRows(0, static_cast<size_t>(6) * size);
+        }
+
+        int32_t header[2] = {size, levelCount(size)};
+        std::vector<char> file(16);
+        std::memcpy(file.data(), "CUBEMAP1", 8);
+        std::memcpy(file.data() + 8, header, sizeof(header));
+
+        // append a level, then box filter every face down to the next one
+        for (int s = size; ; s /= 2) {
+            for (const std::vector<unsigned char> &face : faces) file.insert(file.end(), face.begin(), face.end());
+            if (s == 1) break;
+            int half = s / 2;
+            for (std::vector<unsigned char> &face : faces) {
+                std::vector<unsigned char> smaller(static_cast<size_t>(half) * half * 3);
+                for (int y = 0; y < half; ++y) {
+                    for (int x = 0; x < half; ++x) {
+                        for (int i = 0; i < 3; ++i) {
+                            int total = face[((y * 2) * s + x * 2) * 3 + i] + face[((y * 2) * s + x * 2 + 1) * 3 + i] +
+                                        face[((y * 2 + 1) * s + x * 2) * 3 + i] + face[((y * 2 + 1) * s + x * 2 + 1) * 3 + i];
+                            smaller[(y * half + x) * 3 + i] = static_cast<unsigned char>((total + 2) / 4);
+                        }
+                    }
+                }
+                face.swap(smaller);
+            }
+        }
+        return file;
+    }
+
+private:
+    // Bilinear sample of the map at (u, v) in texels, wrapping around in longitude and clamped at the poles
+    static void sample(const unsigned char *rgb, int width, int height, float u, float v, float out[3]) {
+        u -= 0.5f;
+        v = std::min(std::max(v - 0.5f, 0.0f), static_cast<float>(height - 1));
+        int x0 = static_cast<int>(std::floor(u)), y0 = static_cast<int>(v);
+        float fx = u - x0, fy = v - y0;
+        x0 = ((x0 % width) + width) % width;
+        int x1 = (x0 + 1) % width, y1 = std::min(y0 + 1, height - 1);
+        const unsigned char *a = &rgb[(static_cast<size_t>(y0) * width + x0) * 3];
+        const unsigned char *b = &rgb[(static_cast<size_t>(y0) * width + x1) * 3];
+        const unsigned char *c = &rgb[(static_cast<size_t>(y1) * width + x0) * 3];
+        const unsigned char *d = &rgb[(static_cast<size_t>(y1) * width + x1) * 3];
+        for (int i = 0; i < 3; ++i) {
+            out[i] = (a[i] * (1.0f - fx) + b[i] * fx) * (1.0f - fy) + (c[i] * (1.0f - fx) + d[i] * fx) * fy;
+        }
+    }
+
+    // World direction through (sc, tc) in -1..1 on a face, as OpenGL looks cubemaps up (+X, -X, +Y, -Y, +Z, -Z)
+    static void faceDirection(int face, float sc, float tc, float dir[3]) {
+        switch (face) {
+        case 0: dir[0] = 1.0f; dir[1] = -tc; dir[2] = -sc; break;
+        case 1: dir[0] = -1.0f; dir[1] = -tc; dir[2] = sc; break;
+        case 2: dir[0] = sc; dir[1] = 1.0f; dir[2] = tc; break;
+        case 3: dir[0] = sc; dir[1] = -1.0f; dir[2] = -tc; break;
+        case 4: dir[0] = sc; dir[1] = -tc; dir[2] = 1.0f; break;
+        default: dir[0] = -sc; dir[1] = -tc; dir[2] = -1.0f; break;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef DYNAMICRES_H
+#define DYNAMICRES_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+// Dynamic resolution: the scene is drawn into an offscreen colour + depth target at `scale` times the window size,
+// then stretched onto the window (bilinear, optionally sharpened). DynamicResolution picks the scale from the
+// measured GPU frame time; the offscreen textures are transients of the frame graph (framegraph.h), which keeps
+// them allocated while the scale changes, and PostProcess::upscale does the stretching.
+//
+// Usage (once per frame, on the GL thread):
+//   FrameGraph::TextureDesc scene{resolution.scaledSize(windowWidth), resolution.scaledSize(windowHeight), GL_RGBA8};
+//   ... passes drawing into graph.createTexture("scene colour", scene), an upscale pass onto the window ...
+//   resolution.update(gpuFrameMs);
+
+// Picks the render scale that keeps the GPU frame time just under a budget.
+// GPU cost grows with the pixel count (scale squared), so the next scale is scale * sqrt(budget / time).
+// Drops are applied at once, increases only when there is clear headroom and in small steps, and after a change
+// nothing happens until timings of frames drawn at the new scale arrive (the GPU profiler is a few frames late).
+class DynamicResolution {
+public:
+    static constexpr float MIN_SCALE = 0.5f;    // never below half the window size in each direction
+    static constexpr float STEP = 1.0f / 32.0f; // scales are rounded to this, small jitters don't change anything
+    static const int SETTLE_FRAMES = 4;         // GpuProfiler::FRAMES + 1
+
+    void setEnabled(bool on) {
+        enabled = on;
+        if (!on) scale = 1.0f;
+        settle = SETTLE_FRAMES;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    void setBudget(float milliseconds) { budgetMs = milliseconds; }
+    float getBudget() const { return budgetMs; }
+
+    // 0 = plain bilinear, 1 = strong sharpening (only used while the scale is below 1)
+    void setSharpness(float amount) { sharpness = std::max(0.0f, std::min(1.0f, amount)); }
+    float getSharpness() const { return scale < 1.0f ? sharpness : 0.0f; }
+
+    float getScale() const { return scale; }
+
+    // Size in pixels of the scene target for a window size (at least 1)
+    int scaledSize(int windowSize) const {
+        return std::max(1, static_cast<int>(static_cast<float>(windowSize) * scale + 0.5f));
+    }
+
+    // Feed the GPU time of a finished frame (0 = not measured yet). Returns true when the scale changed.
+    bool update(float gpuMs) {
+        if (!enabled || gpuMs <= 0.0f || budgetMs <= 0.0f) return false;
+        if (settle > 0) {
+            --settle;
+            averageMs = 0.0f;
+            return false;
+        }
+        averageMs = averageMs == 0.0f ? gpuMs : averageMs * 0.8f + gpuMs * 0.2f;
+
+        float ratio = budgetMs / averageMs;
+        if (ratio > 0.95f && ratio < 1.2f) return false; // close enough: leave it alone
+
+        float wanted = scale * std::sqrt(ratio);
+        wanted = std::min(wanted, scale * 1.1f);          // grow slowly, a drop in load may be short
+        wanted = std::round(wanted / STEP) * STEP;
+        wanted = std::max(MIN_SCALE, std::min(1.0f, wanted));
+        if (wanted == scale) return false;
+
+        scale = wanted;
+        settle = SETTLE_FRAMES;
+        ++changes;
+        return true;
+    }
+
+    unsigned long getChanges() const { return changes; }
+
+private:
+    bool enabled = false;
+    float budgetMs = 0.0f;
+    float sharpness = 0.4f;
+    float scale = 1.0f;
+    float averageMs = 0.0f; // GPU time since the last change (rolling average)
+    int settle = 0;
+    unsigned long changes = 0;
+};
+
+#endif
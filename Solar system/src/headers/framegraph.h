@@ -0,0 +1,606 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <vector>
+#include "gpuprofiler.h"
+
+// Frame graph: the frame is described as passes that declare which resources they read and write,
+// instead of a hand-ordered list of draws with framebuffers bound in between. Rebuilt every frame:
+//
+//   graph.reset();
+//   FrameGraph::Resource colour = graph.createTexture("scene colour", {width, height, GL_RGBA8});
+//   FrameGraph::Resource window = graph.importFramebuffer("window", 0, windowWidth, windowHeight);
+//   FrameGraph::PassBuilder scene = graph.addPass("scene", [&] { ... draw ... });
+//   colour = scene.write(colour);               // every write makes a new version of the resource
+//   FrameGraph::PassBuilder copy = graph.addPass("copy", [&] { ... sample graph.getTexture(colour) ... });
+//   copy.read(colour);
+//   window = copy.write(window);
+//   graph.markOutput(window);
+//   graph.compile();                            // order, cull, allocate
+//   graph.execute(&profiler);                   // binds each pass's framebuffer and viewport, then runs it
+//
+// compile():
+// - orders the passes so every version is written before it is read, and overwritten only after all its
+//   readers ran (ties keep the order the passes were added in);
+// - culls passes that contribute nothing to an output (or to a pass marked with sideEffect());
+// - gives every transient texture a pooled GL texture. Two transients with the same format whose lifetimes
+//   (first to last pass using them) don't overlap share one texture (OpenGL has no placement memory, so
+//   aliasing here means reusing the texture object). Pooled textures are rounded up to GRANULARITY pixels and
+//   kept across frames: they only grow when a frame needs more, and shrink after SHRINK_FRAMES frames of
+//   needing much less, so a size changing every frame (dynamic resolution) doesn't reallocate every frame.
+//   Passes only draw into / sample the used part (getUsedScale()).
+//
+// Passes must not change the framebuffer binding themselves.
+class FrameGraph {
+public:
+    static const int GRANULARITY = 64;
+    static const int SHRINK_FRAMES = 120;
+    static constexpr float SHRINK_BELOW = 0.75f; // of the allocated size, in both directions
+
+    // One version of a resource
+    struct Resource {
+        int index = -1;
+        int version = 0;
+        bool isValid() const { return index >= 0; }
+    };
+
+    struct TextureDesc {
+        int width = 0, height = 0;
+        GLenum format = GL_RGBA8; // sized internal format (depth formats become the depth attachment)
+    };
+
+    // Declares what a pass uses (returned by addPass)
+    class PassBuilder {
+    public:
+        // Samples the resource (or reads a buffer)
+        void read(Resource resource) { graph.addRead(pass, resource, false); }
+        // Uses the resource as a framebuffer attachment without writing it (e.g. depth test with depth writes off)
+        void readAttachment(Resource resource) { graph.addRead(pass, resource, true); }
+        // Draws into the resource (its attachment is bound for the pass). Returns the version later passes read.
+        Resource write(Resource resource) { return graph.addWrite(pass, resource); }
+        // Never culled: the pass has effects outside the graph
+        void sideEffect() { graph.passes[pass].sideEffect = true; }
+
+    private:
+        friend class FrameGraph;
+        PassBuilder(FrameGraph &graph, int pass) : graph(graph), pass(pass) {}
+        FrameGraph &graph;
+        int pass;
+    };
+
+    // Starts describing a new frame (the pooled textures are kept)
+    void reset() {
+        passes.clear();
+        resources.clear();
+        outputs.clear();
+        order.clear();
+    }
+
+    Resource createTexture(const char *name, const TextureDesc &desc) {
+        ResourceNode node;
+        node.name = name;
+        node.desc = desc;
+        return addResource(node);
+    }
+
+    // A framebuffer made outside the graph (e.g. the window's, 0): passes writing it bind it
+    Resource importFramebuffer(const char *name, GLuint framebuffer, int width, int height) {
+        ResourceNode node;
+        node.name = name;
+        node.imported = true;
+        node.hasFramebuffer = true;
+        node.framebuffer = framebuffer;
+        node.desc.width = width;
+        node.desc.height = height;
+        return addResource(node);
+    }
+
+    // Anything else made outside the graph (buffers, ...): only orders the passes, nothing gets bound
+    Resource importResource(const char *name) {
+        ResourceNode node;
+        node.name = name;
+        node.imported = true;
+        return addResource(node);
+    }
+
+    PassBuilder addPass(const char *name, std::function<void()> execute) {
+        PassNode pass;
+        pass.name = name;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+        return PassBuilder(*this, static_cast<int>(passes.size()) - 1);
+    }
+
+    // The passes producing this version (and everything they need) are kept
+    void markOutput(Resource resource) {
+        if (resource.isValid()) outputs.push_back(resource);
+    }
+
+    // Share textures between transients with disjoint lifetimes (default on)
+    void setAliasing(bool on) { aliasing = on; }
+    bool isAliasing() const { return aliasing; }
+
+    void compile() {
+        sortPasses();
+        cullPasses();
+        assignTextures();
+    }
+
+    // Runs the kept passes in order; each gets its GPU profiler scope (if `profiler` is given)
+    void execute(GpuProfiler *profiler = nullptr) {
+        framebufferBinds = 0;
+        GLuint bound = 0;
+        bool anyBound = false;
+        for (int index : order) {
+            PassNode &pass = passes[index];
+            if (!pass.needed) continue;
+
+            GLuint framebuffer = 0;
+            int width = 0, height = 0;
+            if (targetOf(pass, framebuffer, width, height) && (!anyBound || framebuffer != bound)) {
+                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+                glViewport(0, 0, width, height);
+                bound = framebuffer;
+                anyBound = true;
+                ++framebufferBinds;
+            }
+
+            if (profiler) profiler->push(pass.name);
+            pass.execute();
+            if (profiler) profiler->pop();
+        }
+    }
+
+    // ---- while executing ----
+
+    GLuint getTexture(Resource resource) const {
+        int physical = resources[resource.index].physical;
+        return physical >= 0 ? pool[physical].texture : 0;
+    }
+
+    // Size the resource was asked for (the part of the texture in use)
+    int getWidth(Resource resource) const { return resources[resource.index].desc.width; }
+    int getHeight(Resource resource) const { return resources[resource.index].desc.height; }
+
+    // Used part of the pooled texture in texture coordinates, and 1 / its full size
+    glm::vec2 getUsedScale(Resource resource) const {
+        const Physical *texture = physicalOf(resource);
+        if (!texture) return glm::vec2(1.0f);
+        return glm::vec2(static_cast<float>(getWidth(resource)) / texture->width,
+                         static_cast<float>(getHeight(resource)) / texture->height);
+    }
+
+    glm::vec2 getTexelSize(Resource resource) const {
+        const Physical *texture = physicalOf(resource);
+        if (!texture) return glm::vec2(1.0f / getWidth(resource), 1.0f / getHeight(resource));
+        return glm::vec2(1.0f / texture->width, 1.0f / texture->height);
+    }
+
+    bool isImported(Resource resource) const { return resources[resource.index].imported; }
+
+    // ---- statistics of the last compile() / execute() ----
+
+    int getPassCount() const { return static_cast<int>(passes.size()); }
+    int getCulledCount() const { return culled; }
+    int getTransientCount() const { return transients; }
+    int getTextureCount() const { return texturesUsed; } // pooled textures the transients went into
+    unsigned int getFramebufferBinds() const { return framebufferBinds; }
+    unsigned long getAllocations() const { return allocations; }
+
+    // Render target memory of this frame's transients: with aliasing (textures shared) or one texture each
+    size_t getTargetBytes(bool aliased) const { return aliased ? bytesAliased : bytesSeparate; }
+
+    void printSummary() const {
+        std::cout << "Frame graph: " << passes.size() - culled << " passes (" << culled << " culled), "
+                  << transients << " transient textures in " << texturesUsed << ", render targets "
+                  << bytesAliased / 1048576.0 << " MB (" << bytesSeparate / 1048576.0 << " MB without aliasing)"
+                  << (aliasing ? "" : ", aliasing off") << ", " << allocations << " allocations\n";
+    }
+
+    // Pass order, culled passes, and which texture each transient lives in over which passes
+    void printGraph() const {
+        std::cout << "Frame graph passes:\n";
+        for (size_t position = 0; position < order.size(); ++position) {
+            const PassNode &pass = passes[order[position]];
+            std::cout << "  " << position << ". " << pass.name << (pass.needed ? "" : " (culled)") << ":";
+            for (const Access &access : pass.reads) {
+                std::cout << " reads " << resources[access.resource.index].name << "#" << access.resource.version << ",";
+            }
+            for (const Resource &written : pass.writes) {
+                std::cout << " writes " << resources[written.index].name << "#" << written.version << ",";
+            }
+            std::cout << "\n";
+        }
+        std::cout << "Transient textures:\n";
+        for (const ResourceNode &node : resources) {
+            if (node.imported) continue;
+            std::cout << "  " << node.name << " " << node.desc.width << "x" << node.desc.height;
+            if (node.physical < 0) std::cout << ": unused\n";
+            else std::cout << ": passes " << node.firstUse << "-" << node.lastUse << ", texture " << node.physical << "\n";
+        }
+    }
+
+    void del() {
+        for (Target &target : targets) glDeleteFramebuffers(1, &target.framebuffer);
+        targets.clear();
+        for (Physical &texture : pool) {
+            if (texture.texture) glDeleteTextures(1, &texture.texture);
+        }
+        pool.clear();
+    }
+
+private:
+    struct Access {
+        Resource resource;
+        bool attachment = false;
+    };
+
+    struct PassNode {
+        const char *name = "";
+        std::function<void()> execute;
+        std::vector<Access> reads;
+        std::vector<Resource> writes; // the versions it makes
+        bool sideEffect = false;
+        bool needed = false;
+    };
+
+    struct ResourceNode {
+        const char *name = "";
+        TextureDesc desc;
+        bool imported = false;
+        bool hasFramebuffer = false;
+        GLuint framebuffer = 0;
+        std::vector<int> producers{-1}; // pass writing each version (version 0 exists before the frame)
+        std::vector<std::vector<int>> readers{{}};
+        int physical = -1;              // pooled texture
+        int firstUse = -1, lastUse = -1; // positions in the pass order
+    };
+
+    // A pooled GL texture
+    struct Physical {
+        GLuint texture = 0;
+        GLenum format = 0;
+        int width = 0, height = 0;       // allocated
+        int neededWidth = 0, neededHeight = 0; // largest use this frame
+        int busyUntil = -1;              // last pass position using it this frame
+        bool used = false;
+        int smallFrames = 0;             // frames in a row it was much bigger than needed
+        int unusedFrames = 0;
+    };
+
+    // Framebuffer for one combination of attachments
+    struct Target {
+        GLuint framebuffer = 0;
+        std::vector<GLuint> attachments; // colour textures, then the depth texture (or 0)
+    };
+
+    std::vector<PassNode> passes;
+    std::vector<ResourceNode> resources;
+    std::vector<Resource> outputs;
+    std::vector<int> order;              // pass indices, sorted
+    std::vector<Physical> pool;
+    std::vector<Target> targets;
+    bool aliasing = true;
+    int culled = 0, transients = 0, texturesUsed = 0;
+    size_t bytesAliased = 0, bytesSeparate = 0;
+    unsigned int framebufferBinds = 0;
+    unsigned long allocations = 0;
+    bool cycleReported = false;
+
+    Resource addResource(const ResourceNode &node) {
+        resources.push_back(node);
+        Resource resource;
+        resource.index = static_cast<int>(resources.size()) - 1;
+        return resource;
+    }
+
+    void addRead(int pass, Resource resource, bool attachment) {
+        if (!resource.isValid()) return;
+        Access access;
+        access.resource = resource;
+        access.attachment = attachment;
+        passes[pass].reads.push_back(access);
+        resources[resource.index].readers[resource.version].push_back(pass);
+    }
+
+    Resource addWrite(int pass, Resource resource) {
+        if (!resource.isValid()) return resource;
+        ResourceNode &node = resources[resource.index];
+        if (resource.version != static_cast<int>(node.producers.size()) - 1) {
+            std::cout << "Frame graph: pass " << passes[pass].name << " writes an old version of " << node.name << "\n";
+        }
+        node.producers.push_back(pass);
+        node.readers.emplace_back();
+        Resource written;
+        written.index = resource.index;
+        written.version = static_cast<int>(node.producers.size()) - 1;
+        passes[pass].writes.push_back(written);
+        return written;
+    }
+
+    int producer(Resource resource) const { return resources[resource.index].producers[resource.version]; }
+
+    // Kahn's algorithm; among passes that are ready, the one added first goes first
+    void sortPasses() {
+        int count = static_cast<int>(passes.size());
+        std::vector<std::vector<int>> next(count);
+        std::vector<int> incoming(count, 0);
+        auto edge = [&](int from, int to) {
+            if (from < 0 || from == to) return;
+            next[from].push_back(to);
+            ++incoming[to];
+        };
+        for (int pass = 0; pass < count; ++pass) {
+            for (const Access &access : passes[pass].reads) edge(producer(access.resource), pass);
+            for (const Resource &written : passes[pass].writes) {
+                Resource previous = written;
+                --previous.version;
+                edge(producer(previous), pass);                        // writes happen in version order
+                for (int reader : resources[written.index].readers[previous.version]) edge(reader, pass); // after the old version's readers
+            }
+        }
+
+        std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+        for (int pass = 0; pass < count; ++pass) {
+            if (incoming[pass] == 0) ready.push(pass);
+        }
+        while (!ready.empty()) {
+            int pass = ready.top();
+            ready.pop();
+            order.push_back(pass);
+            for (int after : next[pass]) {
+                if (--incoming[after] == 0) ready.push(after);
+            }
+        }
+
+        if (static_cast<int>(order.size()) != count) {
+            if (!cycleReported) std::cout << "Frame graph: passes depend on each other in a cycle, using the order they were added in\n";
+            cycleReported = true;
+            order.clear();
+            for (int pass = 0; pass < count; ++pass) order.push_back(pass);
+        }
+    }
+
+    // Keeps what the outputs and side-effect passes need
+    void cullPasses() {
+        std::vector<int> stack;
+        for (const Resource &output : outputs) stack.push_back(producer(output));
+        for (int pass = 0; pass < static_cast<int>(passes.size()); ++pass) {
+            if (passes[pass].sideEffect) stack.push_back(pass);
+        }
+        while (!stack.empty()) {
+            int pass = stack.back();
+            stack.pop_back();
+            if (pass < 0 || passes[pass].needed) continue;
+            passes[pass].needed = true;
+            for (const Access &access : passes[pass].reads) stack.push_back(producer(access.resource));
+            for (const Resource &written : passes[pass].writes) { // drawing on top needs what was there
+                Resource previous = written;
+                --previous.version;
+                stack.push_back(producer(previous));
+            }
+        }
+        culled = 0;
+        for (const PassNode &pass : passes) {
+            if (!pass.needed) ++culled;
+        }
+    }
+
+    static int roundUp(int size) { return (size + GRANULARITY - 1) / GRANULARITY * GRANULARITY; }
+
+    static size_t bytesPerPixel(GLenum format) {
+        switch (format) {
+        case GL_R8: return 1;
+        case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+        case GL_RGB8: return 3;
+        case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8: return 8;
+        case GL_RGBA32F: return 16;
+        default: return 4; // RGBA8, R32F, RG16F, R11F_G11F_B10F, DEPTH24_STENCIL8, DEPTH_COMPONENT24 / 32F
+        }
+    }
+
+    static bool isDepth(GLenum format) {
+        return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8 || format == GL_DEPTH_COMPONENT16 ||
+               format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F;
+    }
+
+    static bool hasStencil(GLenum format) { return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8; }
+
+    const Physical *physicalOf(Resource resource) const {
+        int physical = resources[resource.index].physical;
+        return physical >= 0 ? &pool[physical] : nullptr;
+    }
+
+    void assignTextures() {
+        // lifetimes over the kept passes
+        for (size_t position = 0; position < order.size(); ++position) {
+            const PassNode &pass = passes[order[position]];
+            if (!pass.needed) continue;
+            auto use = [&](Resource resource) {
+                ResourceNode &node = resources[resource.index];
+                if (node.firstUse < 0) node.firstUse = static_cast<int>(position);
+                node.lastUse = static_cast<int>(position);
+            };
+            for (const Access &access : pass.reads) use(access.resource);
+            for (const Resource &written : pass.writes) use(written);
+        }
+
+        std::vector<int> byFirstUse;
+        for (int index = 0; index < static_cast<int>(resources.size()); ++index) {
+            if (!resources[index].imported && resources[index].firstUse >= 0) byFirstUse.push_back(index);
+        }
+        std::stable_sort(byFirstUse.begin(), byFirstUse.end(),
+                         [&](int a, int b) { return resources[a].firstUse < resources[b].firstUse; });
+
+        for (Physical &texture : pool) {
+            texture.used = false;
+            texture.busyUntil = -1;
+            texture.neededWidth = texture.neededHeight = 0;
+        }
+        transients = static_cast<int>(byFirstUse.size());
+        bytesSeparate = 0;
+        for (int index : byFirstUse) {
+            ResourceNode &node = resources[index];
+            int chosen = -1;
+            for (int i = 0; i < static_cast<int>(pool.size()) && chosen < 0; ++i) {
+                const Physical &texture = pool[i];
+                if (texture.format != node.desc.format) continue;
+                if (aliasing ? texture.busyUntil < node.firstUse : !texture.used) chosen = i;
+            }
+            if (chosen < 0) {
+                Physical texture;
+                texture.format = node.desc.format;
+                pool.push_back(texture);
+                chosen = static_cast<int>(pool.size()) - 1;
+            }
+            Physical &texture = pool[chosen];
+            texture.used = true;
+            texture.busyUntil = node.lastUse;
+            texture.neededWidth = std::max(texture.neededWidth, node.desc.width);
+            texture.neededHeight = std::max(texture.neededHeight, node.desc.height);
+            node.physical = chosen;
+            bytesSeparate += static_cast<size_t>(roundUp(node.desc.width)) * roundUp(node.desc.height) * bytesPerPixel(node.desc.format);
+        }
+
+        texturesUsed = 0;
+        bytesAliased = 0;
+        for (Physical &texture : pool) {
+            if (texture.used) {
+                ++texturesUsed;
+                texture.unusedFrames = 0;
+                reserve(texture);
+                bytesAliased += static_cast<size_t>(roundUp(texture.neededWidth)) * roundUp(texture.neededHeight) * bytesPerPixel(texture.format);
+            } else if (texture.texture && ++texture.unusedFrames >= SHRINK_FRAMES) {
+                release(texture); // e.g. aliasing turned back on, or bloom turned off
+            }
+        }
+    }
+
+    // Same hysteresis as the window size: grow at once, shrink only after a while
+    void reserve(Physical &texture) {
+        int width = texture.neededWidth, height = texture.neededHeight;
+        if (width > texture.width || height > texture.height) {
+            allocate(texture, std::max(roundUp(width), texture.width), std::max(roundUp(height), texture.height));
+            return;
+        }
+        bool small = width < texture.width * SHRINK_BELOW && height < texture.height * SHRINK_BELOW;
+        texture.smallFrames = small ? texture.smallFrames + 1 : 0;
+        if (texture.smallFrames >= SHRINK_FRAMES) allocate(texture, roundUp(width), roundUp(height));
+    }
+
+    void allocate(Physical &texture, int width, int height) {
+        release(texture);
+        texture.width = width;
+        texture.height = height;
+        texture.smallFrames = 0;
+        ++allocations;
+
+        glGenTextures(1, &texture.texture);
+        glBindTexture(GL_TEXTURE_2D, texture.texture);
+        if (isDepth(texture.format)) {
+            GLenum format = hasStencil(texture.format) ? GL_DEPTH_STENCIL : GL_DEPTH_COMPONENT;
+            GLenum type = texture.format == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8
+                        : texture.format == GL_DEPTH32F_STENCIL8 ? GL_FLOAT_32_UNSIGNED_INT_24_8_REV : GL_FLOAT;
+            glTexImage2D(GL_TEXTURE_2D, 0, texture.format, width, height, 0, format, type, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        } else {
+            // the format / type only describe the (absent) upload data
+            glTexImage2D(GL_TEXTURE_2D, 0, texture.format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void release(Physical &texture) {
+        if (!texture.texture) return;
+        // framebuffers using it go too (its name can come back for a new texture)
+        for (size_t i = 0; i < targets.size();) {
+            const std::vector<GLuint> &attachments = targets[i].attachments;
+            if (std::find(attachments.begin(), attachments.end(), texture.texture) != attachments.end()) {
+                glDeleteFramebuffers(1, &targets[i].framebuffer);
+                targets.erase(targets.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+        glDeleteTextures(1, &texture.texture);
+        texture.texture = 0;
+        texture.width = texture.height = 0;
+    }
+
+    // Framebuffer and viewport a pass draws into; false if it draws into nothing (compute, buffers only)
+    bool targetOf(const PassNode &pass, GLuint &framebuffer, int &width, int &height) {
+        std::vector<GLuint> attachments; // colour..., depth
+        GLuint depth = 0;
+        bool found = false;
+        auto attach = [&](Resource resource) {
+            const ResourceNode &node = resources[resource.index];
+            if (node.hasFramebuffer) {
+                framebuffer = node.framebuffer;
+                width = node.desc.width;
+                height = node.desc.height;
+                found = true;
+                return;
+            }
+            if (node.imported || node.physical < 0) return;
+            GLuint texture = pool[node.physical].texture;
+            if (isDepth(node.desc.format)) depth = texture;
+            else if (std::find(attachments.begin(), attachments.end(), texture) == attachments.end()) attachments.push_back(texture);
+            if (attachments.size() + (depth ? 1 : 0) == 1) {
+                width = node.desc.width;
+                height = node.desc.height;
+            }
+        };
+        for (const Resource &written : pass.writes) attach(written);
+        for (const Access &access : pass.reads) {
+            if (access.attachment) attach(access.resource);
+        }
+        if (found) return true; // an imported framebuffer wins
+        if (attachments.empty() && !depth) return false;
+        attachments.push_back(depth);
+        framebuffer = targetFor(attachments);
+        return true;
+    }
+
+    GLuint targetFor(const std::vector<GLuint> &attachments) {
+        for (const Target &target : targets) {
+            if (target.attachments == attachments) return target.framebuffer;
+        }
+        Target target;
+        target.attachments = attachments;
+        glGenFramebuffers(1, &target.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (size_t i = 0; i + 1 < attachments.size(); ++i) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i), GL_TEXTURE_2D, attachments[i], 0);
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i));
+        }
+        GLuint depth = attachments.back();
+        if (depth) {
+            GLenum format = GL_DEPTH_ATTACHMENT;
+            for (const Physical &texture : pool) {
+                if (texture.texture == depth && hasStencil(texture.format)) format = GL_DEPTH_STENCIL_ATTACHMENT;
+            }
+            glFramebufferTexture2D(GL_FRAMEBUFFER, format, GL_TEXTURE_2D, depth, 0);
+        }
+        if (drawBuffers.empty()) glDrawBuffer(GL_NONE);
+        else glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Frame graph: framebuffer with " << attachments.size() - 1 << " colour attachments incomplete!\n";
+        }
+        targets.push_back(target);
+        return target.framebuffer;
+    }
+};
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <time.h>
+#endif
+
+// Frame pacing: decides when each frame is presented and measures how evenly that happens.
+//
+// Modes:
+//   Uncapped       swap interval 0, as fast as possible (pins a core, uneven frame times)
+//   VSync          swap interval 1, the driver blocks in swapBuffers until the display refresh
+//   AdaptiveVSync  swap interval -1 (EXT_swap_control_tear): vsync, but a late frame tears instead of waiting a whole refresh
+//   Limiter        swap interval 0 plus a software limiter: sleep most of the wait, spin the last part for precision
+//
+// Usage per frame:
+//   ... draw ...
+//   pacer.waitForPresent();   // limiter waits here (do late input work after this)
+//   window.swapBuffers();
+//   pacer.presented();        // present-to-present timing
+class FramePacer {
+public:
+    enum Mode { Uncapped, VSync, AdaptiveVSync, Limiter, ModeCount };
+
+    struct Stats {
+        size_t frames = 0;
+        double meanMs = 0.0;
+        double jitterMs = 0.0; // standard deviation of present-to-present time
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+        double cpuUsage = 0.0; // process CPU time / wall time (1.0 = one core fully busy)
+    };
+
+    FramePacer() {
+#ifdef _WIN32
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0600
+        timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+        if (!timer) timer = CreateWaitableTimerW(nullptr, TRUE, nullptr); // before Windows 10 1803 (coarser)
+#endif
+        resetStats();
+    }
+
+    ~FramePacer() {
+#ifdef _WIN32
+        if (timer) CloseHandle(timer);
+#endif
+    }
+
+    FramePacer(const FramePacer &) = delete;
+    FramePacer &operator=(const FramePacer &) = delete;
+
+    // Needs the window's OpenGL context to be current. targetFps is used by Limiter (0 = monitor refresh rate,
+    // main thread only).
+    void setMode(Mode newMode, double targetFps = 0.0) {
+        if (targetFps <= 0.0) targetFps = getRefreshRate();
+        frameSeconds = 1.0 / targetFps;
+
+        if (newMode == AdaptiveVSync && !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+            !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+            std::cout << "Adaptive vsync (EXT_swap_control_tear) not supported, using vsync\n";
+            newMode = VSync;
+        }
+        mode = newMode;
+
+        switch (mode) {
+        case VSync:         glfwSwapInterval(1); break;
+        case AdaptiveVSync: glfwSwapInterval(-1); break;
+        default:            glfwSwapInterval(0); break;
+        }
+        deadline = Clock::now();
+        resetStats();
+    }
+
+    // Primary monitor refresh rate (60 if unknown). GLFW only allows monitor queries on the main thread.
+    static double getRefreshRate() {
+        const GLFWvidmode *videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        return videoMode && videoMode->refreshRate > 0 ? videoMode->refreshRate : 60.0;
+    }
+
+    Mode getMode() const { return mode; }
+    double getTargetFps() const { return 1.0 / frameSeconds; }
+
+    static const char *getModeName(Mode m) {
+        switch (m) {
+        case Uncapped:      return "uncapped";
+        case VSync:         return "vsync";
+        case AdaptiveVSync: return "adaptive vsync";
+        case Limiter:       return "limiter";
+        default:            return "?";
+        }
+    }
+
+    // Limiter: returns at the next frame deadline. Sleeps while the deadline is further away than the
+    // measured sleep inaccuracy, then spins the rest. Other modes return immediately.
+    void waitForPresent() {
+        if (mode != Limiter) return;
+
+        Clock::time_point now = Clock::now();
+        deadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frameSeconds));
+        if (deadline < now) {
+            deadline = now; // more than a frame late: start again from now instead of rushing to catch up
+            return;
+        }
+
+        double remaining = seconds(deadline - now);
+        if (remaining > spinMargin) {
+            double requested = remaining - spinMargin;
+            Clock::time_point sleepStart = Clock::now();
+            sleepFor(requested);
+            double oversleep = seconds(Clock::now() - sleepStart) - requested;
+            // keep the margin just above the worst recent oversleep (decays slowly when sleeps get accurate)
+            spinMargin = std::min(0.004, std::max(std::max(oversleep * 1.25, 0.0002), spinMargin * 0.98));
+        }
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Call right after swapBuffers
+    void presented() {
+        Clock::time_point now = Clock::now();
+        if (hasPresented) {
+            intervals.push_back(seconds(now - lastPresent) * 1000.0);
+        }
+        lastPresent = now;
+        hasPresented = true;
+    }
+
+    Stats getStats() const {
+        Stats stats;
+        stats.frames = intervals.size();
+        double wall = seconds(Clock::now() - statsStart);
+        stats.cpuUsage = wall > 0.0 ? (processCpuSeconds() - cpuStart) / wall : 0.0;
+        if (intervals.empty()) return stats;
+
+        double total = 0.0;
+        for (double ms : intervals) total += ms;
+        stats.meanMs = total / intervals.size();
+        double variance = 0.0;
+        for (double ms : intervals) variance += (ms - stats.meanMs) * (ms - stats.meanMs);
+        stats.jitterMs = std::sqrt(variance / intervals.size());
+
+        std::vector<double> sorted = intervals;
+        std::sort(sorted.begin(), sorted.end());
+        stats.p99Ms = sorted[std::min(sorted.size() - 1, static_cast<size_t>(sorted.size() * 0.99))];
+        stats.maxMs = sorted.back();
+        return stats;
+    }
+
+    void resetStats() {
+        intervals.clear();
+        hasPresented = false;
+        statsStart = Clock::now();
+        cpuStart = processCpuSeconds();
+    }
+
+    void printReport() const {
+        Stats stats = getStats();
+        std::cout << "Frame pacing (" << getModeName(mode);
+        if (mode == Limiter) std::cout << " " << getTargetFps() << " fps";
+        std::cout << "): " << stats.frames << " frames, " << stats.meanMs << " ms mean, jitter " << stats.jitterMs
+                  << " ms, p99 " << stats.p99Ms << " ms, max " << stats.maxMs << " ms, CPU " << stats.cpuUsage * 100.0 << "%\n";
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Mode mode = Uncapped;
+    double frameSeconds = 1.0 / 60.0;
+    double spinMargin = 0.001;    // seconds spun before each deadline, adapts to the OS sleep accuracy
+    Clock::time_point deadline;
+    Clock::time_point lastPresent;
+    bool hasPresented = false;
+    std::vector<double> intervals; // present-to-present, milliseconds
+    Clock::time_point statsStart;
+    double cpuStart = 0.0;
+#ifdef _WIN32
+    HANDLE timer = nullptr;
+#endif
+
+    static double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+    void sleepFor(double secs) {
+#ifdef _WIN32
+        // the default Sleep granularity is ~15.6 ms, a (high resolution) waitable timer is far more precise
+        if (timer) {
+            LARGE_INTEGER due;
+            due.QuadPart = -static_cast<LONGLONG>(secs * 1e7); // negative = relative, 100 ns units
+            if (SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(timer, INFINITE);
+                return;
+            }
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::duration<double>(secs));
+    }
+
+    // CPU time used by this process (all threads), seconds
+    static double processCpuSeconds() {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+        auto toSeconds = [](const FILETIME &t) {
+            return static_cast<double>((static_cast<unsigned long long>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+        };
+        return toSeconds(kernel) + toSeconds(user);
+#else
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+    }
+};
+
+#endif
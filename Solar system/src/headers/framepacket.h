@@ -0,0 +1,35 @@
+#ifndef FRAMEPACKET_H
+#define FRAMEPACKET_H
+
+#include "glm/glm.hpp"
+#include "camerabuffer.h"
+#include <vector>
+
+// One body to draw: its world matrix, diffuse texture and which body it is
+struct DrawItem {
+    glm::mat4 model;
+    unsigned int texture = 0;
+    int body = -1; // index of the body in the scene (GPU profiler pass name)
+};
+
+// Everything the renderer needs to draw one frame, built by the simulation (main) thread.
+// It holds copies only (no pointers into the scene), so the simulation can move on to the next frame
+// while the render thread is still drawing this one. The vectors keep their capacity when a packet is reused.
+struct FramePacket {
+    unsigned long frame = 0;     // sequence number, set by RenderThread::submit
+    double time = 0.0;           // simulation time (seconds) the bodies were positioned at
+    double inputTime = 0.0;      // oldest input shown by this frame's camera, 0 = none (input latency)
+    float simMs = 0.0f;          // CPU time spent building the packet (frame statistics)
+    CameraBlock camera;          // view / projection / position
+    float fov = 45.0f;           // degrees, particle point size
+    int viewportWidth = 1200;    // pixels of the framebuffer the frame ends up in (the window)
+    int viewportHeight = 800;
+    glm::vec3 lightPos = glm::vec3(0.0f);
+    std::vector<DrawItem> suns;   // emissive bodies, drawn with the light shader
+    std::vector<DrawItem> bodies; // lit bodies (planets, moon, ring), after frustum and occlusion culling
+    unsigned int frustumCulled = 0;   // bodies left out because they are off screen
+    unsigned int occlusionCulled = 0; // bodies left out because they are hidden behind others
+    int occluders = 0;                // bodies the occlusion test used as occluders
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Work one frame sent to OpenGL, as counted by the renderer
+struct RenderCounters {
+    unsigned int drawCalls = 0;    // draws and compute dispatches
+    uint64_t triangles = 0;        // 64 bits: a million bodies of a few thousand triangles overflow 32
+    // Program, vertex array, texture, buffer, framebuffer and fixed-function state changes, counted from the real
+    // GL calls by GlTrace (gltrace::Counters::stateChanges). -1 = not counted (GlTrace not installed).
+    int stateChanges = -1;
+    unsigned int frustumCulled = 0;   // bodies skipped because they are off screen
+    unsigned int occlusionCulled = 0; // bodies skipped because a bigger one hides them (OcclusionCuller)
+};
+
+// One frame's measurements
+struct FrameSample {
+    double time = 0.0;       // when the frame was presented (seconds)
+    float frameMs = 0.0f;    // present to present
+    float simMs = 0.0f;      // CPU: input, simulation, culling and packet building
+    float renderMs = 0.0f;   // CPU: issuing the GL calls
+    float gpuMs = 0.0f;      // GPU time of the whole frame (from the GPU profiler, a few frames late)
+    RenderCounters counters;
+};
+
+// Per-frame statistics recorder.
+// Keeps the last `capacity` frames in a ring buffer (nothing is allocated while recording), computes
+// percentiles and stutter counts over them and writes them to CSV (one row per frame) or JSON (summary + frames).
+// Comparing two runs is then a diff of two files.
+//
+// A stutter is a frame that took more than twice the median frame time,
+// a hitch one longer than 50 ms (visible as a freeze at any frame rate).
+// The frame time histogram has 1 ms buckets up to 100 ms and one overflow bucket, so two runs can be compared
+// bucket by bucket (a percentile hides whether slow frames are spread out or bunched at one time).
+class FrameStats {
+public:
+    static const int HISTOGRAM_BUCKETS = 100; // 1 ms each
+    static constexpr double BUCKET_MS = 1.0;
+
+    struct Summary {
+        double mean = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+    };
+
+    // counts[i] = frames that took i to i + 1 ms, overflow = frames of 100 ms or more
+    struct Histogram {
+        std::vector<size_t> counts = std::vector<size_t>(HISTOGRAM_BUCKETS, 0);
+        size_t overflow = 0;
+    };
+
+    explicit FrameStats(size_t capacity = 36000) : samples(capacity) {} // 10 minutes at 60 fps
+
+    void record(const FrameSample &sample) {
+        if (samples.empty()) return;
+        samples[next] = sample;
+        next = (next + 1) % samples.size();
+        if (count < samples.size()) ++count;
+        ++total;
+    }
+
+    size_t getCount() const { return count; }           // frames kept
+    unsigned long getTotal() const { return total; }    // frames recorded (including overwritten ones)
+    void clear() { next = 0; count = 0; total = 0; }
+
+    // i = 0 is the oldest frame kept
+    const FrameSample &getSample(size_t i) const {
+        return samples[(next + samples.size() - count + i) % samples.size()];
+    }
+
+    // Statistics of one field, e.g. summarize(&FrameSample::frameMs)
+    Summary summarize(float FrameSample::*field) const {
+        std::vector<double> values;
+        values.reserve(count);
+        for (size_t i = 0; i < count; ++i) values.push_back(getSample(i).*field);
+        return summarizeValues(values);
+    }
+
+    template <typename T>
+    Summary summarize(T RenderCounters::*field) const {
+        std::vector<double> values;
+        values.reserve(count);
+        for (size_t i = 0; i < count; ++i) values.push_back(getSample(i).counters.*field);
+        return summarizeValues(values);
+    }
+
+    // true if every frame kept has its state changes counted (GlTrace was installed)
+    bool hasStateChanges() const {
+        for (size_t i = 0; i < count; ++i) {
+            if (getSample(i).counters.stateChanges < 0) return false;
+        }
+        return count > 0;
+    }
+
+    // Input latency of the run (LatencyTracker, milliseconds), written to the JSON next to the frame times.
+    // samples = frames it was measured on; never set = no input was measured, written as null
+    void setInputLatency(const Summary &latency, size_t samples) {
+        inputLatency = latency;
+        inputLatencySamples = samples;
+        hasInputLatency = true;
+    }
+
+    size_t getStutterCount() const {
+        double limit = summarize(&FrameSample::frameMs).p50 * 2.0;
+        return countFramesOver(limit);
+    }
+
+    size_t getHitchCount() const { return countFramesOver(50.0); }
+
+    // Frame times of the frames kept, bucketed (built on demand, nothing is counted while recording)
+    Histogram getHistogram() const {
+        Histogram histogram;
+        for (size_t i = 0; i < count; ++i) {
+            double bucket = getSample(i).frameMs / BUCKET_MS;
+            if (bucket >= HISTOGRAM_BUCKETS) ++histogram.overflow;
+            else ++histogram.counts[static_cast<size_t>(std::max(0.0, bucket))];
+        }
+        return histogram;
+    }
+
+    void printReport() const {
+        Summary frame = summarize(&FrameSample::frameMs);
+        std::cout << "Frame stats (" << count << " frames): frame p50 " << frame.p50 << " ms, p90 " << frame.p90
+                  << " ms, p99 " << frame.p99 << " ms, max " << frame.max << " ms, sim " << summarize(&FrameSample::simMs).mean
+                  << " ms, render " << summarize(&FrameSample::renderMs).mean << " ms, GPU " << summarize(&FrameSample::gpuMs).mean
+                  << " ms, " << getStutterCount() << " stutters, " << getHitchCount() << " hitches, culled "
+                  << summarize(&RenderCounters::frustumCulled).mean << " off screen / "
+                  << summarize(&RenderCounters::occlusionCulled).mean << " hidden\n";
+
+        // only the buckets with frames in them, e.g. "16-17 ms 290, 33-34 ms 8, >= 100 ms 2"
+        Histogram histogram = getHistogram();
+        std::cout << "Frame time histogram:";
+        const char *separator = " ";
+        for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            if (histogram.counts[i] == 0) continue;
+            std::cout << separator << i * BUCKET_MS << "-" << (i + 1) * BUCKET_MS << " ms " << histogram.counts[i];
+            separator = ", ";
+        }
+        if (histogram.overflow) std::cout << separator << ">= " << HISTOGRAM_BUCKETS * BUCKET_MS << " ms " << histogram.overflow;
+        std::cout << "\n";
+    }
+
+    bool writeCsv(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "FrameStats: cannot write " << path << "\n";
+            return false;
+        }
+        out << "frame,time,frame_ms,sim_ms,render_ms,gpu_ms,draw_calls,triangles,state_changes,frustum_culled,occlusion_culled\n";
+        for (size_t i = 0; i < count; ++i) {
+            const FrameSample &s = getSample(i);
+            out << (total - count + i) << "," << s.time << "," << s.frameMs << "," << s.simMs << "," << s.renderMs << ","
+                << s.gpuMs << "," << s.counters.drawCalls << "," << s.counters.triangles << ",";
+            if (s.counters.stateChanges >= 0) out << s.counters.stateChanges; // empty when not counted
+            out << "," << s.counters.frustumCulled << "," << s.counters.occlusionCulled << "\n";
+        }
+        return true;
+    }
+
+    // Summary of every field, plus the frame times themselves (for plotting)
+    bool writeJson(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "FrameStats: cannot write " << path << "\n";
+            return false;
+        }
+        out << "{\n  \"frames\": " << count << ",\n  \"stutters\": " << getStutterCount()
+            << ",\n  \"hitches\": " << getHitchCount();
+        writeSummary(out, "frame_ms", summarize(&FrameSample::frameMs));
+        writeSummary(out, "sim_ms", summarize(&FrameSample::simMs));
+        writeSummary(out, "render_ms", summarize(&FrameSample::renderMs));
+        writeSummary(out, "gpu_ms", summarize(&FrameSample::gpuMs));
+        writeSummary(out, "draw_calls", summarize(&RenderCounters::drawCalls));
+        writeSummary(out, "triangles", summarize(&RenderCounters::triangles));
+        if (hasStateChanges()) writeSummary(out, "state_changes", summarize(&RenderCounters::stateChanges));
+        else out << ",\n  \"state_changes\": null"; // GlTrace not installed
+        writeSummary(out, "frustum_culled", summarize(&RenderCounters::frustumCulled));
+        writeSummary(out, "occlusion_culled", summarize(&RenderCounters::occlusionCulled));
+        if (hasInputLatency) {
+            writeSummary(out, "input_latency_ms", inputLatency);
+            out << ",\n  \"input_latency_samples\": " << inputLatencySamples;
+        } else {
+            out << ",\n  \"input_latency_ms\": null";
+        }
+        Histogram histogram = getHistogram();
+        out << ",\n  \"frame_ms_histogram\": {\"bucket_ms\": " << BUCKET_MS << ", \"counts\": [";
+        for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) out << (i ? ", " : "") << histogram.counts[i];
+        out << "], \"overflow\": " << histogram.overflow << "}";
+        out << ",\n  \"frame_ms_series\": [";
+        for (size_t i = 0; i < count; ++i) out << (i ? ", " : "") << getSample(i).frameMs;
+        out << "]\n}\n";
+        return true;
+    }
+
+private:
+    std::vector<FrameSample> samples;
+    size_t next = 0;
+    size_t count = 0;
+    unsigned long total = 0;
+    Summary inputLatency;
+    size_t inputLatencySamples = 0;
+    bool hasInputLatency = false;
+
+    size_t countFramesOver(double limitMs) const {
+        size_t frames = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (getSample(i).frameMs > limitMs) ++frames;
+        }
+        return frames;
+    }
+
+    static Summary summarizeValues(std::vector<double> &values) {
+        Summary summary;
+        if (values.empty()) return summary;
+        double sum = 0.0;
+        for (double v : values) sum += v;
+        summary.mean = sum / values.size();
+        std::sort(values.begin(), values.end());
+        auto at = [&](double p) { return values[std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5))]; };
+        summary.p50 = at(0.5);
+        summary.p90 = at(0.9);
+        summary.p99 = at(0.99);
+        summary.max = values.back();
+        return summary;
+    }
+
+    static void writeSummary(std::ofstream &out, const char *name, const Summary &s) {
+        out << ",\n  \"" << name << "\": {\"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90
+            << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+    }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "glm/glm.hpp"
+
+// View frustum as 6 planes (left, right, bottom, top, near, far) pulled straight out of projection * view.
+// Plane normals point inwards, so a point is inside when dot(plane.xyz, p) + plane.w >= 0 for all planes.
+class Frustum {
+public:
+    glm::vec4 planes[6];
+
+    Frustum() {}
+
+    explicit Frustum(const glm::mat4 &viewProjection) {
+        // glm is column-major: row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+        const glm::mat4 &m = viewProjection;
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        planes[0] = row3 + row0; // left
+        planes[1] = row3 - row0; // right
+        planes[2] = row3 + row1; // bottom
+        planes[3] = row3 - row1; // top
+        planes[4] = row3 + row2; // near
+        planes[5] = row3 - row2; // far
+
+        // normalise so the plane distance is in world units (needed for the sphere radius test)
+        for (glm::vec4 &plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    // true if any part of the sphere can be on screen
+    bool sphereVisible(const glm::vec3 &center, float radius) const {
+        for (const glm::vec4 &plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,1415 @@
+#ifndef GLCAPTURE_H
+#define GLCAPTURE_H
+
+// OpenGL command capture and replay.
+//
+// GlCapture swaps glad's function pointers (like GlTrace) for wrappers that write every GL call, with the buffer,
+// texture, shader and uniform data it points to, into a binary trace file. GlReplay reads the file back and
+// issues the same calls, frame by frame, on any context (replay_trace.cpp runs it headless as fast as possible),
+// so the renderer's GL work can be timed without the simulation, and a slow frame can be shared as one file.
+//
+//   GlCapture::start("frames.glcap", width, height, defaultFramebuffer, 100, 110); // right after gladLoadGLLoader
+//   ... create everything, draw frames, GlCapture::endFrame() after each ...      // stops itself after 110 frames
+//
+// A trace records everything from start() on: resources are created in the trace exactly like the application
+// created them, so there is no state to snapshot. Frames before the range asked for are marked as warm-up,
+// the replay runs them without timing them. Object names (buffers, textures, programs, ...), uniform locations
+// and sync objects are remapped on replay, so the trace does not depend on the driver handing out the same ones.
+//
+// Data written through mapped buffers is no GL call: while a buffer is mapped it is compared with a copy before
+// every call and the changed bytes are recorded at that point. Getters (glGetIntegerv, info logs, ...) are left
+// out, their results are already baked into the calls that followed. Functions taking pointers this file does not
+// know how to size are not recorded (listed when the capture stops).
+//
+// Data of BLOB_MIN_SIZE bytes or more (textures, vertex buffers, big mapped writes) is not written into the call's
+// record: it goes into a blob record of its own, zlib-compressed, and the call refers to the blob by number.
+// Identical data is stored once (blobs are matched by size and two 64-bit hashes), so uploading the same bytes
+// again, like the two particle buffers that start out the same, costs a few bytes. Link with -lz.
+//
+// File layout: header (magic "GLCP", version, width, height, default framebuffer, warm-up frames, frames,
+// function name table), then records: uint16 function id, uint32 payload size, payload. A blob record comes
+// before the first call that uses it.
+
+#include "gltrace.h"
+#include <zlib.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace glcapture {
+
+const char MAGIC[4] = {'G', 'L', 'C', 'P'};
+const uint32_t VERSION = 2;
+const uint16_t FRAME_END = 0xFFFF;    // record: end of a frame
+const uint16_t MAPPED_WRITE = 0xFFFE; // record: bytes written through a mapped buffer
+const uint16_t BLOB = 0xFFFD;         // record: uint32 blob number, uint64 size, uint8 compressed, the (zlib) bytes
+const size_t BLOB_MIN_SIZE = 1024;    // smaller data stays in the call's record
+
+// How a data argument is stored in a record
+enum DataKind : uint8_t { DATA_NULL = 0, DATA_INLINE = 1, DATA_BLOB = 2 };
+
+// Kinds of GL object names remapped on replay (shaders and programs share one namespace)
+enum NameKind { BUFFER, TEXTURE, VERTEX_ARRAY, FRAMEBUFFER, RENDERBUFFER, QUERY, PROGRAM, NAME_KINDS };
+
+// Bytes of one pixel in client memory (packed types are a whole pixel)
+inline size_t pixelSize(GLenum format, GLenum type) {
+    switch (type) {
+    case GL_UNSIGNED_BYTE_3_3_2: case GL_UNSIGNED_BYTE_2_3_3_REV: return 1;
+    case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_5_6_5_REV: case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_4_4_4_4_REV: case GL_UNSIGNED_SHORT_5_5_5_1: case GL_UNSIGNED_SHORT_1_5_5_5_REV: return 2;
+    case GL_UNSIGNED_INT_8_8_8_8: case GL_UNSIGNED_INT_8_8_8_8_REV: case GL_UNSIGNED_INT_10_10_10_2:
+    case GL_UNSIGNED_INT_2_10_10_10_REV: case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV: return 4;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV: return 8;
+    default: break;
+    }
+    size_t components = 4;
+    switch (format) {
+    case GL_RED: case GL_GREEN: case GL_BLUE: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX:
+        components = 1; break;
+    case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL:
+        components = 2; break;
+    case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: case GL_BGR_INTEGER:
+        components = 3; break;
+    default: break;
+    }
+    size_t bytes = 1;
+    switch (type) {
+    case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: bytes = 2; break;
+    case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: bytes = 4; break;
+    default: break;
+    }
+    return components * bytes;
+}
+
+// Bytes GL reads / writes for a width x height image with rows padded to `alignment`
+inline size_t imageSize(GLsizei width, GLsizei height, GLenum format, GLenum type, GLint alignment) {
+    if (width <= 0 || height <= 0) return 0;
+    size_t row = static_cast<size_t>(width) * pixelSize(format, type);
+    size_t paddedRow = (row + alignment - 1) / alignment * alignment;
+    return paddedRow * (height - 1) + row; // the last row needs no padding
+}
+
+// Blob records of a capture: each distinct piece of data is compressed and written once
+struct BlobWriter {
+    std::ofstream *out = nullptr;
+    std::unordered_map<std::string, uint32_t> known; // size + hashes -> blob number
+    uint32_t count = 0;
+    uint64_t dataBytes = 0, storedBytes = 0; // every blob referenced / what the blob records take in the file
+    std::vector<unsigned char> compressed;
+
+    void reset(std::ofstream *file) {
+        out = file;
+        known.clear();
+        count = 0;
+        dataBytes = storedBytes = 0;
+    }
+
+    // Blob number of the data, writing the blob record the first time it is seen
+    uint32_t put(const unsigned char *p, size_t size) {
+        dataBytes += size;
+        std::string key = keyOf(p, size);
+        auto found = known.find(key);
+        if (found != known.end()) return found->second;
+
+        uint32_t number = count++;
+        known.emplace(key, number);
+        uLongf length = compressBound(static_cast<uLong>(size));
+        compressed.resize(length);
+        bool packed = compress2(compressed.data(), &length, p, static_cast<uLong>(size), Z_BEST_SPEED) == Z_OK && length < size;
+        const unsigned char *stored = packed ? compressed.data() : p;
+        size_t storedSize = packed ? static_cast<size_t>(length) : size;
+
+        uint16_t id = BLOB;
+        uint32_t recordSize = static_cast<uint32_t>(sizeof(uint32_t) + sizeof(uint64_t) + 1 + storedSize);
+        uint64_t rawSize = size;
+        uint8_t flag = packed ? 1 : 0;
+        out->write(reinterpret_cast<const char *>(&id), sizeof(id));
+        out->write(reinterpret_cast<const char *>(&recordSize), sizeof(recordSize));
+        out->write(reinterpret_cast<const char *>(&number), sizeof(number));
+        out->write(reinterpret_cast<const char *>(&rawSize), sizeof(rawSize));
+        out->write(reinterpret_cast<const char *>(&flag), sizeof(flag));
+        out->write(reinterpret_cast<const char *>(stored), static_cast<std::streamsize>(storedSize));
+        storedBytes += sizeof(id) + sizeof(recordSize) + recordSize;
+        return number;
+    }
+
+private:
+    // size, FNV-1a and a multiply-xorshift hash of the bytes: a false match needs both 64-bit hashes to collide
+    static std::string keyOf(const unsigned char *p, size_t size) {
+        uint64_t key[3] = {size, 14695981039346656037ull, 0x9E3779B97F4A7C15ull};
+        for (size_t i = 0; i < size; ++i) {
+            key[1] = (key[1] ^ p[i]) * 1099511628211ull;
+            key[2] = (key[2] + p[i]) * 0xFF51AFD7ED558CCDull;
+            key[2] ^= key[2] >> 29;
+        }
+        return std::string(reinterpret_cast<const char *>(key), sizeof(key));
+    }
+};
+
+// Payload of the record being written
+struct Writer {
+    std::vector<unsigned char> bytes;
+    BlobWriter *blobs = nullptr; // where big data goes (nullptr = always inline)
+
+    template <typename T>
+    void value(T v) {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(&v);
+        bytes.insert(bytes.end(), p, p + sizeof(T));
+    }
+
+    // kind, size, then the bytes or the blob number (a null pointer is written as size 0)
+    void data(const void *p, size_t size) {
+        const unsigned char *begin = static_cast<const unsigned char *>(p);
+        if (p && blobs && size >= BLOB_MIN_SIZE && size < 0xFFFFFF00u) { // a blob record's size is 32 bits
+            uint32_t number = blobs->put(begin, size);
+            value<uint8_t>(DATA_BLOB);
+            value<uint64_t>(size);
+            value<uint32_t>(number);
+            return;
+        }
+        value<uint8_t>(p ? DATA_INLINE : DATA_NULL);
+        value<uint64_t>(p ? size : 0);
+        if (p) bytes.insert(bytes.end(), begin, begin + size);
+    }
+
+    void string(const char *s, size_t length) {
+        value<uint32_t>(static_cast<uint32_t>(length));
+        bytes.insert(bytes.end(), s, s + length);
+    }
+};
+
+// Payload of the record being replayed
+struct Reader {
+    const unsigned char *at = nullptr, *end = nullptr;
+    const std::vector<std::vector<unsigned char>> *blobs = nullptr; // the trace's blobs, uncompressed
+    bool failed = false;
+
+    template <typename T>
+    T value() {
+        T v{};
+        if (static_cast<size_t>(end - at) < sizeof(T)) {
+            failed = true;
+            return v;
+        }
+        std::memcpy(&v, at, sizeof(T));
+        at += sizeof(T);
+        return v;
+    }
+
+    // Returns nullptr for data written from a null pointer
+    const void *data(uint64_t &size) {
+        uint8_t kind = value<uint8_t>();
+        size = value<uint64_t>();
+        if (kind == DATA_BLOB) {
+            uint32_t number = value<uint32_t>();
+            if (failed || !blobs || number >= blobs->size() || (*blobs)[number].size() != size) {
+                failed = true;
+                size = 0;
+                return nullptr;
+            }
+            return (*blobs)[number].data();
+        }
+        if (kind == DATA_NULL) return nullptr;
+        if (static_cast<uint64_t>(end - at) < size) {
+            failed = true;
+            size = 0;
+            return nullptr;
+        }
+        const void *p = at;
+        at += size;
+        return p;
+    }
+
+    std::string string() {
+        uint32_t length = value<uint32_t>();
+        if (static_cast<size_t>(end - at) < length) {
+            failed = true;
+            return std::string();
+        }
+        std::string s(reinterpret_cast<const char *>(at), length);
+        at += length;
+        return s;
+    }
+};
+
+// ---- capture side ----
+
+struct Mapping {
+    GLuint buffer = 0;
+    unsigned char *pointer = nullptr;
+    std::vector<unsigned char> shadow; // contents as last recorded
+};
+
+struct CaptureState {
+    std::ofstream out;
+    std::string path;
+    Writer record;
+    BlobWriter blobs;
+    bool active = false;
+    uint32_t warmupFrames = 0, lastFrame = 0; // lastFrame 0 = until stop()
+    uint32_t frames = 0;
+    uint64_t records = 0;
+    uint64_t unsupported[gltrace::FUNCTION_COUNT] = {};
+    std::unordered_map<GLenum, GLuint> buffers; // bound buffer per target
+    GLint packAlignment = 4, unpackAlignment = 4;
+    std::vector<Mapping> mappings;
+
+    GLuint boundBuffer(GLenum target) {
+        auto found = buffers.find(target);
+        return found == buffers.end() ? 0 : found->second;
+    }
+
+    void begin() { record.bytes.clear(); }
+
+    void end(uint16_t id) {
+        uint32_t size = static_cast<uint32_t>(record.bytes.size());
+        out.write(reinterpret_cast<const char *>(&id), sizeof(id));
+        out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char *>(record.bytes.data()), size);
+        ++records;
+    }
+
+    // Records the bytes changed through mapped buffers since the last call
+    void syncMappings() {
+        for (Mapping &mapping : mappings) {
+            size_t size = mapping.shadow.size();
+            size_t first = 0;
+            while (first < size && mapping.pointer[first] == mapping.shadow[first]) ++first;
+            if (first == size) continue;
+            size_t last = size;
+            while (mapping.pointer[last - 1] == mapping.shadow[last - 1]) --last;
+
+            std::memcpy(&mapping.shadow[first], mapping.pointer + first, last - first);
+            begin();
+            record.value<GLuint>(mapping.buffer);
+            record.value<uint64_t>(first);
+            record.data(&mapping.shadow[first], last - first);
+            end(MAPPED_WRITE);
+        }
+    }
+
+    void forgetMapping(GLuint buffer) {
+        for (size_t i = 0; i < mappings.size(); ++i) {
+            if (mappings[i].buffer == buffer) {
+                mappings.erase(mappings.begin() + i);
+                return;
+            }
+        }
+    }
+};
+
+inline CaptureState &capture() {
+    static CaptureState state;
+    return state;
+}
+
+// ---- replay side ----
+
+struct ReplayState {
+    std::unordered_map<GLuint, GLuint> names[NAME_KINDS]; // captured name -> replayed name
+    std::unordered_map<uint64_t, GLint> locations;        // (replayed program, captured location) -> location
+    std::unordered_map<uint64_t, GLuint> blockIndices;    // (replayed program, captured index) -> index
+    std::unordered_map<uint64_t, GLsync> syncs;           // captured handle -> sync object
+    std::unordered_map<GLuint, unsigned char *> mappings; // captured buffer -> mapped pointer
+    GLuint program = 0;                                   // current program (replayed name)
+    GLuint capturedFramebuffer = 0;                       // what the application drew to (its window / offscreen target)
+    GLuint framebuffer = 0;                               // what the replay draws to instead
+    std::vector<unsigned char> scratch;                   // read backs land here
+
+    GLuint name(int kind, GLuint captured) const {
+        if (kind == FRAMEBUFFER && captured == capturedFramebuffer) return framebuffer;
+        if (captured == 0) return 0;
+        auto found = names[kind].find(captured);
+        return found == names[kind].end() ? captured : found->second;
+    }
+
+    static uint64_t key(GLuint program, uint32_t value) { return (static_cast<uint64_t>(program) << 32) | value; }
+
+    GLint location(GLint captured) const {
+        auto found = locations.find(key(program, static_cast<uint32_t>(captured)));
+        return found == locations.end() ? captured : found->second;
+    }
+
+    void *scratchBuffer(size_t size) {
+        if (scratch.size() < size) scratch.resize(size);
+        return scratch.data();
+    }
+};
+
+// ---- how each function is written and replayed ----
+
+enum CodecKind {
+    GENERIC, // default: every argument is a number and written as is (functions with pointers are skipped)
+    CUSTOM,  // write() / replay() below
+    IGNORED  // getters: not recorded
+};
+
+struct Void {}; // result of void functions
+
+template <int Id>
+struct Codec {
+    static const int KIND = GENERIC;
+};
+
+struct Ignore {
+    static const int KIND = IGNORED;
+};
+
+// Argument tags for codecs made of one tag per argument
+template <typename T>
+struct Value {
+    using Type = T;
+    static void write(Writer &out, T v) { out.value(v); }
+    static T read(Reader &in, ReplayState &) { return in.value<T>(); }
+};
+
+template <int Kind>
+struct Name {
+    using Type = GLuint;
+    static void write(Writer &out, GLuint name) { out.value(name); }
+    static GLuint read(Reader &in, ReplayState &state) { return state.name(Kind, in.value<GLuint>()); }
+};
+
+// Uniform location of the current program
+struct Location {
+    using Type = GLint;
+    static void write(Writer &out, GLint location) { out.value(location); }
+    static GLint read(Reader &in, ReplayState &state) { return state.location(in.value<GLint>()); }
+};
+
+// Pointer argument that is really an offset into a bound buffer (vertex attributes, indices, indirect commands)
+struct Offset {
+    using Type = const void *;
+    static void write(Writer &out, const void *p) { out.value<uint64_t>(reinterpret_cast<uintptr_t>(p)); }
+    static const void *read(Reader &in, ReplayState &) {
+        return reinterpret_cast<const void *>(static_cast<uintptr_t>(in.value<uint64_t>()));
+    }
+};
+
+template <typename... Tags>
+struct Encode {
+    static const int KIND = CUSTOM;
+
+    template <typename Result, typename... Args>
+    static void write(CaptureState &c, Result, Args... args) {
+        (Tags::write(c.record, args), ...);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        std::tuple<typename Tags::Type...> values{Tags::read(in, state)...}; // braces: read in order
+        if (!in.failed) std::apply(function, values);
+    }
+};
+
+template <int Kind>
+struct Generate {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLsizei n, GLuint *names) {
+        c.record.value(n);
+        for (GLsizei i = 0; i < n; ++i) c.record.value(names[i]);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLsizei n = in.value<GLsizei>();
+        std::vector<GLuint> captured, created(n > 0 ? n : 0);
+        for (GLsizei i = 0; i < n; ++i) captured.push_back(in.value<GLuint>());
+        if (in.failed || n <= 0) return;
+        function(n, created.data());
+        for (GLsizei i = 0; i < n; ++i) state.names[Kind][captured[i]] = created[i];
+    }
+};
+
+template <int Kind>
+struct Delete {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLsizei n, const GLuint *names) {
+        c.record.value(n);
+        for (GLsizei i = 0; i < n; ++i) {
+            c.record.value(names[i]);
+            if (Kind == BUFFER) c.forgetMapping(names[i]); // deleting unmaps
+        }
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLsizei n = in.value<GLsizei>();
+        std::vector<GLuint> names;
+        for (GLsizei i = 0; i < n; ++i) {
+            GLuint captured = in.value<GLuint>();
+            names.push_back(state.name(Kind, captured));
+            state.names[Kind].erase(captured);
+            if (Kind == BUFFER) state.mappings.erase(captured);
+        }
+        if (!in.failed && n > 0) function(n, names.data());
+    }
+};
+
+// glDeleteShader / glDeleteProgram
+struct DeleteProgram {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLuint name) { c.record.value(name); }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLuint captured = in.value<GLuint>();
+        if (in.failed) return;
+        function(state.name(PROGRAM, captured));
+        state.names[PROGRAM].erase(captured);
+    }
+};
+
+// glUniform{1,2,3,4}{f,i,ui}v and glUniformMatrix{3,4}fv: `count` elements of Size values
+template <int Size, typename T, bool Matrix>
+struct UniformArray {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLint location, GLsizei count, const T *value) {
+        c.record.value(location);
+        c.record.data(value, sizeof(T) * Size * (count > 0 ? count : 0));
+    }
+
+    static void write(CaptureState &c, Void, GLint location, GLsizei count, GLboolean transpose, const T *value) {
+        c.record.value(transpose);
+        write(c, Void(), location, count, value);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLboolean transpose = Matrix ? in.value<GLboolean>() : GL_FALSE;
+        GLint location = state.location(in.value<GLint>());
+        uint64_t size = 0;
+        const T *value = static_cast<const T *>(in.data(size));
+        if (in.failed) return;
+        GLsizei count = static_cast<GLsizei>(size / (sizeof(T) * Size));
+        if constexpr (Matrix) function(location, count, transpose, value);
+        else function(location, count, value);
+    }
+};
+
+// Objects
+template <> struct Codec<gltrace::id_glGenBuffers> : Generate<BUFFER> {};
+template <> struct Codec<gltrace::id_glGenTextures> : Generate<TEXTURE> {};
+template <> struct Codec<gltrace::id_glGenVertexArrays> : Generate<VERTEX_ARRAY> {};
+template <> struct Codec<gltrace::id_glGenFramebuffers> : Generate<FRAMEBUFFER> {};
+template <> struct Codec<gltrace::id_glGenRenderbuffers> : Generate<RENDERBUFFER> {};
+template <> struct Codec<gltrace::id_glGenQueries> : Generate<QUERY> {};
+template <> struct Codec<gltrace::id_glDeleteBuffers> : Delete<BUFFER> {};
+template <> struct Codec<gltrace::id_glDeleteTextures> : Delete<TEXTURE> {};
+template <> struct Codec<gltrace::id_glDeleteVertexArrays> : Delete<VERTEX_ARRAY> {};
+template <> struct Codec<gltrace::id_glDeleteFramebuffers> : Delete<FRAMEBUFFER> {};
+template <> struct Codec<gltrace::id_glDeleteRenderbuffers> : Delete<RENDERBUFFER> {};
+template <> struct Codec<gltrace::id_glDeleteQueries> : Delete<QUERY> {};
+template <> struct Codec<gltrace::id_glDeleteShader> : DeleteProgram {};
+template <> struct Codec<gltrace::id_glDeleteProgram> : DeleteProgram {};
+
+// Binds (buffer binds are also tracked, for mapping and pixel transfers)
+template <> struct Codec<gltrace::id_glBindBuffer> : Encode<Value<GLenum>, Name<BUFFER>> {
+    static void write(CaptureState &c, Void result, GLenum target, GLuint buffer) {
+        c.buffers[target] = buffer;
+        Encode::write(c, result, target, buffer);
+    }
+};
+template <> struct Codec<gltrace::id_glBindBufferBase> : Encode<Value<GLenum>, Value<GLuint>, Name<BUFFER>> {
+    static void write(CaptureState &c, Void result, GLenum target, GLuint index, GLuint buffer) {
+        c.buffers[target] = buffer;
+        Encode::write(c, result, target, index, buffer);
+    }
+};
+template <> struct Codec<gltrace::id_glBindBufferRange>
+    : Encode<Value<GLenum>, Value<GLuint>, Name<BUFFER>, Value<GLintptr>, Value<GLsizeiptr>> {
+    static void write(CaptureState &c, Void result, GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        c.buffers[target] = buffer;
+        Encode::write(c, result, target, index, buffer, offset, size);
+    }
+};
+template <> struct Codec<gltrace::id_glBindVertexArray> : Encode<Name<VERTEX_ARRAY>> {};
+template <> struct Codec<gltrace::id_glBindTexture> : Encode<Value<GLenum>, Name<TEXTURE>> {};
+template <> struct Codec<gltrace::id_glBindFramebuffer> : Encode<Value<GLenum>, Name<FRAMEBUFFER>> {};
+template <> struct Codec<gltrace::id_glBindRenderbuffer> : Encode<Value<GLenum>, Name<RENDERBUFFER>> {};
+template <> struct Codec<gltrace::id_glFramebufferTexture2D>
+    : Encode<Value<GLenum>, Value<GLenum>, Value<GLenum>, Name<TEXTURE>, Value<GLint>> {};
+template <> struct Codec<gltrace::id_glFramebufferRenderbuffer>
+    : Encode<Value<GLenum>, Value<GLenum>, Value<GLenum>, Name<RENDERBUFFER>> {};
+template <> struct Codec<gltrace::id_glDrawBuffers> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLsizei n, const GLenum *buffers) {
+        c.record.data(buffers, sizeof(GLenum) * (n > 0 ? n : 0));
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &, Function function) {
+        uint64_t size = 0;
+        const GLenum *buffers = static_cast<const GLenum *>(in.data(size));
+        if (!in.failed) function(static_cast<GLsizei>(size / sizeof(GLenum)), buffers);
+    }
+};
+template <> struct Codec<gltrace::id_glUseProgram> : Encode<Name<PROGRAM>> {
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        state.program = state.name(PROGRAM, in.value<GLuint>());
+        if (!in.failed) function(state.program);
+    }
+};
+
+// Queries
+template <> struct Codec<gltrace::id_glQueryCounter> : Encode<Name<QUERY>, Value<GLenum>> {};
+template <> struct Codec<gltrace::id_glBeginQuery> : Encode<Value<GLenum>, Name<QUERY>> {};
+
+// Results are read into scratch memory: the same work happens, the values are not needed
+template <typename T>
+struct QueryResult {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLuint query, GLenum pname, T *) {
+        c.record.value(query);
+        c.record.value(pname);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLuint query = state.name(QUERY, in.value<GLuint>());
+        GLenum pname = in.value<GLenum>();
+        if (!in.failed) function(query, pname, static_cast<T *>(state.scratchBuffer(sizeof(T))));
+    }
+};
+template <> struct Codec<gltrace::id_glGetQueryObjectiv> : QueryResult<GLint> {};
+template <> struct Codec<gltrace::id_glGetQueryObjectuiv> : QueryResult<GLuint> {};
+template <> struct Codec<gltrace::id_glGetQueryObjecti64v> : QueryResult<GLint64> {};
+template <> struct Codec<gltrace::id_glGetQueryObjectui64v> : QueryResult<GLuint64> {};
+
+// Shaders and programs
+template <> struct Codec<gltrace::id_glCreateShader> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, GLuint shader, GLenum type) {
+        c.record.value(type);
+        c.record.value(shader);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLenum type = in.value<GLenum>();
+        GLuint captured = in.value<GLuint>();
+        if (!in.failed) state.names[PROGRAM][captured] = function(type);
+    }
+};
+
+template <> struct Codec<gltrace::id_glCreateProgram> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, GLuint program) { c.record.value(program); }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLuint captured = in.value<GLuint>();
+        if (!in.failed) state.names[PROGRAM][captured] = function();
+    }
+};
+
+template <> struct Codec<gltrace::id_glShaderSource> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLuint shader, GLsizei count, const GLchar *const *strings, const GLint *lengths) {
+        c.record.value(shader);
+        c.record.value(count);
+        for (GLsizei i = 0; i < count; ++i) {
+            size_t length = lengths && lengths[i] >= 0 ? static_cast<size_t>(lengths[i]) : std::strlen(strings[i]);
+            c.record.string(strings[i], length);
+        }
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLuint shader = state.name(PROGRAM, in.value<GLuint>());
+        GLsizei count = in.value<GLsizei>();
+        std::vector<std::string> sources;
+        for (GLsizei i = 0; i < count && !in.failed; ++i) sources.push_back(in.string());
+        if (in.failed) return;
+        std::vector<const GLchar *> strings;
+        std::vector<GLint> lengths;
+        for (const std::string &source : sources) {
+            strings.push_back(source.c_str());
+            lengths.push_back(static_cast<GLint>(source.size()));
+        }
+        function(shader, count, strings.data(), lengths.data());
+    }
+};
+
+template <> struct Codec<gltrace::id_glAttachShader> : Encode<Name<PROGRAM>, Name<PROGRAM>> {};
+template <> struct Codec<gltrace::id_glDetachShader> : Encode<Name<PROGRAM>, Name<PROGRAM>> {};
+template <> struct Codec<gltrace::id_glCompileShader> : Encode<Name<PROGRAM>> {};
+template <> struct Codec<gltrace::id_glLinkProgram> : Encode<Name<PROGRAM>> {};
+
+template <> struct Codec<gltrace::id_glTransformFeedbackVaryings> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLuint program, GLsizei count, const GLchar *const *varyings, GLenum bufferMode) {
+        c.record.value(program);
+        c.record.value(bufferMode);
+        c.record.value(count);
+        for (GLsizei i = 0; i < count; ++i) c.record.string(varyings[i], std::strlen(varyings[i]));
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLuint program = state.name(PROGRAM, in.value<GLuint>());
+        GLenum bufferMode = in.value<GLenum>();
+        GLsizei count = in.value<GLsizei>();
+        std::vector<std::string> names;
+        for (GLsizei i = 0; i < count && !in.failed; ++i) names.push_back(in.string());
+        if (in.failed) return;
+        std::vector<const GLchar *> varyings;
+        for (const std::string &name : names) varyings.push_back(name.c_str());
+        function(program, count, varyings.data(), bufferMode);
+    }
+};
+
+// Looked-up locations / indices are recorded with the name, so replay can look them up in its own program
+template <typename Result, int Kind>
+struct Lookup {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Result result, GLuint program, const GLchar *name) {
+        c.record.value(program);
+        c.record.string(name, std::strlen(name));
+        c.record.value(result);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLuint program = state.name(PROGRAM, in.value<GLuint>());
+        std::string name = in.string();
+        Result captured = in.value<Result>();
+        if (in.failed) return;
+        Result result = function(program, name.c_str());
+        if (Kind == 0) state.locations[ReplayState::key(program, static_cast<uint32_t>(captured))] = static_cast<GLint>(result);
+        else state.blockIndices[ReplayState::key(program, static_cast<uint32_t>(captured))] = static_cast<GLuint>(result);
+    }
+};
+template <> struct Codec<gltrace::id_glGetUniformLocation> : Lookup<GLint, 0> {};
+template <> struct Codec<gltrace::id_glGetUniformBlockIndex> : Lookup<GLuint, 1> {};
+
+template <> struct Codec<gltrace::id_glUniformBlockBinding> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLuint program, GLuint blockIndex, GLuint binding) {
+        c.record.value(program);
+        c.record.value(blockIndex);
+        c.record.value(binding);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLuint program = state.name(PROGRAM, in.value<GLuint>());
+        GLuint captured = in.value<GLuint>();
+        GLuint binding = in.value<GLuint>();
+        if (in.failed) return;
+        auto found = state.blockIndices.find(ReplayState::key(program, captured));
+        function(program, found == state.blockIndices.end() ? captured : found->second, binding);
+    }
+};
+
+// Uniforms
+template <> struct Codec<gltrace::id_glUniform1i> : Encode<Location, Value<GLint>> {};
+template <> struct Codec<gltrace::id_glUniform2i> : Encode<Location, Value<GLint>, Value<GLint>> {};
+template <> struct Codec<gltrace::id_glUniform1ui> : Encode<Location, Value<GLuint>> {};
+template <> struct Codec<gltrace::id_glUniform1f> : Encode<Location, Value<GLfloat>> {};
+template <> struct Codec<gltrace::id_glUniform2f> : Encode<Location, Value<GLfloat>, Value<GLfloat>> {};
+template <> struct Codec<gltrace::id_glUniform3f> : Encode<Location, Value<GLfloat>, Value<GLfloat>, Value<GLfloat>> {};
+template <> struct Codec<gltrace::id_glUniform4f>
+    : Encode<Location, Value<GLfloat>, Value<GLfloat>, Value<GLfloat>, Value<GLfloat>> {};
+template <> struct Codec<gltrace::id_glUniform1fv> : UniformArray<1, GLfloat, false> {};
+template <> struct Codec<gltrace::id_glUniform2fv> : UniformArray<2, GLfloat, false> {};
+template <> struct Codec<gltrace::id_glUniform3fv> : UniformArray<3, GLfloat, false> {};
+template <> struct Codec<gltrace::id_glUniform4fv> : UniformArray<4, GLfloat, false> {};
+template <> struct Codec<gltrace::id_glUniform1iv> : UniformArray<1, GLint, false> {};
+template <> struct Codec<gltrace::id_glUniform1uiv> : UniformArray<1, GLuint, false> {};
+template <> struct Codec<gltrace::id_glUniformMatrix3fv> : UniformArray<9, GLfloat, true> {};
+template <> struct Codec<gltrace::id_glUniformMatrix4fv> : UniformArray<16, GLfloat, true> {};
+
+// Vertex input and draws (pointers are offsets into the bound buffers)
+template <> struct Codec<gltrace::id_glVertexAttribPointer>
+    : Encode<Value<GLuint>, Value<GLint>, Value<GLenum>, Value<GLboolean>, Value<GLsizei>, Offset> {};
+template <> struct Codec<gltrace::id_glVertexAttribIPointer>
+    : Encode<Value<GLuint>, Value<GLint>, Value<GLenum>, Value<GLsizei>, Offset> {};
+template <> struct Codec<gltrace::id_glDrawElements> : Encode<Value<GLenum>, Value<GLsizei>, Value<GLenum>, Offset> {};
+template <> struct Codec<gltrace::id_glDrawElementsInstanced>
+    : Encode<Value<GLenum>, Value<GLsizei>, Value<GLenum>, Offset, Value<GLsizei>> {};
+template <> struct Codec<gltrace::id_glDrawArraysIndirect> : Encode<Value<GLenum>, Offset> {};
+template <> struct Codec<gltrace::id_glDrawElementsIndirect> : Encode<Value<GLenum>, Value<GLenum>, Offset> {};
+
+// Buffer data
+template <> struct Codec<gltrace::id_glBufferData> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+        c.record.value(target);
+        c.record.value(usage);
+        c.record.value(size);
+        c.record.data(data, static_cast<size_t>(size));
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &, Function function) {
+        GLenum target = in.value<GLenum>();
+        GLenum usage = in.value<GLenum>();
+        GLsizeiptr size = in.value<GLsizeiptr>();
+        uint64_t dataSize = 0;
+        const void *data = in.data(dataSize);
+        if (!in.failed) function(target, size, data, usage);
+    }
+};
+
+template <> struct Codec<gltrace::id_glBufferStorage> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) {
+        Codec<gltrace::id_glBufferData>::write(c, Void(), target, size, data, flags);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        Codec<gltrace::id_glBufferData>::replay(in, state, function);
+    }
+};
+
+template <> struct Codec<gltrace::id_glBufferSubData> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+        c.record.value(target);
+        c.record.value(offset);
+        c.record.data(data, static_cast<size_t>(size));
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &, Function function) {
+        GLenum target = in.value<GLenum>();
+        GLintptr offset = in.value<GLintptr>();
+        uint64_t size = 0;
+        const void *data = in.data(size);
+        if (!in.failed) function(target, offset, static_cast<GLsizeiptr>(size), data);
+    }
+};
+
+template <> struct Codec<gltrace::id_glClearBufferSubData> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLenum target, GLenum internalformat, GLintptr offset, GLsizeiptr size,
+                      GLenum format, GLenum type, const void *data) {
+        c.record.value(target);
+        c.record.value(internalformat);
+        c.record.value(offset);
+        c.record.value(size);
+        c.record.value(format);
+        c.record.value(type);
+        c.record.data(data, pixelSize(format, type)); // one element: the clear value
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &, Function function) {
+        GLenum target = in.value<GLenum>();
+        GLenum internalformat = in.value<GLenum>();
+        GLintptr offset = in.value<GLintptr>();
+        GLsizeiptr size = in.value<GLsizeiptr>();
+        GLenum format = in.value<GLenum>();
+        GLenum type = in.value<GLenum>();
+        uint64_t dataSize = 0;
+        const void *data = in.data(dataSize);
+        if (!in.failed) function(target, internalformat, offset, size, format, type, data);
+    }
+};
+
+// Mapping: the pointer is remembered and compared before every call (see syncMappings)
+template <> struct Codec<gltrace::id_glMapBufferRange> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, void *pointer, GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        GLuint buffer = c.boundBuffer(target);
+        c.record.value(target);
+        c.record.value(buffer);
+        c.record.value(offset);
+        c.record.value(length);
+        c.record.value(access);
+        if (pointer && (access & GL_MAP_WRITE_BIT)) {
+            Mapping mapping;
+            mapping.buffer = buffer;
+            mapping.pointer = static_cast<unsigned char *>(pointer);
+            mapping.shadow.assign(mapping.pointer, mapping.pointer + length); // nothing written yet
+            c.forgetMapping(buffer);
+            c.mappings.push_back(mapping);
+        }
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLenum target = in.value<GLenum>();
+        GLuint buffer = in.value<GLuint>();
+        GLintptr offset = in.value<GLintptr>();
+        GLsizeiptr length = in.value<GLsizeiptr>();
+        GLbitfield access = in.value<GLbitfield>();
+        if (in.failed) return;
+        void *pointer = function(target, offset, length, access);
+        if (pointer) state.mappings[buffer] = static_cast<unsigned char *>(pointer);
+    }
+};
+
+template <> struct Codec<gltrace::id_glUnmapBuffer> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, GLboolean, GLenum target) {
+        GLuint buffer = c.boundBuffer(target);
+        c.record.value(target);
+        c.record.value(buffer);
+        c.forgetMapping(buffer);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLenum target = in.value<GLenum>();
+        GLuint buffer = in.value<GLuint>();
+        if (in.failed) return;
+        function(target);
+        state.mappings.erase(buffer);
+    }
+};
+
+// Textures and pixels
+template <> struct Codec<gltrace::id_glPixelStorei> : Encode<Value<GLenum>, Value<GLint>> {
+    static void write(CaptureState &c, Void result, GLenum pname, GLint param) {
+        if (pname == GL_PACK_ALIGNMENT) c.packAlignment = param;
+        if (pname == GL_UNPACK_ALIGNMENT) c.unpackAlignment = param;
+        Encode::write(c, result, pname, param);
+    }
+};
+
+// Pixels from client memory, or an offset if a pixel unpack buffer is bound
+inline void writePixels(CaptureState &c, const void *pixels, GLsizei width, GLsizei height, GLenum format, GLenum type) {
+    bool offset = c.boundBuffer(GL_PIXEL_UNPACK_BUFFER) != 0;
+    c.record.value<uint8_t>(offset ? 1 : 0);
+    if (offset) c.record.value<uint64_t>(reinterpret_cast<uintptr_t>(pixels));
+    else c.record.data(pixels, imageSize(width, height, format, type, c.unpackAlignment));
+}
+
+inline const void *readPixels(Reader &in) {
+    if (in.value<uint8_t>()) return reinterpret_cast<const void *>(static_cast<uintptr_t>(in.value<uint64_t>()));
+    uint64_t size = 0;
+    return in.data(size);
+}
+
+template <> struct Codec<gltrace::id_glTexImage2D> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                      GLint border, GLenum format, GLenum type, const void *pixels) {
+        c.record.value(target);
+        c.record.value(level);
+        c.record.value(internalformat);
+        c.record.value(width);
+        c.record.value(height);
+        c.record.value(border);
+        c.record.value(format);
+        c.record.value(type);
+        writePixels(c, pixels, width, height, format, type);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &, Function function) {
+        GLenum target = in.value<GLenum>();
+        GLint level = in.value<GLint>();
+        GLint internalformat = in.value<GLint>();
+        GLsizei width = in.value<GLsizei>();
+        GLsizei height = in.value<GLsizei>();
+        GLint border = in.value<GLint>();
+        GLenum format = in.value<GLenum>();
+        GLenum type = in.value<GLenum>();
+        const void *pixels = readPixels(in);
+        if (!in.failed) function(target, level, internalformat, width, height, border, format, type, pixels);
+    }
+};
+
+template <> struct Codec<gltrace::id_glTexSubImage2D> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                      GLenum format, GLenum type, const void *pixels) {
+        c.record.value(target);
+        c.record.value(level);
+        c.record.value(x);
+        c.record.value(y);
+        c.record.value(width);
+        c.record.value(height);
+        c.record.value(format);
+        c.record.value(type);
+        writePixels(c, pixels, width, height, format, type);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &, Function function) {
+        GLenum target = in.value<GLenum>();
+        GLint level = in.value<GLint>();
+        GLint x = in.value<GLint>();
+        GLint y = in.value<GLint>();
+        GLsizei width = in.value<GLsizei>();
+        GLsizei height = in.value<GLsizei>();
+        GLenum format = in.value<GLenum>();
+        GLenum type = in.value<GLenum>();
+        const void *pixels = readPixels(in);
+        if (!in.failed) function(target, level, x, y, width, height, format, type, pixels);
+    }
+};
+
+// Read backs happen on replay too (they wait for the GPU), into scratch memory or the bound pack buffer
+template <> struct Codec<gltrace::id_glReadPixels> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels) {
+        bool offset = c.boundBuffer(GL_PIXEL_PACK_BUFFER) != 0;
+        c.record.value(x);
+        c.record.value(y);
+        c.record.value(width);
+        c.record.value(height);
+        c.record.value(format);
+        c.record.value(type);
+        c.record.value<uint8_t>(offset ? 1 : 0);
+        c.record.value<uint64_t>(offset ? reinterpret_cast<uintptr_t>(pixels) : imageSize(width, height, format, type, c.packAlignment));
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLint x = in.value<GLint>();
+        GLint y = in.value<GLint>();
+        GLsizei width = in.value<GLsizei>();
+        GLsizei height = in.value<GLsizei>();
+        GLenum format = in.value<GLenum>();
+        GLenum type = in.value<GLenum>();
+        bool offset = in.value<uint8_t>() != 0;
+        uint64_t value = in.value<uint64_t>();
+        if (in.failed) return;
+        void *pixels = offset ? reinterpret_cast<void *>(static_cast<uintptr_t>(value)) : state.scratchBuffer(value);
+        function(x, y, width, height, format, type, pixels);
+    }
+};
+
+// Sync objects are pointers: recorded as numbers and mapped to the replay's own
+template <> struct Codec<gltrace::id_glFenceSync> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, GLsync sync, GLenum condition, GLbitfield flags) {
+        c.record.value(condition);
+        c.record.value(flags);
+        c.record.value<uint64_t>(reinterpret_cast<uintptr_t>(sync));
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        GLenum condition = in.value<GLenum>();
+        GLbitfield flags = in.value<GLbitfield>();
+        uint64_t captured = in.value<uint64_t>();
+        if (!in.failed) state.syncs[captured] = function(condition, flags);
+    }
+};
+
+template <typename Result>
+struct WaitSync {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Result, GLsync sync, GLbitfield flags, GLuint64 timeout) {
+        c.record.value<uint64_t>(reinterpret_cast<uintptr_t>(sync));
+        c.record.value(flags);
+        c.record.value(timeout);
+    }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        uint64_t captured = in.value<uint64_t>();
+        GLbitfield flags = in.value<GLbitfield>();
+        GLuint64 timeout = in.value<GLuint64>();
+        auto found = state.syncs.find(captured);
+        if (!in.failed && found != state.syncs.end()) function(found->second, flags, timeout);
+    }
+};
+template <> struct Codec<gltrace::id_glClientWaitSync> : WaitSync<GLenum> {};
+template <> struct Codec<gltrace::id_glWaitSync> : WaitSync<Void> {};
+
+template <> struct Codec<gltrace::id_glDeleteSync> {
+    static const int KIND = CUSTOM;
+
+    static void write(CaptureState &c, Void, GLsync sync) { c.record.value<uint64_t>(reinterpret_cast<uintptr_t>(sync)); }
+
+    template <typename Function>
+    static void replay(Reader &in, ReplayState &state, Function function) {
+        uint64_t captured = in.value<uint64_t>();
+        auto found = state.syncs.find(captured);
+        if (in.failed || found == state.syncs.end()) return;
+        function(found->second);
+        state.syncs.erase(found);
+    }
+};
+
+// Getters: their results were already used by the application
+template <> struct Codec<gltrace::id_glGetError> : Ignore {};
+template <> struct Codec<gltrace::id_glGetIntegerv> : Ignore {};
+template <> struct Codec<gltrace::id_glGetInteger64v> : Ignore {};
+template <> struct Codec<gltrace::id_glGetFloatv> : Ignore {};
+template <> struct Codec<gltrace::id_glGetBooleanv> : Ignore {};
+template <> struct Codec<gltrace::id_glGetString> : Ignore {};
+template <> struct Codec<gltrace::id_glGetStringi> : Ignore {};
+template <> struct Codec<gltrace::id_glGetShaderiv> : Ignore {};
+template <> struct Codec<gltrace::id_glGetShaderInfoLog> : Ignore {};
+template <> struct Codec<gltrace::id_glGetProgramiv> : Ignore {};
+template <> struct Codec<gltrace::id_glGetProgramInfoLog> : Ignore {};
+template <> struct Codec<gltrace::id_glCheckFramebufferStatus> : Ignore {};
+template <> struct Codec<gltrace::id_glIsEnabled> : Ignore {};
+
+template <typename... Args>
+constexpr bool allNumbers() { return (std::is_arithmetic<Args>::value && ...); }
+
+// The wrapper installed in place of one glad pointer: calls GL, then records the call
+template <int Id, typename Pointer>
+struct CaptureHook;
+
+template <int Id, typename R, typename... Args>
+struct CaptureHook<Id, R (APIENTRYP)(Args...)> {
+    static R (APIENTRYP original)(Args...);
+
+    static R APIENTRY call(Args... args) {
+        CaptureState &c = capture();
+        if constexpr (Codec<Id>::KIND == IGNORED) {
+            return original(args...);
+        } else {
+            c.syncMappings(); // anything written through a mapping happened before this call
+            if constexpr (std::is_void<R>::value) {
+                original(args...);
+                record(c, Void(), args...);
+            } else {
+                R result = original(args...);
+                record(c, result, args...);
+                return result;
+            }
+        }
+    }
+
+    template <typename Result>
+    static void record(CaptureState &c, Result result, Args... args) {
+        if constexpr (Codec<Id>::KIND == CUSTOM) {
+            c.begin();
+            Codec<Id>::write(c, result, args...);
+            c.end(static_cast<uint16_t>(Id));
+        } else if constexpr (allNumbers<Args...>()) {
+            c.begin();
+            (c.record.value(args), ...);
+            c.end(static_cast<uint16_t>(Id));
+        } else {
+            ++c.unsupported[Id];
+        }
+    }
+};
+
+template <int Id, typename R, typename... Args>
+R (APIENTRYP CaptureHook<Id, R (APIENTRYP)(Args...)>::original)(Args...) = nullptr;
+
+// Replays one record of one function
+typedef void (*ReplayFunction)(Reader &, ReplayState &);
+
+template <int Id, typename Pointer>
+struct ReplayEntry;
+
+template <int Id, typename R, typename... Args>
+struct ReplayEntry<Id, R (APIENTRYP)(Args...)> {
+    static R (APIENTRYP function)(Args...);
+
+    static void run(Reader &in, ReplayState &state) {
+        if (!function) return;
+        if constexpr (Codec<Id>::KIND == CUSTOM) {
+            Codec<Id>::replay(in, state, function);
+        } else if constexpr (Codec<Id>::KIND == GENERIC && allNumbers<Args...>()) {
+            std::tuple<Args...> values{in.value<Args>()...};
+            if (!in.failed) std::apply(function, values);
+        }
+    }
+};
+
+template <int Id, typename R, typename... Args>
+R (APIENTRYP ReplayEntry<Id, R (APIENTRYP)(Args...)>::function)(Args...) = nullptr;
+
+} // namespace glcapture
+
+class GlCapture {
+public:
+    // Starts writing every GL call to `path` (call on the GL thread, before creating any GL object).
+    // `defaultFramebuffer` is what the application draws its frames into (0 for a window).
+    // The first `warmupFrames` frames are replayed untimed; the capture stops by itself after `frames` frames
+    // (0 = when stop() is called). Returns false if the file can't be written.
+    static bool start(const std::string &path, int width, int height, GLuint defaultFramebuffer,
+                      uint32_t warmupFrames = 0, uint32_t frames = 0) {
+        glcapture::CaptureState &c = glcapture::capture();
+        if (c.active) return false;
+        c.out.open(path, std::ios::binary | std::ios::trunc);
+        if (!c.out) {
+            std::cout << "GL capture: cannot write " << path << "\n";
+            return false;
+        }
+        c.path = path;
+        c.warmupFrames = warmupFrames;
+        c.lastFrame = frames;
+        c.frames = 0;
+        c.records = 0;
+        c.record.blobs = &c.blobs;
+        c.blobs.reset(&c.out);
+        std::fill(c.unsupported, c.unsupported + gltrace::FUNCTION_COUNT, 0);
+
+        c.out.write(glcapture::MAGIC, sizeof(glcapture::MAGIC));
+        const uint32_t header[] = { glcapture::VERSION, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+                                    defaultFramebuffer, warmupFrames, 0 /* frames, written by stop() */,
+                                    static_cast<uint32_t>(gltrace::FUNCTION_COUNT) };
+        c.out.write(reinterpret_cast<const char *>(header), sizeof(header));
+        for (int id = 0; id < gltrace::FUNCTION_COUNT; ++id) {
+            const char *name = gltrace::functionName(id);
+            uint8_t length = static_cast<uint8_t>(std::strlen(name));
+            c.out.write(reinterpret_cast<const char *>(&length), 1);
+            c.out.write(name, length);
+        }
+
+#define GLCAPTURE_INSTALL(name) \
+        if (glad_##name) { \
+            using HookType = glcapture::CaptureHook<gltrace::id_##name, decltype(glad_##name)>; \
+            HookType::original = glad_##name; \
+            glad_##name = &HookType::call; \
+        }
+        GLTRACE_FUNCTIONS(GLCAPTURE_INSTALL)
+#undef GLCAPTURE_INSTALL
+        c.active = true;
+        return true;
+    }
+
+    static bool isCapturing() { return glcapture::capture().active; }
+
+    // Marks the end of a frame (after the frame's last GL call, e.g. right after swapBuffers)
+    static void endFrame() {
+        glcapture::CaptureState &c = glcapture::capture();
+        if (!c.active) return;
+        c.syncMappings();
+        c.begin();
+        c.end(glcapture::FRAME_END);
+        ++c.frames;
+        if (c.lastFrame && c.frames >= c.lastFrame) stop();
+    }
+
+    // Puts the original function pointers back and finishes the file
+    static void stop() {
+        glcapture::CaptureState &c = glcapture::capture();
+        if (!c.active) return;
+#define GLCAPTURE_UNINSTALL(name) \
+        { \
+            using HookType = glcapture::CaptureHook<gltrace::id_##name, decltype(glad_##name)>; \
+            if (glad_##name == &HookType::call) glad_##name = HookType::original; \
+        }
+        GLTRACE_FUNCTIONS(GLCAPTURE_UNINSTALL)
+#undef GLCAPTURE_UNINSTALL
+        c.active = false;
+        c.mappings.clear();
+        c.buffers.clear();
+
+        uint64_t bytes = static_cast<uint64_t>(c.out.tellp());
+        c.out.seekp(sizeof(glcapture::MAGIC) + 5 * sizeof(uint32_t));
+        c.out.write(reinterpret_cast<const char *>(&c.frames), sizeof(c.frames));
+        c.out.close();
+
+        std::cout << "GL capture: " << c.frames << " frames (" << std::min(c.warmupFrames, c.frames) << " warm-up), "
+                  << c.records << " calls, " << bytes / 1048576.0 << " MB written to " << c.path << "\n";
+        std::cout << "  data: " << c.blobs.dataBytes / 1048576.0 << " MB in blobs, " << c.blobs.count
+                  << " distinct, stored in " << c.blobs.storedBytes / 1048576.0 << " MB\n";
+        c.blobs.reset(nullptr);
+        for (int id = 0; id < gltrace::FUNCTION_COUNT; ++id) {
+            if (c.unsupported[id]) std::cout << "  not captured: " << gltrace::functionName(id) << " x" << c.unsupported[id] << "\n";
+        }
+    }
+};
+
+// Replays a trace written by GlCapture, one frame at a time (needs a current context and loaded glad).
+//
+//   GlReplay replay;
+//   if (!replay.open("frames.glcap")) return 1;
+//   replay.setDefaultFramebuffer(myFramebuffer);  // where the frames should go (0 = the window)
+//   while (replay.replayFrame()) { ... }           // frames [0, getWarmupFrames()) are warm-up
+class GlReplay {
+public:
+    // Loads the whole trace into memory, so replaying never waits for the disk
+    bool open(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::cout << "GL replay: cannot open " << path << "\n";
+            return false;
+        }
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        glcapture::Reader header;
+        header.at = reinterpret_cast<const unsigned char *>(bytes.data());
+        header.end = header.at + bytes.size();
+        char magic[4] = {};
+        for (char &c : magic) c = header.value<char>();
+        uint32_t version = header.value<uint32_t>();
+        if (header.failed || std::memcmp(magic, glcapture::MAGIC, 4) != 0 || version != glcapture::VERSION) {
+            std::cout << "GL replay: " << path << " is not a version " << glcapture::VERSION << " capture\n";
+            return false;
+        }
+        width = static_cast<int>(header.value<uint32_t>());
+        height = static_cast<int>(header.value<uint32_t>());
+        state.capturedFramebuffer = header.value<uint32_t>();
+        warmupFrames = header.value<uint32_t>();
+        frames = header.value<uint32_t>();
+
+        // the trace's function ids -> this build's (the function list may differ between glad versions)
+        std::unordered_map<std::string, glcapture::ReplayFunction> known;
+#define GLCAPTURE_REPLAY(name) \
+        { \
+            using Entry = glcapture::ReplayEntry<gltrace::id_##name, decltype(glad_##name)>; \
+            Entry::function = glad_##name; \
+            known[#name] = &Entry::run; \
+        }
+        GLTRACE_FUNCTIONS(GLCAPTURE_REPLAY)
+#undef GLCAPTURE_REPLAY
+        uint32_t count = header.value<uint32_t>();
+        table.assign(count, nullptr);
+        for (uint32_t id = 0; id < count && !header.failed; ++id) {
+            uint8_t length = header.value<uint8_t>();
+            std::string name;
+            for (uint8_t i = 0; i < length; ++i) name += header.value<char>();
+            auto found = known.find(name);
+            if (found != known.end()) table[id] = found->second;
+        }
+        if (header.failed) {
+            std::cout << "GL replay: " << path << " is truncated\n";
+            return false;
+        }
+        at = header.at;
+        end = header.end;
+        if (!loadBlobs()) {
+            std::cout << "GL replay: " << path << " has a broken data blob\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Framebuffer size of a trace, without loading it (to create the context before open())
+    static bool readSize(const std::string &path, int &width, int &height) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[4] = {};
+        uint32_t header[3] = {};
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char *>(header), sizeof(header));
+        if (!in || std::memcmp(magic, glcapture::MAGIC, 4) != 0) {
+            std::cout << "GL replay: cannot read " << path << "\n";
+            return false;
+        }
+        width = static_cast<int>(header[1]);
+        height = static_cast<int>(header[2]);
+        return true;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    uint32_t getFrames() const { return frames; }
+    uint32_t getWarmupFrames() const { return warmupFrames; }
+    uint64_t getSkippedCalls() const { return skipped; }
+
+    // Framebuffer the application's own frames (window / offscreen target) are redirected to
+    void setDefaultFramebuffer(GLuint framebuffer) { state.framebuffer = framebuffer; }
+
+    // Issues the calls of the next frame; false once the trace is over (or broken)
+    bool replayFrame() {
+        while (static_cast<size_t>(end - at) >= sizeof(uint16_t) + sizeof(uint32_t)) {
+            uint16_t id;
+            uint32_t size;
+            std::memcpy(&id, at, sizeof(id));
+            std::memcpy(&size, at + sizeof(id), sizeof(size));
+            at += sizeof(id) + sizeof(size);
+            if (static_cast<size_t>(end - at) < size) break;
+
+            glcapture::Reader record;
+            record.at = at;
+            record.end = at + size;
+            at += size;
+
+            record.blobs = &blobs;
+
+            if (id == glcapture::FRAME_END) return true;
+            if (id == glcapture::BLOB) continue; // already unpacked by open()
+            if (id == glcapture::MAPPED_WRITE) writeMapped(record);
+            else if (id < table.size() && table[id]) table[id](record, state);
+            else ++skipped; // function this build does not have
+            if (record.failed) break;
+        }
+        if (at != end) std::cout << "GL replay: trace is broken, stopped\n";
+        at = end;
+        return false;
+    }
+
+private:
+    std::vector<char> bytes;
+    const unsigned char *at = nullptr, *end = nullptr;
+    std::vector<glcapture::ReplayFunction> table;
+    std::vector<std::vector<unsigned char>> blobs; // uncompressed, by blob number
+    glcapture::ReplayState state;
+    int width = 0, height = 0;
+    uint32_t frames = 0, warmupFrames = 0;
+    uint64_t skipped = 0;
+
+    // Uncompresses every blob up front, so replayed frames never wait for zlib
+    bool loadBlobs() {
+        blobs.clear();
+        const unsigned char *p = at;
+        while (static_cast<size_t>(end - p) >= sizeof(uint16_t) + sizeof(uint32_t)) {
+            uint16_t id;
+            uint32_t size;
+            std::memcpy(&id, p, sizeof(id));
+            std::memcpy(&size, p + sizeof(id), sizeof(size));
+            p += sizeof(id) + sizeof(size);
+            if (static_cast<size_t>(end - p) < size) break; // replayFrame() reports the truncation
+            glcapture::Reader record;
+            record.at = p;
+            record.end = p + size;
+            p += size;
+            if (id != glcapture::BLOB) continue;
+
+            uint32_t number = record.value<uint32_t>();
+            uint64_t rawSize = record.value<uint64_t>();
+            bool packed = record.value<uint8_t>() != 0;
+            if (record.failed || number != blobs.size()) return false;
+            std::vector<unsigned char> blob(rawSize);
+            uLongf length = static_cast<uLongf>(rawSize);
+            uLong storedSize = static_cast<uLong>(record.end - record.at);
+            if (packed) {
+                if (uncompress(blob.data(), &length, record.at, storedSize) != Z_OK || length != rawSize) return false;
+            } else {
+                if (storedSize != rawSize) return false;
+                std::memcpy(blob.data(), record.at, storedSize);
+            }
+            blobs.push_back(std::move(blob));
+        }
+        return true;
+    }
+
+    void writeMapped(glcapture::Reader &record) {
+        GLuint buffer = record.value<GLuint>();
+        uint64_t offset = record.value<uint64_t>();
+        uint64_t size = 0;
+        const void *data = record.data(size);
+        auto found = state.mappings.find(buffer);
+        if (!record.failed && data && found != state.mappings.end()) std::memcpy(found->second + offset, data, size);
+    }
+};
+
+#endif
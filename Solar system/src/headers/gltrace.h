@@ -0,0 +1,429 @@
+#ifndef GLTRACE_H
+#define GLTRACE_H
+
+// OpenGL call interception: glad calls every GL function through a pointer (glBindTexture is glad_glBindTexture),
+// so GlTrace::install() swaps each loaded pointer for a wrapper that counts the call, times it on the CPU and,
+// for binds and enable / disable, notices when the call changes nothing (same program, vertex array, texture,
+// buffer, framebuffer or capability as already set). uninstall() puts the original pointers back, so when it is
+// not installed it costs nothing at all.
+//
+//   GlTrace::install();         // after gladLoadGLLoader, on the GL thread
+//   ... draw a frame ...
+//   GlTrace::endFrame();        // e.g. right after swapBuffers
+//   GlTrace::printFrame(10);    // last frame: calls, redundant binds, CPU time, top 10 entry points
+//   GlTrace::printReport(20);   // per-frame averages over every frame traced
+//
+// Only one thread may make GL calls at a time (true here: the main thread hands the context to the render thread).
+// Each traced call costs two steady_clock reads on top (a few tens of ns), which is included in its CPU time.
+// Redundant binds are tracked from the calls seen since install(); deleting objects forgets that kind of binding,
+// so reused names are never reported falsely.
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "gltrace_functions.h"
+
+namespace gltrace {
+
+enum FunctionId {
+#define GLTRACE_ID(name) id_##name,
+    GLTRACE_FUNCTIONS(GLTRACE_ID)
+#undef GLTRACE_ID
+    FUNCTION_COUNT
+};
+
+inline const char *functionName(int id) {
+    static const char *names[] = {
+#define GLTRACE_NAME(name) #name,
+        GLTRACE_FUNCTIONS(GLTRACE_NAME)
+#undef GLTRACE_NAME
+    };
+    return names[id];
+}
+
+// Counters of one frame (or of the whole run)
+struct Counters {
+    uint64_t calls[FUNCTION_COUNT] = {};
+    uint64_t redundant[FUNCTION_COUNT] = {};
+    uint64_t nanoseconds[FUNCTION_COUNT] = {};
+
+    void add(const Counters &other) {
+        for (int i = 0; i < FUNCTION_COUNT; ++i) {
+            calls[i] += other.calls[i];
+            redundant[i] += other.redundant[i];
+            nanoseconds[i] += other.nanoseconds[i];
+        }
+    }
+
+    uint64_t totalCalls() const { return sum(calls); }
+    uint64_t totalRedundant() const { return sum(redundant); }
+    uint64_t totalNanoseconds() const { return sum(nanoseconds); }
+
+    // Calls that changed what the next draw uses (program, vertex array, textures, buffers, framebuffer, enable /
+    // disable and fixed-function state), redundant ones left out. glActiveTexture only picks the unit the next
+    // glBindTexture goes to, so it isn't one.
+    uint64_t stateChanges() const {
+        static const int ids[] = {
+            id_glUseProgram, id_glBindVertexArray, id_glBindTexture, id_glBindTextures, id_glBindSampler,
+            id_glBindImageTexture, id_glBindBuffer, id_glBindBufferBase, id_glBindBufferRange, id_glBindFramebuffer,
+            id_glBindRenderbuffer, id_glEnable, id_glDisable, id_glEnablei, id_glDisablei, id_glViewport, id_glScissor,
+            id_glDepthMask, id_glDepthFunc, id_glColorMask, id_glBlendFunc, id_glBlendFuncSeparate, id_glBlendEquation,
+            id_glBlendEquationSeparate, id_glCullFace, id_glFrontFace, id_glPolygonMode, id_glPointSize,
+            id_glStencilFunc, id_glStencilOp, id_glStencilMask, id_glDrawBuffer, id_glDrawBuffers, id_glReadBuffer};
+        uint64_t total = 0;
+        for (int id : ids) total += calls[id] - redundant[id];
+        return total;
+    }
+
+private:
+    static uint64_t sum(const uint64_t *values) {
+        uint64_t total = 0;
+        for (int i = 0; i < FUNCTION_COUNT; ++i) total += values[i];
+        return total;
+    }
+};
+
+// What is bound right now, as far as the traced calls tell (UNKNOWN until first bound)
+struct BindState {
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const int TEXTURE_UNITS = 32;
+    static const int TEXTURE_TARGETS = 5; // 2D, cube map, 3D, 2D array, buffer
+    static const int BUFFER_TARGETS = 7;  // array, element array, uniform, shader storage, draw indirect, transform feedback, pixel pack
+    static const int CAPABILITIES = 8;    // depth test, blend, cull face, program point size, rasterizer discard, scissor, stencil, multisample
+
+    GLuint program, vertexArray, activeTexture, drawFramebuffer, readFramebuffer, renderbuffer;
+    GLuint textures[TEXTURE_UNITS][TEXTURE_TARGETS];
+    GLuint buffers[BUFFER_TARGETS];
+    GLuint capabilities[CAPABILITIES]; // 0 / 1 / UNKNOWN
+
+    BindState() { forgetAll(); }
+
+    void forgetAll() {
+        program = vertexArray = activeTexture = drawFramebuffer = readFramebuffer = renderbuffer = UNKNOWN;
+        forgetTextures();
+        forgetBuffers();
+        std::fill(capabilities, capabilities + CAPABILITIES, UNKNOWN);
+    }
+
+    void forgetTextures() {
+        for (GLuint (&unit)[TEXTURE_TARGETS] : textures) std::fill(unit, unit + TEXTURE_TARGETS, UNKNOWN);
+    }
+
+    void forgetBuffers() { std::fill(buffers, buffers + BUFFER_TARGETS, UNKNOWN); }
+
+    // Stores `value` in `slot`; true if it was already there
+    static bool set(GLuint &slot, GLuint value) {
+        bool same = slot == value;
+        slot = value;
+        return same;
+    }
+
+    static int textureTarget(GLenum target) {
+        switch (target) {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_CUBE_MAP: return 1;
+        case GL_TEXTURE_3D: return 2;
+        case GL_TEXTURE_2D_ARRAY: return 3;
+        case GL_TEXTURE_BUFFER: return 4;
+        default: return -1;
+        }
+    }
+
+    static int bufferTarget(GLenum target) {
+        switch (target) {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        case GL_SHADER_STORAGE_BUFFER: return 3;
+        case GL_DRAW_INDIRECT_BUFFER: return 4;
+        case GL_TRANSFORM_FEEDBACK_BUFFER: return 5;
+        case GL_PIXEL_PACK_BUFFER: return 6;
+        default: return -1;
+        }
+    }
+
+    static int capability(GLenum cap) {
+        switch (cap) {
+        case GL_DEPTH_TEST: return 0;
+        case GL_BLEND: return 1;
+        case GL_CULL_FACE: return 2;
+        case GL_PROGRAM_POINT_SIZE: return 3;
+        case GL_RASTERIZER_DISCARD: return 4;
+        case GL_SCISSOR_TEST: return 5;
+        case GL_STENCIL_TEST: return 6;
+        case GL_MULTISAMPLE: return 7;
+        default: return -1;
+        }
+    }
+};
+
+struct TraceState {
+    Counters frame;       // being recorded
+    Counters last;        // last finished frame
+    Counters total;       // every finished frame
+    uint64_t frames = 0;
+    bool installed = false;
+    BindState binds;
+};
+
+inline TraceState &state() {
+    static TraceState trace;
+    return trace;
+}
+
+// Called before the real function: returns true if the call changes nothing. Every function but the
+// binds / enables below leaves the state alone.
+template <int Id>
+struct Observe {
+    template <typename... Args>
+    static bool redundant(Args...) { return false; }
+};
+
+template <> struct Observe<id_glUseProgram> {
+    static bool redundant(GLuint program) { return BindState::set(state().binds.program, program); }
+};
+
+template <> struct Observe<id_glBindVertexArray> {
+    static bool redundant(GLuint vertexArray) {
+        BindState &binds = state().binds;
+        bool same = BindState::set(binds.vertexArray, vertexArray);
+        if (!same) binds.buffers[BindState::bufferTarget(GL_ELEMENT_ARRAY_BUFFER)] = BindState::UNKNOWN; // part of the vertex array
+        return same;
+    }
+};
+
+template <> struct Observe<id_glActiveTexture> {
+    static bool redundant(GLenum unit) { return BindState::set(state().binds.activeTexture, unit); }
+};
+
+template <> struct Observe<id_glBindTexture> {
+    static bool redundant(GLenum target, GLuint texture) {
+        BindState &binds = state().binds;
+        int slot = BindState::textureTarget(target);
+        if (slot < 0 || binds.activeTexture == BindState::UNKNOWN) return false;
+        GLuint unit = binds.activeTexture - GL_TEXTURE0;
+        if (unit >= static_cast<GLuint>(BindState::TEXTURE_UNITS)) return false;
+        return BindState::set(binds.textures[unit][slot], texture);
+    }
+};
+
+template <> struct Observe<id_glBindBuffer> {
+    static bool redundant(GLenum target, GLuint buffer) {
+        int slot = BindState::bufferTarget(target);
+        return slot >= 0 && BindState::set(state().binds.buffers[slot], buffer);
+    }
+};
+
+// Indexed binds also set the generic binding point; they are never counted as redundant themselves
+template <> struct Observe<id_glBindBufferBase> {
+    static bool redundant(GLenum target, GLuint, GLuint buffer) {
+        int slot = BindState::bufferTarget(target);
+        if (slot >= 0) state().binds.buffers[slot] = buffer;
+        return false;
+    }
+};
+
+template <> struct Observe<id_glBindBufferRange> {
+    static bool redundant(GLenum target, GLuint, GLuint buffer, GLintptr, GLsizeiptr) {
+        int slot = BindState::bufferTarget(target);
+        if (slot >= 0) state().binds.buffers[slot] = buffer;
+        return false;
+    }
+};
+
+template <> struct Observe<id_glBindFramebuffer> {
+    static bool redundant(GLenum target, GLuint framebuffer) {
+        BindState &binds = state().binds;
+        if (target == GL_DRAW_FRAMEBUFFER) return BindState::set(binds.drawFramebuffer, framebuffer);
+        if (target == GL_READ_FRAMEBUFFER) return BindState::set(binds.readFramebuffer, framebuffer);
+        bool same = binds.drawFramebuffer == framebuffer && binds.readFramebuffer == framebuffer;
+        binds.drawFramebuffer = binds.readFramebuffer = framebuffer;
+        return same;
+    }
+};
+
+template <> struct Observe<id_glBindRenderbuffer> {
+    static bool redundant(GLenum, GLuint renderbuffer) { return BindState::set(state().binds.renderbuffer, renderbuffer); }
+};
+
+template <> struct Observe<id_glEnable> {
+    static bool redundant(GLenum cap) {
+        int slot = BindState::capability(cap);
+        return slot >= 0 && BindState::set(state().binds.capabilities[slot], 1);
+    }
+};
+
+template <> struct Observe<id_glDisable> {
+    static bool redundant(GLenum cap) {
+        int slot = BindState::capability(cap);
+        return slot >= 0 && BindState::set(state().binds.capabilities[slot], 0);
+    }
+};
+
+// A deleted object that is bound gets unbound, and its name can come back for a new object: forget that kind
+template <> struct Observe<id_glDeleteProgram> {
+    static bool redundant(GLuint) { state().binds.program = BindState::UNKNOWN; return false; }
+};
+
+template <> struct Observe<id_glDeleteVertexArrays> {
+    static bool redundant(GLsizei, const GLuint *) {
+        state().binds.vertexArray = BindState::UNKNOWN;
+        state().binds.buffers[BindState::bufferTarget(GL_ELEMENT_ARRAY_BUFFER)] = BindState::UNKNOWN;
+        return false;
+    }
+};
+
+template <> struct Observe<id_glDeleteTextures> {
+    static bool redundant(GLsizei, const GLuint *) { state().binds.forgetTextures(); return false; }
+};
+
+template <> struct Observe<id_glDeleteBuffers> {
+    static bool redundant(GLsizei, const GLuint *) { state().binds.forgetBuffers(); return false; }
+};
+
+template <> struct Observe<id_glDeleteFramebuffers> {
+    static bool redundant(GLsizei, const GLuint *) {
+        state().binds.drawFramebuffer = state().binds.readFramebuffer = BindState::UNKNOWN;
+        return false;
+    }
+};
+
+template <> struct Observe<id_glDeleteRenderbuffers> {
+    static bool redundant(GLsizei, const GLuint *) { state().binds.renderbuffer = BindState::UNKNOWN; return false; }
+};
+
+// The wrapper installed in place of one glad pointer
+template <int Id, typename Pointer>
+struct Hook;
+
+template <int Id, typename R, typename... Args>
+struct Hook<Id, R (APIENTRYP)(Args...)> {
+    static R (APIENTRYP original)(Args...);
+
+    static R APIENTRY call(Args... args) {
+        Counters &frame = state().frame;
+        ++frame.calls[Id];
+        if (Observe<Id>::redundant(args...)) ++frame.redundant[Id];
+
+        auto begin = std::chrono::steady_clock::now();
+        if constexpr (std::is_void<R>::value) {
+            original(args...);
+            frame.nanoseconds[Id] += elapsed(begin);
+        } else {
+            R result = original(args...);
+            frame.nanoseconds[Id] += elapsed(begin);
+            return result;
+        }
+    }
+
+    static uint64_t elapsed(std::chrono::steady_clock::time_point begin) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+    }
+};
+
+template <int Id, typename R, typename... Args>
+R (APIENTRYP Hook<Id, R (APIENTRYP)(Args...)>::original)(Args...) = nullptr;
+
+} // namespace gltrace
+
+class GlTrace {
+public:
+    // Wraps every loaded GL function (call after gladLoadGLLoader, on the thread that owns the context)
+    static void install() {
+        gltrace::TraceState &trace = gltrace::state();
+        if (trace.installed) return;
+#define GLTRACE_INSTALL(name) \
+        if (glad_##name) { \
+            using HookType = gltrace::Hook<gltrace::id_##name, decltype(glad_##name)>; \
+            HookType::original = glad_##name; \
+            glad_##name = &HookType::call; \
+        }
+        GLTRACE_FUNCTIONS(GLTRACE_INSTALL)
+#undef GLTRACE_INSTALL
+        trace.binds.forgetAll(); // whatever was bound before is unknown
+        trace.frame = gltrace::Counters();
+        trace.installed = true;
+    }
+
+    // Puts the original function pointers back
+    static void uninstall() {
+        gltrace::TraceState &trace = gltrace::state();
+        if (!trace.installed) return;
+#define GLTRACE_UNINSTALL(name) \
+        { \
+            using HookType = gltrace::Hook<gltrace::id_##name, decltype(glad_##name)>; \
+            if (HookType::original) glad_##name = HookType::original; \
+        }
+        GLTRACE_FUNCTIONS(GLTRACE_UNINSTALL)
+#undef GLTRACE_UNINSTALL
+        trace.installed = false;
+    }
+
+    static bool isInstalled() { return gltrace::state().installed; }
+
+    // Ends the frame being recorded: it becomes getLastFrame() and is added to the run totals
+    static void endFrame() {
+        gltrace::TraceState &trace = gltrace::state();
+        if (!trace.installed) return;
+        trace.last = trace.frame;
+        trace.total.add(trace.frame);
+        trace.frame = gltrace::Counters();
+        ++trace.frames;
+    }
+
+    static const gltrace::Counters &getLastFrame() { return gltrace::state().last; }
+    static const gltrace::Counters &getTotal() { return gltrace::state().total; }
+    static uint64_t getFrames() { return gltrace::state().frames; }
+
+    // State changes of the last frame ended (for RenderCounters::stateChanges), -1 when not installed
+    static int getLastStateChanges() {
+        return isInstalled() ? static_cast<int>(getLastFrame().stateChanges()) : -1;
+    }
+
+    // Last frame: totals, then the `top` entry points with the most calls
+    static void printFrame(int top = 10) {
+        const gltrace::Counters &last = getLastFrame();
+        std::cout << "GL calls (frame " << getFrames() << "): " << last.totalCalls() << " calls, "
+                  << last.totalRedundant() << " redundant binds, "
+                  << static_cast<double>(last.totalNanoseconds()) / 1e6 << " ms CPU\n";
+        printTable(last, 1.0, top);
+    }
+
+    // Averages per frame over every frame traced
+    static void printReport(int top = 20) {
+        uint64_t frames = getFrames();
+        if (frames == 0) return;
+        const gltrace::Counters &total = getTotal();
+        double perFrame = 1.0 / static_cast<double>(frames);
+        std::cout << "GL calls over " << frames << " frames, per frame: " << total.totalCalls() * perFrame << " calls, "
+                  << total.totalRedundant() * perFrame << " redundant binds, "
+                  << static_cast<double>(total.totalNanoseconds()) * perFrame / 1e6 << " ms CPU\n";
+        printTable(total, perFrame, top);
+    }
+
+private:
+    static void printTable(const gltrace::Counters &counters, double scale, int top) {
+        std::vector<int> order;
+        for (int i = 0; i < gltrace::FUNCTION_COUNT; ++i) {
+            if (counters.calls[i]) order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return counters.calls[a] > counters.calls[b]; });
+        if (static_cast<int>(order.size()) > top) order.resize(top);
+
+        for (int id : order) {
+            std::cout << "  " << std::left << std::setw(28) << gltrace::functionName(id) << std::right
+                      << std::setw(10) << counters.calls[id] * scale << " calls";
+            if (counters.redundant[id]) std::cout << " (" << counters.redundant[id] * scale << " redundant)";
+            std::cout << ", " << static_cast<double>(counters.nanoseconds[id]) / static_cast<double>(counters.calls[id])
+                      << " ns each\n";
+        }
+    }
+};
+
+#endif
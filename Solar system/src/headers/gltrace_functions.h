@@ -0,0 +1,698 @@
+#ifndef GLTRACE_FUNCTIONS_H
+#define GLTRACE_FUNCTIONS_H
+
+// Every OpenGL entry point glad loads (include/glad/glad.h), as an X-macro for gltrace.h.
+// Generated, regenerate after updating glad:
+//   grep -oE 'GLAPI PFN[A-Z0-9]+PROC glad_gl[A-Za-z0-9_]+;' include/glad/glad.h | sed -E 's/.*glad_(gl[A-Za-z0-9_]+);/    X(\1) \\/'
+// Names may only be used with # or ## (glad #defines each one to its glad_ pointer).
+#define GLTRACE_FUNCTIONS(X) \
+    X(glCullFace) \
+    X(glFrontFace) \
+    X(glHint) \
+    X(glLineWidth) \
+    X(glPointSize) \
+    X(glPolygonMode) \
+    X(glScissor) \
+    X(glTexParameterf) \
+    X(glTexParameterfv) \
+    X(glTexParameteri) \
+    X(glTexParameteriv) \
+    X(glTexImage1D) \
+    X(glTexImage2D) \
+    X(glDrawBuffer) \
+    X(glClear) \
+    X(glClearColor) \
+    X(glClearStencil) \
+    X(glClearDepth) \
+    X(glStencilMask) \
+    X(glColorMask) \
+    X(glDepthMask) \
+    X(glDisable) \
+    X(glEnable) \
+    X(glFinish) \
+    X(glFlush) \
+    X(glBlendFunc) \
+    X(glLogicOp) \
+    X(glStencilFunc) \
+    X(glStencilOp) \
+    X(glDepthFunc) \
+    X(glPixelStoref) \
+    X(glPixelStorei) \
+    X(glReadBuffer) \
+    X(glReadPixels) \
+    X(glGetBooleanv) \
+    X(glGetDoublev) \
+    X(glGetError) \
+    X(glGetFloatv) \
+    X(glGetIntegerv) \
+    X(glGetString) \
+    X(glGetTexImage) \
+    X(glGetTexParameterfv) \
+    X(glGetTexParameteriv) \
+    X(glGetTexLevelParameterfv) \
+    X(glGetTexLevelParameteriv) \
+    X(glIsEnabled) \
+    X(glDepthRange) \
+    X(glViewport) \
+    X(glDrawArrays) \
+    X(glDrawElements) \
+    X(glPolygonOffset) \
+    X(glCopyTexImage1D) \
+    X(glCopyTexImage2D) \
+    X(glCopyTexSubImage1D) \
+    X(glCopyTexSubImage2D) \
+    X(glTexSubImage1D) \
+    X(glTexSubImage2D) \
+    X(glBindTexture) \
+    X(glDeleteTextures) \
+    X(glGenTextures) \
+    X(glIsTexture) \
+    X(glDrawRangeElements) \
+    X(glTexImage3D) \
+    X(glTexSubImage3D) \
+    X(glCopyTexSubImage3D) \
+    X(glActiveTexture) \
+    X(glSampleCoverage) \
+    X(glCompressedTexImage3D) \
+    X(glCompressedTexImage2D) \
+    X(glCompressedTexImage1D) \
+    X(glCompressedTexSubImage3D) \
+    X(glCompressedTexSubImage2D) \
+    X(glCompressedTexSubImage1D) \
+    X(glGetCompressedTexImage) \
+    X(glBlendFuncSeparate) \
+    X(glMultiDrawArrays) \
+    X(glMultiDrawElements) \
+    X(glPointParameterf) \
+    X(glPointParameterfv) \
+    X(glPointParameteri) \
+    X(glPointParameteriv) \
+    X(glBlendColor) \
+    X(glBlendEquation) \
+    X(glGenQueries) \
+    X(glDeleteQueries) \
+    X(glIsQuery) \
+    X(glBeginQuery) \
+    X(glEndQuery) \
+    X(glGetQueryiv) \
+    X(glGetQueryObjectiv) \
+    X(glGetQueryObjectuiv) \
+    X(glBindBuffer) \
+    X(glDeleteBuffers) \
+    X(glGenBuffers) \
+    X(glIsBuffer) \
+    X(glBufferData) \
+    X(glBufferSubData) \
+    X(glGetBufferSubData) \
+    X(glMapBuffer) \
+    X(glUnmapBuffer) \
+    X(glGetBufferParameteriv) \
+    X(glGetBufferPointerv) \
+    X(glBlendEquationSeparate) \
+    X(glDrawBuffers) \
+    X(glStencilOpSeparate) \
+    X(glStencilFuncSeparate) \
+    X(glStencilMaskSeparate) \
+    X(glAttachShader) \
+    X(glBindAttribLocation) \
+    X(glCompileShader) \
+    X(glCreateProgram) \
+    X(glCreateShader) \
+    X(glDeleteProgram) \
+    X(glDeleteShader) \
+    X(glDetachShader) \
+    X(glDisableVertexAttribArray) \
+    X(glEnableVertexAttribArray) \
+    X(glGetActiveAttrib) \
+    X(glGetActiveUniform) \
+    X(glGetAttachedShaders) \
+    X(glGetAttribLocation) \
+    X(glGetProgramiv) \
+    X(glGetProgramInfoLog) \
+    X(glGetShaderiv) \
+    X(glGetShaderInfoLog) \
+    X(glGetShaderSource) \
+    X(glGetUniformLocation) \
+    X(glGetUniformfv) \
+    X(glGetUniformiv) \
+    X(glGetVertexAttribdv) \
+    X(glGetVertexAttribfv) \
+    X(glGetVertexAttribiv) \
+    X(glGetVertexAttribPointerv) \
+    X(glIsProgram) \
+    X(glIsShader) \
+    X(glLinkProgram) \
+    X(glShaderSource) \
+    X(glUseProgram) \
+    X(glUniform1f) \
+    X(glUniform2f) \
+    X(glUniform3f) \
+    X(glUniform4f) \
+    X(glUniform1i) \
+    X(glUniform2i) \
+    X(glUniform3i) \
+    X(glUniform4i) \
+    X(glUniform1fv) \
+    X(glUniform2fv) \
+    X(glUniform3fv) \
+    X(glUniform4fv) \
+    X(glUniform1iv) \
+    X(glUniform2iv) \
+    X(glUniform3iv) \
+    X(glUniform4iv) \
+    X(glUniformMatrix2fv) \
+    X(glUniformMatrix3fv) \
+    X(glUniformMatrix4fv) \
+    X(glValidateProgram) \
+    X(glVertexAttrib1d) \
+    X(glVertexAttrib1dv) \
+    X(glVertexAttrib1f) \
+    X(glVertexAttrib1fv) \
+    X(glVertexAttrib1s) \
+    X(glVertexAttrib1sv) \
+    X(glVertexAttrib2d) \
+    X(glVertexAttrib2dv) \
+    X(glVertexAttrib2f) \
+    X(glVertexAttrib2fv) \
+    X(glVertexAttrib2s) \
+    X(glVertexAttrib2sv) \
+    X(glVertexAttrib3d) \
+    X(glVertexAttrib3dv) \
+    X(glVertexAttrib3f) \
+    X(glVertexAttrib3fv) \
+    X(glVertexAttrib3s) \
+    X(glVertexAttrib3sv) \
+    X(glVertexAttrib4Nbv) \
+    X(glVertexAttrib4Niv) \
+    X(glVertexAttrib4Nsv) \
+    X(glVertexAttrib4Nub) \
+    X(glVertexAttrib4Nubv) \
+    X(glVertexAttrib4Nuiv) \
+    X(glVertexAttrib4Nusv) \
+    X(glVertexAttrib4bv) \
+    X(glVertexAttrib4d) \
+    X(glVertexAttrib4dv) \
+    X(glVertexAttrib4f) \
+    X(glVertexAttrib4fv) \
+    X(glVertexAttrib4iv) \
+    X(glVertexAttrib4s) \
+    X(glVertexAttrib4sv) \
+    X(glVertexAttrib4ubv) \
+    X(glVertexAttrib4uiv) \
+    X(glVertexAttrib4usv) \
+    X(glVertexAttribPointer) \
+    X(glUniformMatrix2x3fv) \
+    X(glUniformMatrix3x2fv) \
+    X(glUniformMatrix2x4fv) \
+    X(glUniformMatrix4x2fv) \
+    X(glUniformMatrix3x4fv) \
+    X(glUniformMatrix4x3fv) \
+    X(glColorMaski) \
+    X(glEnablei) \
+    X(glDisablei) \
+    X(glIsEnabledi) \
+    X(glBeginTransformFeedback) \
+    X(glEndTransformFeedback) \
+    X(glBindBufferRange) \
+    X(glBindBufferBase) \
+    X(glTransformFeedbackVaryings) \
+    X(glGetTransformFeedbackVarying) \
+    X(glClampColor) \
+    X(glBeginConditionalRender) \
+    X(glEndConditionalRender) \
+    X(glVertexAttribIPointer) \
+    X(glGetVertexAttribIiv) \
+    X(glGetVertexAttribIuiv) \
+    X(glVertexAttribI1i) \
+    X(glVertexAttribI2i) \
+    X(glVertexAttribI3i) \
+    X(glVertexAttribI4i) \
+    X(glVertexAttribI1ui) \
+    X(glVertexAttribI2ui) \
+    X(glVertexAttribI3ui) \
+    X(glVertexAttribI4ui) \
+    X(glVertexAttribI1iv) \
+    X(glVertexAttribI2iv) \
+    X(glVertexAttribI3iv) \
+    X(glVertexAttribI4iv) \
+    X(glVertexAttribI1uiv) \
+    X(glVertexAttribI2uiv) \
+    X(glVertexAttribI3uiv) \
+    X(glVertexAttribI4uiv) \
+    X(glVertexAttribI4bv) \
+    X(glVertexAttribI4sv) \
+    X(glVertexAttribI4ubv) \
+    X(glVertexAttribI4usv) \
+    X(glGetUniformuiv) \
+    X(glBindFragDataLocation) \
+    X(glGetFragDataLocation) \
+    X(glUniform1ui) \
+    X(glUniform2ui) \
+    X(glUniform3ui) \
+    X(glUniform4ui) \
+    X(glUniform1uiv) \
+    X(glUniform2uiv) \
+    X(glUniform3uiv) \
+    X(glUniform4uiv) \
+    X(glTexParameterIiv) \
+    X(glTexParameterIuiv) \
+    X(glGetTexParameterIiv) \
+    X(glGetTexParameterIuiv) \
+    X(glClearBufferiv) \
+    X(glClearBufferuiv) \
+    X(glClearBufferfv) \
+    X(glClearBufferfi) \
+    X(glGetStringi) \
+    X(glIsRenderbuffer) \
+    X(glBindRenderbuffer) \
+    X(glDeleteRenderbuffers) \
+    X(glGenRenderbuffers) \
+    X(glRenderbufferStorage) \
+    X(glGetRenderbufferParameteriv) \
+    X(glIsFramebuffer) \
+    X(glBindFramebuffer) \
+    X(glDeleteFramebuffers) \
+    X(glGenFramebuffers) \
+    X(glCheckFramebufferStatus) \
+    X(glFramebufferTexture1D) \
+    X(glFramebufferTexture2D) \
+    X(glFramebufferTexture3D) \
+    X(glFramebufferRenderbuffer) \
+    X(glGetFramebufferAttachmentParameteriv) \
+    X(glGenerateMipmap) \
+    X(glBlitFramebuffer) \
+    X(glRenderbufferStorageMultisample) \
+    X(glFramebufferTextureLayer) \
+    X(glMapBufferRange) \
+    X(glFlushMappedBufferRange) \
+    X(glBindVertexArray) \
+    X(glDeleteVertexArrays) \
+    X(glGenVertexArrays) \
+    X(glIsVertexArray) \
+    X(glDrawArraysInstanced) \
+    X(glDrawElementsInstanced) \
+    X(glTexBuffer) \
+    X(glPrimitiveRestartIndex) \
+    X(glCopyBufferSubData) \
+    X(glGetUniformIndices) \
+    X(glGetActiveUniformsiv) \
+    X(glGetActiveUniformName) \
+    X(glGetUniformBlockIndex) \
+    X(glGetActiveUniformBlockiv) \
+    X(glGetActiveUniformBlockName) \
+    X(glUniformBlockBinding) \
+    X(glDrawElementsBaseVertex) \
+    X(glDrawRangeElementsBaseVertex) \
+    X(glDrawElementsInstancedBaseVertex) \
+    X(glMultiDrawElementsBaseVertex) \
+    X(glProvokingVertex) \
+    X(glFenceSync) \
+    X(glIsSync) \
+    X(glDeleteSync) \
+    X(glClientWaitSync) \
+    X(glWaitSync) \
+    X(glGetInteger64v) \
+    X(glGetSynciv) \
+    X(glGetBufferParameteri64v) \
+    X(glFramebufferTexture) \
+    X(glTexImage2DMultisample) \
+    X(glTexImage3DMultisample) \
+    X(glGetMultisamplefv) \
+    X(glSampleMaski) \
+    X(glBindFragDataLocationIndexed) \
+    X(glGetFragDataIndex) \
+    X(glGenSamplers) \
+    X(glDeleteSamplers) \
+    X(glIsSampler) \
+    X(glBindSampler) \
+    X(glSamplerParameteri) \
+    X(glSamplerParameteriv) \
+    X(glSamplerParameterf) \
+    X(glSamplerParameterfv) \
+    X(glSamplerParameterIiv) \
+    X(glSamplerParameterIuiv) \
+    X(glGetSamplerParameteriv) \
+    X(glGetSamplerParameterIiv) \
+    X(glGetSamplerParameterfv) \
+    X(glGetSamplerParameterIuiv) \
+    X(glQueryCounter) \
+    X(glGetQueryObjecti64v) \
+    X(glGetQueryObjectui64v) \
+    X(glVertexAttribDivisor) \
+    X(glVertexAttribP1ui) \
+    X(glVertexAttribP1uiv) \
+    X(glVertexAttribP2ui) \
+    X(glVertexAttribP2uiv) \
+    X(glVertexAttribP3ui) \
+    X(glVertexAttribP3uiv) \
+    X(glVertexAttribP4ui) \
+    X(glVertexAttribP4uiv) \
+    X(glVertexP2ui) \
+    X(glVertexP2uiv) \
+    X(glVertexP3ui) \
+    X(glVertexP3uiv) \
+    X(glVertexP4ui) \
+    X(glVertexP4uiv) \
+    X(glTexCoordP1ui) \
+    X(glTexCoordP1uiv) \
+    X(glTexCoordP2ui) \
+    X(glTexCoordP2uiv) \
+    X(glTexCoordP3ui) \
+    X(glTexCoordP3uiv) \
+    X(glTexCoordP4ui) \
+    X(glTexCoordP4uiv) \
+    X(glMultiTexCoordP1ui) \
+    X(glMultiTexCoordP1uiv) \
+    X(glMultiTexCoordP2ui) \
+    X(glMultiTexCoordP2uiv) \
+    X(glMultiTexCoordP3ui) \
+    X(glMultiTexCoordP3uiv) \
+    X(glMultiTexCoordP4ui) \
+    X(glMultiTexCoordP4uiv) \
+    X(glNormalP3ui) \
+    X(glNormalP3uiv) \
+    X(glColorP3ui) \
+    X(glColorP3uiv) \
+    X(glColorP4ui) \
+    X(glColorP4uiv) \
+    X(glSecondaryColorP3ui) \
+    X(glSecondaryColorP3uiv) \
+    X(glMinSampleShading) \
+    X(glBlendEquationi) \
+    X(glBlendEquationSeparatei) \
+    X(glBlendFunci) \
+    X(glBlendFuncSeparatei) \
+    X(glDrawArraysIndirect) \
+    X(glDrawElementsIndirect) \
+    X(glUniform1d) \
+    X(glUniform2d) \
+    X(glUniform3d) \
+    X(glUniform4d) \
+    X(glUniform1dv) \
+    X(glUniform2dv) \
+    X(glUniform3dv) \
+    X(glUniform4dv) \
+    X(glUniformMatrix2dv) \
+    X(glUniformMatrix3dv) \
+    X(glUniformMatrix4dv) \
+    X(glUniformMatrix2x3dv) \
+    X(glUniformMatrix2x4dv) \
+    X(glUniformMatrix3x2dv) \
+    X(glUniformMatrix3x4dv) \
+    X(glUniformMatrix4x2dv) \
+    X(glUniformMatrix4x3dv) \
+    X(glGetUniformdv) \
+    X(glGetSubroutineUniformLocation) \
+    X(glGetSubroutineIndex) \
+    X(glGetActiveSubroutineUniformiv) \
+    X(glGetActiveSubroutineUniformName) \
+    X(glGetActiveSubroutineName) \
+    X(glUniformSubroutinesuiv) \
+    X(glGetUniformSubroutineuiv) \
+    X(glGetProgramStageiv) \
+    X(glPatchParameteri) \
+    X(glPatchParameterfv) \
+    X(glBindTransformFeedback) \
+    X(glDeleteTransformFeedbacks) \
+    X(glGenTransformFeedbacks) \
+    X(glIsTransformFeedback) \
+    X(glPauseTransformFeedback) \
+    X(glResumeTransformFeedback) \
+    X(glDrawTransformFeedback) \
+    X(glDrawTransformFeedbackStream) \
+    X(glBeginQueryIndexed) \
+    X(glEndQueryIndexed) \
+    X(glGetQueryIndexediv) \
+    X(glReleaseShaderCompiler) \
+    X(glShaderBinary) \
+    X(glGetShaderPrecisionFormat) \
+    X(glDepthRangef) \
+    X(glClearDepthf) \
+    X(glGetProgramBinary) \
+    X(glProgramBinary) \
+    X(glProgramParameteri) \
+    X(glUseProgramStages) \
+    X(glActiveShaderProgram) \
+    X(glCreateShaderProgramv) \
+    X(glBindProgramPipeline) \
+    X(glDeleteProgramPipelines) \
+    X(glGenProgramPipelines) \
+    X(glIsProgramPipeline) \
+    X(glGetProgramPipelineiv) \
+    X(glProgramUniform1i) \
+    X(glProgramUniform1iv) \
+    X(glProgramUniform1f) \
+    X(glProgramUniform1fv) \
+    X(glProgramUniform1d) \
+    X(glProgramUniform1dv) \
+    X(glProgramUniform1ui) \
+    X(glProgramUniform1uiv) \
+    X(glProgramUniform2i) \
+    X(glProgramUniform2iv) \
+    X(glProgramUniform2f) \
+    X(glProgramUniform2fv) \
+    X(glProgramUniform2d) \
+    X(glProgramUniform2dv) \
+    X(glProgramUniform2ui) \
+    X(glProgramUniform2uiv) \
+    X(glProgramUniform3i) \
+    X(glProgramUniform3iv) \
+    X(glProgramUniform3f) \
+    X(glProgramUniform3fv) \
+    X(glProgramUniform3d) \
+    X(glProgramUniform3dv) \
+    X(glProgramUniform3ui) \
+    X(glProgramUniform3uiv) \
+    X(glProgramUniform4i) \
+    X(glProgramUniform4iv) \
+    X(glProgramUniform4f) \
+    X(glProgramUniform4fv) \
+    X(glProgramUniform4d) \
+    X(glProgramUniform4dv) \
+    X(glProgramUniform4ui) \
+    X(glProgramUniform4uiv) \
+    X(glProgramUniformMatrix2fv) \
+    X(glProgramUniformMatrix3fv) \
+    X(glProgramUniformMatrix4fv) \
+    X(glProgramUniformMatrix2dv) \
+    X(glProgramUniformMatrix3dv) \
+    X(glProgramUniformMatrix4dv) \
+    X(glProgramUniformMatrix2x3fv) \
+    X(glProgramUniformMatrix3x2fv) \
+    X(glProgramUniformMatrix2x4fv) \
+    X(glProgramUniformMatrix4x2fv) \
+    X(glProgramUniformMatrix3x4fv) \
+    X(glProgramUniformMatrix4x3fv) \
+    X(glProgramUniformMatrix2x3dv) \
+    X(glProgramUniformMatrix3x2dv) \
+    X(glProgramUniformMatrix2x4dv) \
+    X(glProgramUniformMatrix4x2dv) \
+    X(glProgramUniformMatrix3x4dv) \
+    X(glProgramUniformMatrix4x3dv) \
+    X(glValidateProgramPipeline) \
+    X(glGetProgramPipelineInfoLog) \
+    X(glVertexAttribL1d) \
+    X(glVertexAttribL2d) \
+    X(glVertexAttribL3d) \
+    X(glVertexAttribL4d) \
+    X(glVertexAttribL1dv) \
+    X(glVertexAttribL2dv) \
+    X(glVertexAttribL3dv) \
+    X(glVertexAttribL4dv) \
+    X(glVertexAttribLPointer) \
+    X(glGetVertexAttribLdv) \
+    X(glViewportArrayv) \
+    X(glViewportIndexedf) \
+    X(glViewportIndexedfv) \
+    X(glScissorArrayv) \
+    X(glScissorIndexed) \
+    X(glScissorIndexedv) \
+    X(glDepthRangeArrayv) \
+    X(glDepthRangeIndexed) \
+    X(glDrawArraysInstancedBaseInstance) \
+    X(glDrawElementsInstancedBaseInstance) \
+    X(glDrawElementsInstancedBaseVertexBaseInstance) \
+    X(glGetInternalformativ) \
+    X(glGetActiveAtomicCounterBufferiv) \
+    X(glBindImageTexture) \
+    X(glMemoryBarrier) \
+    X(glTexStorage1D) \
+    X(glTexStorage2D) \
+    X(glTexStorage3D) \
+    X(glDrawTransformFeedbackInstanced) \
+    X(glDrawTransformFeedbackStreamInstanced) \
+    X(glClearBufferData) \
+    X(glClearBufferSubData) \
+    X(glDispatchCompute) \
+    X(glDispatchComputeIndirect) \
+    X(glCopyImageSubData) \
+    X(glFramebufferParameteri) \
+    X(glGetFramebufferParameteriv) \
+    X(glGetInternalformati64v) \
+    X(glInvalidateTexSubImage) \
+    X(glInvalidateTexImage) \
+    X(glInvalidateBufferSubData) \
+    X(glInvalidateBufferData) \
+    X(glInvalidateFramebuffer) \
+    X(glInvalidateSubFramebuffer) \
+    X(glMultiDrawArraysIndirect) \
+    X(glMultiDrawElementsIndirect) \
+    X(glGetProgramInterfaceiv) \
+    X(glGetProgramResourceIndex) \
+    X(glGetProgramResourceName) \
+    X(glGetProgramResourceiv) \
+    X(glGetProgramResourceLocation) \
+    X(glGetProgramResourceLocationIndex) \
+    X(glShaderStorageBlockBinding) \
+    X(glTexBufferRange) \
+    X(glTexStorage2DMultisample) \
+    X(glTexStorage3DMultisample) \
+    X(glTextureView) \
+    X(glBindVertexBuffer) \
+    X(glVertexAttribFormat) \
+    X(glVertexAttribIFormat) \
+    X(glVertexAttribLFormat) \
+    X(glVertexAttribBinding) \
+    X(glVertexBindingDivisor) \
+    X(glDebugMessageControl) \
+    X(glDebugMessageInsert) \
+    X(glDebugMessageCallback) \
+    X(glGetDebugMessageLog) \
+    X(glPushDebugGroup) \
+    X(glPopDebugGroup) \
+    X(glObjectLabel) \
+    X(glGetObjectLabel) \
+    X(glObjectPtrLabel) \
+    X(glGetObjectPtrLabel) \
+    X(glGetPointerv) \
+    X(glBufferStorage) \
+    X(glClearTexImage) \
+    X(glClearTexSubImage) \
+    X(glBindBuffersBase) \
+    X(glBindBuffersRange) \
+    X(glBindTextures) \
+    X(glBindSamplers) \
+    X(glBindImageTextures) \
+    X(glBindVertexBuffers) \
+    X(glClipControl) \
+    X(glCreateTransformFeedbacks) \
+    X(glTransformFeedbackBufferBase) \
+    X(glTransformFeedbackBufferRange) \
+    X(glGetTransformFeedbackiv) \
+    X(glCreateBuffers) \
+    X(glNamedBufferStorage) \
+    X(glNamedBufferData) \
+    X(glNamedBufferSubData) \
+    X(glCopyNamedBufferSubData) \
+    X(glClearNamedBufferData) \
+    X(glClearNamedBufferSubData) \
+    X(glMapNamedBuffer) \
+    X(glMapNamedBufferRange) \
+    X(glUnmapNamedBuffer) \
+    X(glFlushMappedNamedBufferRange) \
+    X(glGetNamedBufferParameteriv) \
+    X(glGetNamedBufferParameteri64v) \
+    X(glGetNamedBufferPointerv) \
+    X(glGetNamedBufferSubData) \
+    X(glCreateFramebuffers) \
+    X(glNamedFramebufferRenderbuffer) \
+    X(glNamedFramebufferParameteri) \
+    X(glNamedFramebufferTexture) \
+    X(glNamedFramebufferTextureLayer) \
+    X(glNamedFramebufferDrawBuffer) \
+    X(glNamedFramebufferDrawBuffers) \
+    X(glNamedFramebufferReadBuffer) \
+    X(glInvalidateNamedFramebufferData) \
+    X(glInvalidateNamedFramebufferSubData) \
+    X(glClearNamedFramebufferiv) \
+    X(glClearNamedFramebufferuiv) \
+    X(glClearNamedFramebufferfv) \
+    X(glClearNamedFramebufferfi) \
+    X(glBlitNamedFramebuffer) \
+    X(glCheckNamedFramebufferStatus) \
+    X(glGetNamedFramebufferParameteriv) \
+    X(glGetNamedFramebufferAttachmentParameteriv) \
+    X(glCreateRenderbuffers) \
+    X(glNamedRenderbufferStorage) \
+    X(glNamedRenderbufferStorageMultisample) \
+    X(glGetNamedRenderbufferParameteriv) \
+    X(glCreateTextures) \
+    X(glTextureBuffer) \
+    X(glTextureBufferRange) \
+    X(glTextureStorage1D) \
+    X(glTextureStorage2D) \
+    X(glTextureStorage3D) \
+    X(glTextureStorage2DMultisample) \
+    X(glTextureStorage3DMultisample) \
+    X(glTextureSubImage1D) \
+    X(glTextureSubImage2D) \
+    X(glTextureSubImage3D) \
+    X(glCompressedTextureSubImage1D) \
+    X(glCompressedTextureSubImage2D) \
+    X(glCompressedTextureSubImage3D) \
+    X(glCopyTextureSubImage1D) \
+    X(glCopyTextureSubImage2D) \
+    X(glCopyTextureSubImage3D) \
+    X(glTextureParameterf) \
+    X(glTextureParameterfv) \
+    X(glTextureParameteri) \
+    X(glTextureParameterIiv) \
+    X(glTextureParameterIuiv) \
+    X(glTextureParameteriv) \
+    X(glGenerateTextureMipmap) \
+    X(glBindTextureUnit) \
+    X(glGetTextureImage) \
+    X(glGetCompressedTextureImage) \
+    X(glGetTextureLevelParameterfv) \
+    X(glGetTextureLevelParameteriv) \
+    X(glGetTextureParameterfv) \
+    X(glGetTextureParameterIiv) \
+    X(glGetTextureParameterIuiv) \
+    X(glGetTextureParameteriv) \
+    X(glCreateVertexArrays) \
+    X(glDisableVertexArrayAttrib) \
+    X(glEnableVertexArrayAttrib) \
+    X(glVertexArrayElementBuffer) \
+    X(glVertexArrayVertexBuffer) \
+    X(glVertexArrayVertexBuffers) \
+    X(glVertexArrayAttribBinding) \
+    X(glVertexArrayAttribFormat) \
+    X(glVertexArrayAttribIFormat) \
+    X(glVertexArrayAttribLFormat) \
+    X(glVertexArrayBindingDivisor) \
+    X(glGetVertexArrayiv) \
+    X(glGetVertexArrayIndexediv) \
+    X(glGetVertexArrayIndexed64iv) \
+    X(glCreateSamplers) \
+    X(glCreateProgramPipelines) \
+    X(glCreateQueries) \
+    X(glGetQueryBufferObjecti64v) \
+    X(glGetQueryBufferObjectiv) \
+    X(glGetQueryBufferObjectui64v) \
+    X(glGetQueryBufferObjectuiv) \
+    X(glMemoryBarrierByRegion) \
+    X(glGetTextureSubImage) \
+    X(glGetCompressedTextureSubImage) \
+    X(glGetGraphicsResetStatus) \
+    X(glGetnCompressedTexImage) \
+    X(glGetnTexImage) \
+    X(glGetnUniformdv) \
+    X(glGetnUniformfv) \
+    X(glGetnUniformiv) \
+    X(glGetnUniformuiv) \
+    X(glReadnPixels) \
+    X(glGetnMapdv) \
+    X(glGetnMapfv) \
+    X(glGetnMapiv) \
+    X(glGetnPixelMapfv) \
+    X(glGetnPixelMapuiv) \
+    X(glGetnPixelMapusv) \
+    X(glGetnPolygonStipple) \
+    X(glGetnColorTable) \
+    X(glGetnConvolutionFilter) \
+    X(glGetnSeparableFilter) \
+    X(glGetnHistogram) \
+    X(glGetnMinmax) \
+    X(glTextureBarrier) \
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <glad/glad.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+// GPU time per render pass, from GL_TIMESTAMP queries.
+//
+// Every push() / pop() writes a timestamp into the GPU command stream, so scopes can nest
+// (GL_TIME_ELAPSED queries can't). Each frame in flight has its own pool of query objects, and a frame's
+// results are only read FRAMES frames later, once the GPU is long done with it: reading never stalls.
+// If a frame is still not finished by then its results are skipped (counted in getSkippedFrames()).
+//
+// Usage per frame (render thread, context current):
+//   profiler.beginFrame();
+//   profiler.push("planets");
+//       profiler.push("Earth"); ... draw ... profiler.pop();
+//   profiler.pop();
+//   profiler.endFrame();
+//
+// Passes are identified by their path ("planets/Earth") and keep a rolling average. The report lists every pass
+// under its parent, siblings in the order they first appeared.
+class GpuProfiler {
+public:
+    static const int FRAMES = 3; // frames between issuing the queries and reading them back
+
+    struct Pass {
+        std::string name;      // path, e.g "planets/Earth"
+        int depth = 0;         // 0 = top level
+        int parent = -1;       // index of the enclosing pass, -1 = top level
+        float lastMs = 0.0f;   // newest measurement
+        float averageMs = 0.0f; // exponential moving average (about the last 10 frames)
+        float maxMs = 0.0f;
+        double totalMs = 0.0;  // sum of every measurement, for benchmark means
+        unsigned long samples = 0;
+
+        double getMeanMs() const { return samples ? totalMs / samples : 0.0; }
+    };
+
+    // Reads back the frame issued FRAMES frames ago, then starts recording a new one
+    void beginFrame() {
+        Frame &frame = frames[frameIndex % FRAMES];
+        collect(frame);
+        frame.scopes.clear();
+        frame.used = 0;
+        stack.clear();
+    }
+
+    void push(const std::string &name) {
+        int parent = stack.empty() ? -1 : frames[frameIndex % FRAMES].scopes[stack.back()].pass;
+        Frame &frame = frames[frameIndex % FRAMES];
+        Scope scope;
+        scope.pass = findPass(parent, name);
+        scope.begin = timestamp(frame);
+        stack.push_back(static_cast<int>(frame.scopes.size()));
+        frame.scopes.push_back(scope);
+    }
+
+    void pop() {
+        if (stack.empty()) return;
+        Frame &frame = frames[frameIndex % FRAMES];
+        frame.scopes[stack.back()].end = timestamp(frame);
+        stack.pop_back();
+    }
+
+    void endFrame() {
+        while (!stack.empty()) pop(); // close scopes left open
+        ++frameIndex;
+    }
+
+    const std::vector<Pass> &getPasses() const { return passes; }
+    unsigned long getSkippedFrames() const { return skipped; }
+
+    // Average ms of a pass by path, 0 if it never ran
+    float getAverageMs(const std::string &path) const {
+        for (const Pass &pass : passes) {
+            if (pass.name == path) return pass.averageMs;
+        }
+        return 0.0f;
+    }
+
+    // Newest measurement of a pass by path, 0 if it never ran
+    float getLastMs(const std::string &path) const {
+        for (const Pass &pass : passes) {
+            if (pass.name == path) return pass.lastMs;
+        }
+        return 0.0f;
+    }
+
+    // One line with the passes up to `maxDepth` (rolling averages)
+    void printSummary(int maxDepth = 0) const {
+        std::cout << "GPU (ms):";
+        const char *separator = " ";
+        for (const Pass &pass : passes) {
+            if (pass.depth > maxDepth) continue;
+            std::cout << separator << pass.name << " " << pass.averageMs;
+            separator = ", ";
+        }
+        std::cout << "\n";
+    }
+
+    // Every pass as a tree, indented under its parent: rolling average, mean and max over the whole run
+    void printReport() const {
+        std::cout << "GPU passes (avg / mean / max ms):\n";
+        printChildren(-1);
+        if (skipped) std::cout << "  (" << skipped << " frames not finished in time, skipped)\n";
+    }
+
+    void del() {
+        for (Frame &frame : frames) {
+            if (!frame.queries.empty()) glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+            frame.queries.clear();
+            frame.scopes.clear();
+            frame.used = 0;
+        }
+    }
+
+private:
+    struct Scope {
+        int pass = 0;
+        int begin = -1; // indices into Frame::queries
+        int end = -1;
+    };
+
+    struct Frame {
+        std::vector<GLuint> queries; // pool, grows to the most scopes ever used in one frame
+        size_t used = 0;
+        std::vector<Scope> scopes;
+    };
+
+    Frame frames[FRAMES];
+    unsigned long frameIndex = 0;
+    std::vector<int> stack;              // open scopes (indices into the current frame's scopes)
+    std::vector<Pass> passes;
+    std::map<std::pair<int, std::string>, int> passIndex; // (parent pass, name) -> pass
+    unsigned long skipped = 0;
+    std::vector<GLuint64> times;         // read back results (kept to avoid reallocating)
+
+    // Passes seen first in a later frame (a body coming into view) still print under their own parent
+    void printChildren(int parent) const {
+        for (size_t i = 0; i < passes.size(); ++i) {
+            const Pass &pass = passes[i];
+            if (pass.parent != parent) continue;
+            std::cout << std::string(2 + pass.depth * 2, ' ') << pass.name.substr(pass.name.rfind('/') + 1) << ": "
+                      << pass.averageMs << " / " << pass.getMeanMs() << " / " << pass.maxMs << "\n";
+            printChildren(static_cast<int>(i));
+        }
+    }
+
+    int timestamp(Frame &frame) {
+        if (frame.used == frame.queries.size()) {
+            GLuint query;
+            glGenQueries(1, &query);
+            frame.queries.push_back(query);
+        }
+        glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+        return static_cast<int>(frame.used++);
+    }
+
+    int findPass(int parent, const std::string &name) {
+        auto found = passIndex.find(std::make_pair(parent, name));
+        if (found != passIndex.end()) return found->second;
+
+        Pass pass;
+        pass.name = parent < 0 ? name : passes[parent].name + "/" + name;
+        pass.depth = parent < 0 ? 0 : passes[parent].depth + 1;
+        pass.parent = parent;
+        passes.push_back(pass);
+        int index = static_cast<int>(passes.size()) - 1;
+        passIndex[std::make_pair(parent, name)] = index;
+        return index;
+    }
+
+    void collect(Frame &frame) {
+        if (frame.used == 0) return;
+
+        // timestamps complete in order: if the last one is there, all of them are
+        GLuint available = 0;
+        glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            ++skipped;
+            return;
+        }
+
+        times.resize(frame.used);
+        for (size_t i = 0; i < frame.used; ++i) {
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &times[i]);
+        }
+        for (const Scope &scope : frame.scopes) {
+            if (scope.end < 0) continue;
+            float ms = static_cast<float>(static_cast<double>(times[scope.end] - times[scope.begin]) / 1.0e6);
+            Pass &pass = passes[scope.pass];
+            pass.lastMs = ms;
+            pass.averageMs = pass.samples == 0 ? ms : pass.averageMs * 0.9f + ms * 0.1f;
+            if (ms > pass.maxMs) pass.maxMs = ms;
+            pass.totalMs += ms;
+            ++pass.samples;
+        }
+    }
+};
+
+#endif
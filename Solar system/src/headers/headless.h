@@ -0,0 +1,166 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Headless OpenGL: no window, no display server, no GPU needed.
+// Creates a surfaceless EGL context (Mesa's llvmpipe software rasteriser when there is no GPU) and renders into
+// an offscreen framebuffer of any size. Linux only, link with -lEGL.
+//
+// Usage:
+//   HeadlessContext context(1280, 720);
+//   if (context.Initialise() != 0) return 1;    // OpenGL is loaded and the framebuffer bound
+//   for (int frame = 0; frame < frames; ++frame) {
+//       double time = context.getTime();         // fixed timestep: frame * timestep, not the wall clock
+//       ... draw ...
+//       context.endFrame();                      // stands in for swapBuffers
+//       context.saveFrame("frame_0001.ppm");     // optional
+//   }
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class HeadlessContext {
+public:
+    HeadlessContext(int width = 1200, int height = 800, double timestep = 1.0 / 60.0)
+        : width(width), height(height), timestep(timestep) {}
+
+    HeadlessContext(const HeadlessContext &) = delete;
+    HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+    ~HeadlessContext() { del(); }
+
+    // Returns 0 on success, like Window::Initialise
+    int Initialise() {
+        // surfaceless platform first (needs no X / Wayland at all), then whatever the default display is
+        const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+            auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        EGLint major = 0, minor = 0;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            std::cerr << "EGL initialization failed!\n";
+            return 1;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "EGL has no desktop OpenGL!\n";
+            return 1;
+        }
+
+        // same context as Window: OpenGL 3.3 core (drivers hand out the newest compatible version)
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        EGLConfig config = nullptr;
+        const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLint configCount = 0;
+        eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+        context = eglCreateContext(display, configCount > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cerr << "EGL context creation failed!\n";
+            return 1;
+        }
+
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+            std::cerr << "Failed to initialize GLAD\n";
+            return 1;
+        }
+        std::cout << "Headless: " << glGetString(GL_RENDERER) << ", OpenGL " << glGetString(GL_VERSION)
+                  << ", " << width << "x" << height << "\n";
+
+        // offscreen colour + depth, used in place of the window's default framebuffer
+        glGenFramebuffers(1, &FBO);
+        glGenRenderbuffers(1, &colour);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, colour);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colour);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Offscreen framebuffer incomplete!\n";
+            return 1;
+        }
+        bind();
+
+        // Enable depth test
+        glEnable(GL_DEPTH_TEST);
+        return 0;
+    }
+
+    // Binds the offscreen framebuffer again (code that renders to its own framebuffers ends with binding 0)
+    void bind() {
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, width, height);
+    }
+
+    int getBufferWidth() const { return width; }
+    int getBufferHeight() const { return height; }
+    GLuint getFramebuffer() const { return FBO; } // stands in for the window's framebuffer 0
+
+    // Fixed-timestep clock: the same frame always gets the same time, however long rendering took
+    double getTime() const { return static_cast<double>(frame) * timestep; }
+    unsigned long getFrame() const { return frame; }
+
+    // End of a frame (instead of swapBuffers): flushes the GL commands and advances the clock
+    void endFrame() {
+        glFlush();
+        ++frame;
+    }
+
+    // Writes the framebuffer as a binary PPM (readable by most image viewers and converters). Waits for the GPU.
+    bool saveFrame(const std::string &path) {
+        std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cout << "Headless: cannot write " << path << "\n";
+            return false;
+        }
+        out << "P6\n" << width << " " << height << "\n255\n";
+        for (int y = height - 1; y >= 0; --y) { // OpenGL rows start at the bottom
+            out.write(reinterpret_cast<const char *>(&pixels[static_cast<size_t>(y) * width * 3]), width * 3);
+        }
+        return true;
+    }
+
+    void del() {
+        if (display == EGL_NO_DISPLAY) return;
+        if (FBO) {
+            glDeleteFramebuffers(1, &FBO);
+            glDeleteRenderbuffers(1, &colour);
+            glDeleteRenderbuffers(1, &depth);
+            FBO = 0;
+        }
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        context = EGL_NO_CONTEXT;
+        display = EGL_NO_DISPLAY;
+    }
+
+private:
+    int width, height;
+    double timestep;
+    unsigned long frame = 0;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    GLuint FBO = 0, colour = 0, depth = 0;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+
+// Single-producer / single-consumer ring buffer (lock-free).
+// The window thread pushes, one consumer (main loop or a separate sim thread) pops.
+// Capacity must be a power of two. When the consumer falls behind, new items are dropped and counted
+// rather than blocking the window thread.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    // producer only
+    bool push(const T &item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release); // publishes the item to the consumer
+        return true;
+    }
+
+    // consumer only: oldest item without removing it, nullptr if empty
+    const T *peek() const {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return nullptr;
+        return &items[t & (Capacity - 1)];
+    }
+
+    // consumer only
+    bool pop(T &out) {
+        const T *item = peek();
+        if (!item) return false;
+        out = *item;
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); // slot may be reused now
+        return true;
+    }
+
+    size_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<size_t> head{0}; // next slot to write (producer)
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to read (consumer)
+    alignas(64) std::atomic<size_t> dropped{0};
+    T items[Capacity];
+};
+
+// One timestamped input event, as received by the GLFW callbacks
+struct InputEvent {
+    enum Type { Key, MouseButton, MouseMove, Scroll };
+
+    Type type = Key;
+    int code = 0;        // key or mouse button
+    int action = 0;      // GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+    float x = 0.0f;      // MouseMove: cursor delta (right = +x, up = +y), Scroll: offsets
+    float y = 0.0f;
+    double time = 0.0;   // glfwGetTime() when the event arrived
+};
+
+using InputQueue = SpscQueue<InputEvent, 1024>;
+
+// Consumer-side input state rebuilt from the event queue.
+// Mouse motion is summed over every event, so no movement is lost however many events arrive per frame.
+//
+// Usage (once per frame or simulation step):
+//   input.drain(queue);                // or drain(queue, stepEndTime) to stop at a timestamp
+//   camera.mouseControl(input.takeXChange(), input.takeYChange());
+class InputState {
+public:
+    bool keys[1024] = {};
+    bool mouseButtons[8] = {};
+
+    // Applies every queued event up to and including `untilTime`; later events stay queued for the next call
+    template <typename Queue>
+    void drain(Queue &queue, double untilTime = std::numeric_limits<double>::max()) {
+        const InputEvent *event;
+        while ((event = queue.peek()) && event->time <= untilTime) {
+            apply(*event);
+            InputEvent done;
+            queue.pop(done);
+        }
+    }
+
+    void apply(const InputEvent &event) {
+        lastEventTime = event.time;
+        switch (event.type) {
+        case InputEvent::Key:
+            if (event.code >= 0 && event.code < 1024) {
+                if (event.action == 1) { // GLFW_PRESS
+                    keys[event.code] = true;
+                    keyPresses[event.code] = true;
+                    stampInput(event.time);
+                } else if (event.action == 0) { // GLFW_RELEASE
+                    keys[event.code] = false;
+                    stampInput(event.time);
+                }
+            }
+            break;
+        case InputEvent::MouseButton:
+            if (event.code >= 0 && event.code < 8) {
+                if (event.action == 1) {
+                    mouseButtons[event.code] = true;
+                    buttonPresses[event.code] = true;
+                } else if (event.action == 0) {
+                    mouseButtons[event.code] = false;
+                }
+            }
+            break;
+        case InputEvent::MouseMove:
+            xChange += event.x;
+            yChange += event.y;
+            stampInput(event.time);
+            break;
+        case InputEvent::Scroll:
+            scroll += event.y;
+            break;
+        }
+    }
+
+    // Accumulated mouse movement since the last take (resets it)
+    float takeXChange() { float change = xChange; xChange = 0.0f; return change; }
+    float takeYChange() { float change = yChange; yChange = 0.0f; return change; }
+    float takeScroll() { float change = scroll; scroll = 0.0f; return change; }
+
+    // True once per press, even if the key was released again before the consumer looked
+    bool takeKeyPress(int key) { return takeFlag(keyPresses, key, 1024); }
+    bool takeButtonPress(int button) { return takeFlag(buttonPresses, button, 8); }
+
+    // Timestamp of the newest applied event
+    double getLastEventTime() const { return lastEventTime; }
+
+    // Arrival time of the oldest key press / release or mouse move applied since the last take, 0 = none.
+    // Passed on to the camera so the frame that first shows the change can be matched with it (input latency).
+    double takeInputTime() { double time = inputTime; inputTime = 0.0; return time; }
+
+private:
+    bool keyPresses[1024] = {};
+    bool buttonPresses[8] = {};
+    float xChange = 0.0f;
+    float yChange = 0.0f;
+    float scroll = 0.0f;
+    double lastEventTime = 0.0;
+    double inputTime = 0.0;
+
+    void stampInput(double time) {
+        if (inputTime == 0.0) inputTime = time;
+    }
+
+    static bool takeFlag(bool *flags, int index, int count) {
+        if (index < 0 || index >= count || !flags[index]) return false;
+        flags[index] = false;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "profiler.h"
+
+// Work-stealing job scheduler.
+// Every worker owns a lock-free deque (Chase-Lev): the owner pushes/pops at the bottom, idle workers steal from the top.
+// A job is a plain function pointer + data pointer + index range stored inside the deque, so spawning one never allocates.
+// Counters track parent/child work: run() adds one, finishing a job removes one, wait() helps out until it reaches zero.
+//
+// Usage:
+//   JobSystem jobs;                                   // one worker per hardware thread (this thread is worker 0)
+//   jobs.parallelFor(count, [&](size_t begin, size_t end) { ... });
+class JobSystem {
+public:
+    using JobFunction = void (*)(void *data, size_t begin, size_t end);
+
+    struct Counter {
+        std::atomic<int> pending{0};
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    // `threadCount` includes the calling thread, so JobSystem(1) runs everything inline
+    explicit JobSystem(unsigned threadCount = std::thread::hardware_concurrency()) {
+        if (threadCount == 0) threadCount = 1;
+        workers.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            workers.emplace_back(new Worker());
+            workers.back()->random = 0x9E3779B9u * (i + 1);
+        }
+
+        // the constructing thread is worker 0 and helps out inside wait()
+        currentSystem() = this;
+        currentWorker() = 0;
+
+        for (unsigned i = 1; i < threadCount; ++i) {
+            threads.emplace_back(&JobSystem::workerLoop, this, i);
+        }
+    }
+
+    ~JobSystem() {
+        running.store(false);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            sleepCondition.notify_all();
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        if (currentSystem() == this) {
+            currentSystem() = nullptr;
+        }
+    }
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()); }
+
+    // Queue fn(data, begin, end). Threads that are not workers go through a small locked queue instead.
+    void run(JobFunction fn, void *data, size_t begin, size_t end, Counter &counter) {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+        int index = workerIndex();
+        if (index >= 0) {
+            Job job{fn, data, begin, end, &counter};
+            if (!workers[index]->deque.push(job)) {
+                execute(job); // deque full: cheaper to just do it now
+                return;
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(injectMutex);
+            injected.push_back(Job{fn, data, begin, end, &counter});
+            injectedCount.fetch_add(1, std::memory_order_release);
+        }
+        wakeWorker();
+    }
+
+    // Block until every job tracked by `counter` (and the jobs they spawned) is finished.
+    // The waiting thread runs queued jobs meanwhile instead of sleeping.
+    void wait(Counter &counter) {
+        int index = workerIndex();
+        uint32_t random = 0x2545F491u;
+        while (!counter.done()) {
+            Job job;
+            if (findJob(index, index >= 0 ? workers[index]->random : random, job)) {
+                execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Calls body(begin, end) over [0, count) in parallel.
+    // The range is split in halves recursively, so idle workers steal the biggest remaining chunks.
+    // grain = 0 picks ~4 chunks per thread, which keeps every worker busy without drowning in tiny jobs.
+    template <typename F>
+    void parallelFor(size_t count, const F &body, size_t grain = 0) {
+        if (count == 0) return;
+        if (grain == 0) grain = autoGrain(count);
+        if (count <= grain || workers.size() == 1) {
+            body(size_t(0), count);
+            return;
+        }
+
+        Counter counter;
+        ParallelFor<F> task{this, &body, grain, &counter};
+        run(&ParallelFor<F>::execute, &task, 0, count, counter);
+        wait(counter);
+    }
+
+    size_t autoGrain(size_t count) const {
+        size_t chunks = workers.size() * 4;
+        return std::max<size_t>(1, (count + chunks - 1) / chunks);
+    }
+
+private:
+    struct Job {
+        JobFunction fn = nullptr;
+        void *data = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        Counter *counter = nullptr;
+    };
+
+    // Queued jobs per worker. When a worker's deque is full, run() simply executes the job inline.
+    static const size_t JOB_CAPACITY = 4096;
+
+    // Chase-Lev work-stealing deque with a fixed power-of-two ring ("Correct and Efficient Work-Stealing
+    // for Weak Memory Models", Le et al. 2013). Jobs are stored in the ring itself. A thief copies its slot
+    // before claiming it: as soon as `top` moves past a slot, push() may reuse it for a new job (when the
+    // deque is full), so the copy is only kept if the claim succeeded while the slot was still the thief's.
+    class Deque {
+    public:
+        // owner only
+        bool push(const Job &job) {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            if (b - t >= static_cast<int64_t>(JOB_CAPACITY)) return false;
+            slots[b & (JOB_CAPACITY - 1)] = job;
+            bottom.store(b + 1, std::memory_order_release); // publishes the job contents to thieves
+            return true;
+        }
+
+        // owner only
+        bool pop(Job &out) {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b) { // empty
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (t == b) { // last job: race against thieves
+                bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                if (!won) return false;
+            }
+            out = slots[b & (JOB_CAPACITY - 1)];
+            return true;
+        }
+
+        // any thread
+        bool steal(Job &out) {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b) return false;
+
+            Job job = slots[t & (JOB_CAPACITY - 1)]; // if the claim below wins, top was t all along: push() left this slot alone
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return false; // lost the race (the copy may be stale), caller just tries elsewhere
+            }
+            out = job;
+            return true;
+        }
+
+    private:
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        Job slots[JOB_CAPACITY];
+    };
+
+    struct Worker {
+        Deque deque;
+        uint32_t random = 0; // victim selection
+    };
+
+    template <typename F>
+    struct ParallelFor {
+        JobSystem *jobs;
+        const F *body;
+        size_t grain;
+        Counter *counter;
+
+        static void execute(void *data, size_t begin, size_t end) {
+            ParallelFor *task = static_cast<ParallelFor *>(data);
+            // keep the left half, hand the right half to whoever is free
+            while (end - begin > task->grain) {
+                size_t mid = begin + (end - begin) / 2;
+                task->jobs->run(&ParallelFor::execute, data, mid, end, *task->counter);
+                end = mid;
+            }
+            (*task->body)(begin, end);
+        }
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running{true};
+
+    std::mutex injectMutex;
+    std::deque<Job> injected;
+    std::atomic<size_t> injectedCount{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<int> sleeping{0};
+
+    static JobSystem *&currentSystem() {
+        static thread_local JobSystem *system = nullptr;
+        return system;
+    }
+
+    static int &currentWorker() {
+        static thread_local int index = -1;
+        return index;
+    }
+
+    int workerIndex() const { return currentSystem() == this ? currentWorker() : -1; }
+
+    void execute(const Job &job) {
+        job.fn(job.data, job.begin, job.end);
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    void wakeWorker() {
+        if (sleeping.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            sleepCondition.notify_one();
+        }
+    }
+
+    // Own deque first (newest work, still hot in cache), then the injection queue, then steal from a random victim.
+    // index = -1 for threads that are not workers.
+    bool findJob(int index, uint32_t &random, Job &out) {
+        if (index >= 0 && workers[index]->deque.pop(out)) {
+            return true;
+        }
+
+        if (injectedCount.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(injectMutex);
+            if (!injected.empty()) {
+                out = injected.front();
+                injected.pop_front();
+                injectedCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        size_t count = workers.size();
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        size_t start = random % count;
+        for (size_t i = 0; i < count; ++i) {
+            size_t victim = (start + i) % count;
+            if (static_cast<int>(victim) == index) continue;
+            if (workers[victim]->deque.steal(out)) return true;
+        }
+        return false;
+    }
+
+    void workerLoop(unsigned index) {
+        currentSystem() = this;
+        currentWorker() = static_cast<int>(index);
+        PROFILE_THREAD("worker " + std::to_string(index));
+
+        int idleSpins = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            Job job;
+            if (findJob(static_cast<int>(index), workers[index]->random, job)) {
+                execute(job);
+                idleSpins = 0;
+                continue;
+            }
+
+            // spin briefly (new work usually arrives within microseconds), then sleep until run() wakes us
+            if (++idleSpins < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleeping.fetch_add(1);
+            sleepCondition.wait_for(lock, std::chrono::milliseconds(1));
+            sleeping.fetch_sub(1);
+            idleSpins = 0;
+        }
+    }
+};
+
+#endif
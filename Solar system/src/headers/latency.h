@@ -0,0 +1,130 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <glad/glad.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+// Input-to-photon latency: time from an input event's arrival (GLFW callback) until the GPU has finished
+// the first frame that shows its effect.
+//
+// Per frame that reflects new input, a GL_TIMESTAMP query and a fence are inserted after the last draw call.
+// Once the fence has signalled (checked without blocking on later frames), the query holds the GPU clock at completion.
+// GPU clock -> CPU clock (the one the input was stamped with) comes from pairing glGetInteger64v(GL_TIMESTAMP)
+// with a CPU reading, redone every second to follow clock drift.
+// Time after the GPU finishes (compositor, scanout, display) is not included.
+//
+// Usage:
+//   latency.create(glfwGetTime());
+//   ... per frame, after drawing, before swapBuffers:
+//   latency.endFrame(camera.takeInputTime(), glfwGetTime());
+//   ... at the end:
+//   latency.finish(); latency.printReport("camera");
+class LatencyTracker {
+public:
+    void create(double cpuNow) {
+        calibrate(cpuNow);
+    }
+
+    // inputTime = oldest input (CPU seconds) applied this frame, 0 = frame shows no new input
+    void endFrame(double inputTime, double cpuNow) {
+        if (cpuNow - calibratedAt > 1.0) calibrate(cpuNow);
+
+        if (inputTime > 0.0) {
+            Pending frame;
+            frame.inputTime = inputTime;
+            frame.offset = gpuToCpu;
+            if (!freeQueries.empty()) {
+                frame.query = freeQueries.back();
+                freeQueries.pop_back();
+            } else {
+                glGenQueries(1, &frame.query);
+            }
+            glQueryCounter(frame.query, GL_TIMESTAMP);
+            frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            pending.push_back(frame);
+        }
+        collect(0);
+    }
+
+    // Waits for every frame still in flight (end of a run)
+    void finish() {
+        collect(GL_TIMEOUT_IGNORED);
+    }
+
+    size_t getSampleCount() const { return samples.size(); }
+
+    // p in 0..100, milliseconds
+    double getPercentileMs(double p) const {
+        if (samples.empty()) return 0.0;
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)] * 1000.0;
+    }
+
+    double getMeanMs() const {
+        if (samples.empty()) return 0.0;
+        double total = 0.0;
+        for (double s : samples) total += s;
+        return total / static_cast<double>(samples.size()) * 1000.0;
+    }
+
+    void printReport(const std::string &name) const {
+        std::cout << "Input latency (" << name << ", " << samples.size() << " frames): "
+                  << "p50 " << getPercentileMs(50.0) << " ms, p90 " << getPercentileMs(90.0)
+                  << " ms, p99 " << getPercentileMs(99.0) << " ms, max " << getPercentileMs(100.0) << " ms\n";
+    }
+
+    void clear() { samples.clear(); }
+
+    void del() {
+        finish();
+        if (!freeQueries.empty()) glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+        freeQueries.clear();
+    }
+
+private:
+    struct Pending {
+        double inputTime = 0.0;
+        double offset = 0.0; // GPU -> CPU clock offset when the frame was submitted
+        GLuint query = 0;
+        GLsync fence = nullptr;
+    };
+
+    std::deque<Pending> pending; // oldest first
+    std::vector<GLuint> freeQueries;
+    std::vector<double> samples; // seconds
+    double gpuToCpu = 0.0;       // cpuSeconds = gpuSeconds + gpuToCpu
+    double calibratedAt = 0.0;
+
+    void calibrate(double cpuNow) {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuToCpu = cpuNow - static_cast<double>(gpuNow) * 1e-9;
+        calibratedAt = cpuNow;
+    }
+
+    // timeout 0 = only take frames that are already done
+    void collect(GLuint64 timeout) {
+        while (!pending.empty()) {
+            Pending &frame = pending.front();
+            GLenum status = glClientWaitSync(frame.fence, timeout == 0 ? 0 : GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            if (status == GL_TIMEOUT_EXPIRED) return;
+
+            GLuint64 gpuDone = 0;
+            glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &gpuDone);
+            double cpuDone = static_cast<double>(gpuDone) * 1e-9 + frame.offset;
+            samples.push_back(std::max(0.0, cpuDone - frame.inputTime));
+
+            glDeleteSync(frame.fence);
+            freeQueries.push_back(frame.query);
+            pending.pop_front();
+        }
+    }
+};
+
+#endif
@@ -4,405 +4,744 @@
 #include "config.h"
 #include "shader.h"
 #include "camera.h"
+#include "solar.h"
+#include "jobs.h"
+#include "particles.h"
+#include "bvh.h"
+#include "camerabuffer.h"
+#include "framepacket.h"
+#include "gpuprofiler.h"
+#include "profiler.h"
+#include "framestats.h"
+#include "dynamicres.h"
+#include "framegraph.h"
+#include "postprocess.h"
+#include "occlusion.h"
+#include "skybox.h"
+#include "cubemap.h"
+#include "meshopt.h"
+#include "vertexformat.h"
 #include <math.h>
+#include <fstream>
 #define M_PI 3.14159265358979323846
 
-void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
-               const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
-               unsigned int &lightVAO, unsigned int &backgroundVAO, unsigned int &backgroundVBO,  const float* quadVertices, size_t quadSizeBytes);
+void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO, const PackedMesh &mesh,
+               unsigned int &lightVAO);
 
 // Draw sphere
+// Each row of vertices / indices is written to its own slice, so rows can be built in parallel with a job system.
 void createSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices,
-                  unsigned int X_SEGMENTS = 128, unsigned int Y_SEGMENTS = 128, float radius = 1.0f) {
-    for (unsigned int y = 0; y <= Y_SEGMENTS; ++y) {
-        for (unsigned int x = 0; x <= X_SEGMENTS; ++x) {
-            float xSegment = static_cast<float>(x) / X_SEGMENTS;
-            float ySegment = static_cast<float>(y) / Y_SEGMENTS;
-
-            float theta = ySegment * M_PI;
-            float phi = xSegment * 2.0f * M_PI;
-
-            float xPos = radius * std::sin(theta) * std::cos(phi);
-            float yPos = radius * std::cos(theta);
-            float zPos = radius * std::sin(theta) * std::sin(phi);
-
-            // Position
-            vertices.push_back(xPos);
-            vertices.push_back(yPos);
-            vertices.push_back(zPos);
-            
-            // Normal (normalized position vector for unit sphere)
-            float length = std::sqrt(xPos*xPos + yPos*yPos + zPos*zPos);
-            vertices.push_back(xPos / length);
-            vertices.push_back(yPos / length);
-            vertices.push_back(zPos / length);
-            
-            // Texture coordinates
-            vertices.push_back(xSegment);
-            vertices.push_back(ySegment);
+                  unsigned int X_SEGMENTS = 128, unsigned int Y_SEGMENTS = 128, float radius = 1.0f,
+                  JobSystem *jobs = nullptr) {
+    PROFILE_ZONE("createSphere");
+    const size_t floatsPerRow = static_cast<size_t>(X_SEGMENTS + 1) * 8;
+    const size_t indicesPerRow = static_cast<size_t>(X_SEGMENTS) * 6;
+    size_t vertexStart = vertices.size();
+    size_t indexStart = indices.size();
+    vertices.resize(vertexStart + floatsPerRow * (Y_SEGMENTS + 1));
+    indices.resize(indexStart + indicesPerRow * Y_SEGMENTS);
+
+    auto buildRows = [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t row = rowBegin; row < rowEnd; ++row) {
+            unsigned int y = static_cast<unsigned int>(row);
+            float* v = &vertices[vertexStart + floatsPerRow * y];
+
+            for (unsigned int x = 0; x <= X_SEGMENTS; ++x) {
+                float xSegment = static_cast<float>(x) / X_SEGMENTS;
+                float ySegment = static_cast<float>(y) / Y_SEGMENTS;
+
+                float theta = ySegment * M_PI;
+                float phi = xSegment * 2.0f * M_PI;
+
+                float xPos = radius * std::sin(theta) * std::cos(phi);
+                float yPos = radius * std::cos(theta);
+                float zPos = radius * std::sin(theta) * std::sin(phi);
+
+                // Position
+                *v++ = xPos;
+                *v++ = yPos;
+                *v++ = zPos;
+
+                // Normal (normalized position vector for unit sphere)
+                float length = std::sqrt(xPos*xPos + yPos*yPos + zPos*zPos);
+                *v++ = xPos / length;
+                *v++ = yPos / length;
+                *v++ = zPos / length;
+
+                // Texture coordinates
+                *v++ = xSegment;
+                *v++ = ySegment;
+            }
+
+            // Generate indices (the last row of vertices has no quads below it)
+            if (y == Y_SEGMENTS) continue;
+            unsigned int* idx = &indices[indexStart + indicesPerRow * y];
+            for (unsigned int x = 0; x < X_SEGMENTS; ++x) {
+                unsigned int i0 = y * (X_SEGMENTS + 1) + x;
+                unsigned int i1 = (y + 1) * (X_SEGMENTS + 1) + x;
+
+                *idx++ = i0;
+                *idx++ = i1;
+                *idx++ = i0 + 1;
+
+                *idx++ = i0 + 1;
+                *idx++ = i1;
+                *idx++ = i1 + 1;
+            }
         }
-    }
-
-    // Generate indices
-    for (unsigned int y = 0; y < Y_SEGMENTS; ++y) {
-        for (unsigned int x = 0; x < X_SEGMENTS; ++x) {
-            unsigned int i0 = y * (X_SEGMENTS + 1) + x;
-            unsigned int i1 = (y + 1) * (X_SEGMENTS + 1) + x;
+    };
 
-            indices.push_back(i0);
-            indices.push_back(i1);
-            indices.push_back(i0 + 1);
+    if (jobs) {
+        jobs->parallelFor(Y_SEGMENTS + 1, buildRows);
+    } else {
+        buildRows(0, Y_SEGMENTS + 1);
+    }
+}
 
-            indices.push_back(i0 + 1);
-            indices.push_back(i1);
-            indices.push_back(i1 + 1);
+// Draw cube (same box as the Phong demos: 24 vertices so every face gets its own normals and texture coordinates)
+// Same vertex layout as createSphere: position, normal, texture coordinates.
+void createCube(std::vector<float>& vertices, std::vector<unsigned int>& indices, float size = 1.0f) {
+    const float h = size * 0.5f;
+    // u x v points along the normal, so every face is counter-clockwise seen from outside (front facing)
+    const float faces[6][3][3] = { // normal, u axis, v axis of each face
+        {{ 0,  0, -1}, {0, 1, 0}, {1, 0, 0}}, // back
+        {{ 0,  0,  1}, {1, 0, 0}, {0, 1, 0}}, // front
+        {{-1,  0,  0}, {0, 0, 1}, {0, 1, 0}}, // left
+        {{ 1,  0,  0}, {0, 1, 0}, {0, 0, 1}}, // right
+        {{ 0, -1,  0}, {1, 0, 0}, {0, 0, 1}}, // bottom
+        {{ 0,  1,  0}, {0, 0, 1}, {1, 0, 0}}  // top
+    };
+    const float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+    for (int f = 0; f < 6; ++f) {
+        unsigned int first = static_cast<unsigned int>(vertices.size() / 8);
+        const float *n = faces[f][0], *u = faces[f][1], *v = faces[f][2];
+        for (const float *uv : corners) {
+            for (int axis = 0; axis < 3; ++axis) {
+                vertices.push_back(n[axis] * h + (uv[0] * 2.0f - 1.0f) * u[axis] * h + (uv[1] * 2.0f - 1.0f) * v[axis] * h);
+            }
+            vertices.insert(vertices.end(), {n[0], n[1], n[2], uv[0], uv[1]});
         }
+        indices.insert(indices.end(), {first, first + 1, first + 2, first + 2, first + 3, first});
     }
 }
 
-// texture loading function
-unsigned int loadTexture(char const * path) {
+// Decoded image waiting to be uploaded (decoding can run on any thread, uploading must happen on the GL thread)
+struct ImageData {
+    unsigned char *data = nullptr;
+    int width = 0, height = 0, nrComponents = 0;
+};
+
+ImageData decodeImage(char const * path) {
+    PROFILE_ZONE("decodeImage");
+    ImageData image;
+    image.data = stbi_load(path, &image.width, &image.height, &image.nrComponents, 0);
+    return image;
+}
+
+// Creates the GL texture and frees the decoded pixels
+unsigned int uploadTexture(ImageData &image, char const * path) {
+    PROFILE_ZONE("uploadTexture");
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
+    if (image.data)
     {
         GLenum format;
-        if (nrComponents == 1)
+        if (image.nrComponents == 1)
             format = GL_RED;
-        else if (nrComponents == 3)
+        else if (image.nrComponents == 3)
             format = GL_RGB;
-        else if (nrComponents == 4)
+        else if (image.nrComponents == 4)
             format = GL_RGBA;
 
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
     }
     else {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
     }
 
+    stbi_image_free(image.data);
+    image.data = nullptr;
     return textureID;
 }
 
+// GPU memory of a texture's mip levels (GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP), from the sizes the driver reports
+size_t textureBytes(unsigned int texture, GLenum target = GL_TEXTURE_2D) {
+    if (texture == 0) return 0;
+    glBindTexture(target, texture);
+    GLenum image = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+    size_t faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    size_t bytes = 0;
+    for (GLint level = 0; level < 16; ++level) { // 16 levels cover a 32768 texel texture
+        GLint width = 0, height = 0, bits = 0;
+        glGetTexLevelParameteriv(image, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(image, level, GL_TEXTURE_HEIGHT, &height);
+        if (width == 0 || height == 0) break; // past the last level
+        for (GLenum component : {GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE}) {
+            GLint size = 0;
+            glGetTexLevelParameteriv(image, level, component, &size);
+            bits += size;
+        }
+        bytes += faces * static_cast<size_t>(width) * height * static_cast<size_t>((bits + 7) / 8);
+    }
+    glBindTexture(target, 0);
+    return bytes;
+}
+
+// texture loading function
+unsigned int loadTexture(char const * path) {
+    PROFILE_ZONE("loadTexture");
+    ImageData image = decodeImage(path);
+    return uploadTexture(image, path);
+}
+
+// Loads several textures at once: the (slow) image decoding runs on the job system, GL uploads stay on this thread
+std::vector<unsigned int> loadTextures(const std::vector<const char*> &paths, JobSystem *jobs = nullptr) {
+    PROFILE_ZONE("loadTextures");
+    std::vector<ImageData> images(paths.size());
+    auto decode = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            images[i] = decodeImage(paths[i]);
+        }
+    };
+
+    if (jobs) {
+        jobs->parallelFor(paths.size(), decode, 1); // one image per job, they are all big
+    } else {
+        decode(0, paths.size());
+    }
+
+    std::vector<unsigned int> textures(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        textures[i] = uploadTexture(images[i], paths[i]);
+    }
+    return textures;
+}
+
+// The sky's .cubemap file. make_skybox makes it ahead of time, but it is not in the repository: when it is missing
+// (or broken), the star map is converted here and the result saved, so only the first start pays for it.
+// Empty if the star map can't be read either.
+std::vector<char> loadSkyCubemap(const char *cubemapPath, const char *mapPath, JobSystem *jobs = nullptr) {
+    PROFILE_ZONE("loadSkyCubemap");
+    std::vector<char> cubemap = Skybox::readFile(cubemapPath);
+    if (Skybox::isValid(cubemap)) return cubemap;
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char *pixels = stbi_load(mapPath, &width, &height, &channels, 3);
+    if (!pixels) {
+        std::cout << "Sky map failed to load at path: " << mapPath << std::endl;
+        return {};
+    }
+    std::cout << "No sky cubemap at " << cubemapPath << ", converting " << mapPath << " (once)" << std::endl;
+    cubemap = Cubemap::build(pixels, width, height, Cubemap::FACE_SIZE, jobs);
+    stbi_image_free(pixels);
+    std::ofstream file(cubemapPath, std::ios::binary);
+    file.write(cubemap.data(), static_cast<std::streamsize>(cubemap.size()));
+    if (!file) std::cout << "Could not save " << cubemapPath << ", it will be converted again next start" << std::endl;
+    return cubemap;
+}
+
 class Tri {
 private:
-    unsigned int VBO, VAO, EBO, lightVAO, moonVAO, backgroundVAO, backgroundVBO;
+    unsigned int VBO, VAO, EBO, lightVAO, moonVAO;
     float cameraDistance = 3.0f;  // How far away from triangle
     float cameraAngle = 0.0f;     // Which direction around the triangle
-    float deltaTime = 0.0f;	// time between current frame and last frame
-    float lastFrame = 0.0f;
+    double lastFrame = -1.0;   // simulation time of the last rendered packet (particle time step), -1 = none yet
     size_t indexCount;
+    GLenum indexType = GL_UNSIGNED_INT; // the sphere's indices (16-bit when its vertices allow)
+    int normalEncoding = 0;             // how the sphere's normals are stored (PackedMesh::normalEncoding)
+    SolarSystem solar; // sun, planets, moon and ring as a scene graph
+    std::vector<int> visible; // bodies inside the view frustum this frame
+    JobSystem *jobs;
+    ParticleSystem *particles; // sun corona + solar wind, simulated on the GPU
+    double reportTime = 0.0;   // last time the GPU pass timings were printed
+    BodyBVH bvh;               // bounding spheres of all bodies, for picking
+    int picked = -1;           // body under the crosshair when last clicked, -1 = none
+    CameraBuffer cameraBuffer; // view / projection / camera position for every shader (uniform block ring)
+    FramePacket packet;        // reused by draw() (single-threaded rendering)
+    GpuProfiler profiler;      // GPU time of each pass and body (render thread)
+    std::vector<std::string> bodyNames; // copied once, so the render thread never reads the scene
+    RenderCounters counters;   // what the last render() sent to OpenGL
+    int viewportWidth = 1200, viewportHeight = 800; // size of the framebuffer drawn into
+    DynamicResolution resolution; // scene render scale from the GPU frame time (render thread)
+    FrameGraph graph;             // passes of a frame and the offscreen textures between them (render thread)
+    PostProcess postProcess;      // upscale and bloom passes
+    bool bloom = false;           // glow around bright parts (the sun), drawn through the frame graph
+    OcclusionCuller occlusion;    // skips bodies hidden behind the sun and planets (simulation thread)
+    Skybox skybox;                // star cubemap, drawn after the bodies (render thread)
 
 public:
-    unsigned int earthDiffuseMap = loadTexture("asset/textures/earth.png");    // Replace with your Earth texture path
-    unsigned int earthSpecularMap = loadTexture("asset/textures/earth_specular.png"); 
-    unsigned int sunTexture = loadTexture("asset/textures/sun.png"); // Or PNG
-    unsigned int backgroundTexture = loadTexture("asset/textures/stars.png");
-    unsigned int moonTexture = loadTexture("asset/textures/moon.png");
-    unsigned int mercury = loadTexture("asset/textures/mercury.png");
-    unsigned int mars = loadTexture("asset/textures/mars.png");
-    unsigned int venus = loadTexture("asset/textures/venus.png");
-    unsigned int uranus = loadTexture("asset/textures/uranus.png");
-    unsigned int neptune = loadTexture("asset/textures/neptune.png");
-    unsigned int saturn = loadTexture("asset/textures/saturn.png");
-    unsigned int saturnRing = loadTexture("asset/textures/saturn_ring.png");
-    unsigned int jupiter = loadTexture("asset/textures/jupiter.png");
-
-    Tri() {
+    unsigned int earthDiffuseMap, earthSpecularMap, sunTexture, moonTexture;
+    unsigned int mercury, mars, venus, uranus, neptune, saturn, saturnRing, jupiter;
+
+    // jobs (optional) decodes textures and builds the sphere in parallel, and is used for body updates / culling.
+    // format: how the sphere is stored on the GPU (derived: 12 bytes a vertex, normals from the position).
+    // segments: sphere segments around and top to bottom (bench_scene uses fewer for big scenes).
+    Tri(JobSystem *jobs = nullptr, VertexFormat format = VertexFormat::Derived, unsigned segments = 128) : jobs(jobs) {
+        PROFILE_ZONE("Tri");
+        std::vector<unsigned int> textures = loadTextures({
+            "asset/textures/earth.png",    // Replace with your Earth texture path
+            "asset/textures/earth_specular.png",
+            "asset/textures/sun.png",      // Or PNG
+            "asset/textures/moon.png",
+            "asset/textures/mercury.png",
+            "asset/textures/mars.png",
+            "asset/textures/venus.png",
+            "asset/textures/uranus.png",
+            "asset/textures/neptune.png",
+            "asset/textures/saturn.png",
+            "asset/textures/saturn_ring.png",
+            "asset/textures/jupiter.png"
+        }, jobs);
+        earthDiffuseMap = textures[0];
+        earthSpecularMap = textures[1];
+        sunTexture = textures[2];
+        moonTexture = textures[3];
+        mercury = textures[4];
+        mars = textures[5];
+        venus = textures[6];
+        uranus = textures[7];
+        neptune = textures[8];
+        saturn = textures[9];
+        saturnRing = textures[10];
+        jupiter = textures[11];
+
         std::vector<float> sphereVertices;
         std::vector<unsigned int> sphereIndices;
-        createSphere(sphereVertices, sphereIndices);
-        indexCount = sphereIndices.size();  // store count for sphere
-
-        // background 
-        float quadVertices[24] = {
-            // positions   // texCoords
-            // X     Y     U     V
-            -1.0,  1.0,  0.0, 1.0,  // Top-left
-            -1.0, -1.0,  0.0, 0.0,  // Bottom-left
-            1.0, -1.0,  1.0, 0.0,  // Bottom-right
-
-            -1.0,  1.0,  0.0, 1.0,  // Top-left
-            1.0, -1.0,  1.0, 0.0,  // Bottom-right
-            1.0,  1.0,  1.0, 1.0   // Top-right
-        };
+        createSphere(sphereVertices, sphereIndices, segments, segments, 1.0f, jobs);
+        MeshOptimizer::optimize(sphereVertices, 8, sphereIndices, "sphere"); // vertex cache, overdraw and fetch order
+        PackedMesh sphere = PackedMesh::pack(sphereVertices, sphereIndices, format, "sphere");
+        indexCount = sphere.indexCount;  // store count for sphere
+        indexType = sphere.indexType;
+        normalEncoding = sphere.normalEncoding();
+
+        setupMesh(VAO, VBO, EBO, sphere, lightVAO);
+
+        // star sky, made from space.png by make_skybox (or here, the first time)
+        skybox.create(loadSkyCubemap("asset/textures/space.cubemap", "asset/textures/space.png", jobs), "asset/textures/space.cubemap");
+
+        // give each body its texture
+        setTexture("Sun", sunTexture);
+        setTexture("Earth", earthDiffuseMap);
+        setTexture("Moon", moonTexture);
+        setTexture("Mercury", mercury);
+        setTexture("Venus", venus);
+        setTexture("Mars", mars);
+        setTexture("Jupiter", jupiter);
+        setTexture("Saturn", saturn);
+        setTexture("Saturn Ring", saturnRing);
+        setTexture("Uranus", uranus);
+        setTexture("Neptune", neptune);
+
+        // persistently mapped when the driver allows it, so the camera can be late-latched
+        cameraBuffer.create(true);
+        if (cameraBuffer.verifyLateLatch()) {
+            std::cout << "Late-latched camera available\n";
+        }
+
+        for (const Body &body : solar.bodies) bodyNames.push_back(body.name);
 
-        setupMesh(VAO, VBO, EBO, sphereVertices, sphereIndices, lightVAO, backgroundVAO, backgroundVBO, quadVertices, sizeof(quadVertices));
+        // 1M particles around the sun (its centre never moves, radius = sun size)
+        int sun = solar.findBody("Sun");
+        solar.update(0.0f);
+        particles = new ParticleSystem(1 << 20, solar.getPosition(solar.bodies[sun]), solar.bodies[sun].size.x);
 
+        postProcess.create();
     }
 
-void draw(Shader &light, Shader &shader, Shader &background, Camera &camera) { 
-    //background
-    background.use(); // use the simple shader you created
-    glBindVertexArray(backgroundVAO);
-    glDisable(GL_DEPTH_TEST); // background should not occlude anything
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, backgroundTexture);
-    background.setInt("background", 0);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glEnable(GL_DEPTH_TEST);
-
-    glm::vec3 lightPos(1.2f, 1.0f, 0.0f);
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = camera.GetProjectionMatrix(1200.0f / 800.0f);
-
-    float timeScale = 0.01f; // Slow down time for better visual (or else all planets rotate too fast to preview)
-    float sizeScale = 10.0f; // increase planet size for better visual
-    
-    // Sun
-    float ssize = 12.8f; // Sun size
-    light.use(); // light shader for sun
-    light.setMat4("view", view);
-    light.setMat4("projection", projection);
-    float angle = glfwGetTime() * 0.12f; 
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, lightPos);
-    model = glm::rotate(model, glm::radians(7.25f), glm::vec3(0.0f, 0.0f, 1.0f)); // Sun axial tilt
-    model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f)); // moves at axial tilt direction 
-    model = glm::scale(model, glm::vec3(ssize)); 
-    light.setMat4("model", model);  
-    // Bind sun texture & draw
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, sunTexture);
-    light.setInt("sunTexture", 0);
-    glBindVertexArray(lightVAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+    // Pick the body in the middle of the screen (the cursor is hidden, so the crosshair is the centre).
+    // Returns the body index or -1, and remembers it as the picked body.
+    int pick(Camera &camera) {
+        picked = bvh.pick(camera.Position, camera.GetRayDirection(0.0f, 0.0f, getAspect()));
+        return picked;
+    }
 
-    shader.use();  // Use the main shader for colored object (earth, moon, etc)
-    shader.setVec3("viewPos", camera.Position);
-    shader.setVec3("lightPos", lightPos);  // Make sure this matches your fragment shader
-    shader.setMat4("view", view);
-    shader.setMat4("projection", projection);
-    
-    // Bind Earth textures
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, earthDiffuseMap);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, earthSpecularMap);
-    
-    // Set texture uniforms
-    shader.setInt("material.diffuse", 0);
-    shader.setInt("material.specular", 1);
-    shader.setFloat("material.shininess", 32.0f);
-    
-    // Light properties 
-    shader.setVec3("light.ambient", 0.25f, 0.25f, 0.25f);   // Reduced ambient for more dramatic lighting
-    shader.setVec3("light.diffuse", 0.8f, 0.8f, 0.8f);   // Brighter diffuse
-    shader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-
-    // Earth
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 29.78f * timeScale; // how fast it moves around sun. 
-    glm::vec3 orbitCenter = lightPos; // move to Sun position
-    float x = (orbitCenter.x + ssize + 1.0f * sizeScale) * std::cos(angle); // x,y,z moves at sun's diameter position, then + 100f from the sun
-    float z = (orbitCenter.z + ssize + 1.0f * sizeScale) * std::sin(angle);
-    float y = (orbitCenter.y + 3.5f) * std::sin(angle);
-    glm::vec3 earthPos = glm::vec3(x, y, z);
-    model = glm::translate(model, earthPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(23.5f), glm::vec3(0.0f, 0.0f, 1.0f)); // Tilt like Earth's axis (23.5 degree) at Z-tilt
-    model = glm::rotate(model, angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(0.75f));
-    shader.setMat4("model", model);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-
-    // Moon
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 1.022f; // moves slightly faster than earth 
-    orbitCenter = earthPos; // move to Earth postiion
-    float mx = orbitCenter.x + 1.2f * std::cos(-angle);  // Negative sign for opposite direction
-    float mz = orbitCenter.z + 1.2f * std::sin(-angle);
-    float my = orbitCenter.y + 0.75f * std::sin(glfwGetTime() * 0.5f);
-    glm::vec3 moonPos = glm::vec3(mx, my, mz);
-    model = glm::translate(model, moonPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(5.1f), glm::vec3(0.0f, 0.0f, 1.0f)); // Moon's axial tilt
-    model = glm::rotate(model, angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f)); // Moon's rotation
-    model = glm::scale(model, glm::vec3(0.204f)); // one-quarter the diameter of Earth
-    shader.setMat4("model", model);
-    // bind moon texture & draw
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, moonTexture);
-    shader.setInt("moonTexture", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-
-    // Mercury 
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 122.8f * timeScale; // nearest to sun = fastest rotation
-    orbitCenter = lightPos; // move to Earth postiion
-    float mex = (orbitCenter.x + ssize + 0.39f * sizeScale) * std::cos(angle);
-    float mez = (orbitCenter.z + ssize + 0.39f * sizeScale) * std::sin(angle);
-    float mey = (orbitCenter.y + 2.5f) * std::sin(angle);
-    glm::vec3 merPos = glm::vec3(mex, mey, mez);
-    model = glm::translate(model, merPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(0.034f), glm::vec3(0.0f, 0.0f, 1.0f)); // Mercury axial tilt
-    model = glm::rotate(model, angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f)); 
-    model = glm::scale(model, glm::vec3(0.287f)); 
-    shader.setMat4("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mercury);
-    shader.setInt("mercury", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-    
-    // Venus
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 48.6f * timeScale; 
-    orbitCenter = lightPos; // move to Earth postiion
-    float vx = (orbitCenter.x + ssize + 0.72f * sizeScale) * std::cos(angle);
-    float vz = (orbitCenter.z + ssize + 0.72f * sizeScale) * std::sin(angle);
-    float vy = (orbitCenter.y + 2.5f) * std::sin(angle);
-    glm::vec3 vPos = glm::vec3(vx, vy, vz);
-    model = glm::translate(model, vPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(177.4f), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::rotate(model, -angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f)); // clockwise direction
-    model = glm::scale(model, glm::vec3(0.712f)); 
-    shader.setMat4("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, venus);
-    shader.setInt("venus", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-    
-    // Mars 
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 15.8f * timeScale; 
-    orbitCenter = lightPos; // move to Earth postiion
-    float mrx = (orbitCenter.x + ssize + 1.52f * sizeScale) * std::cos(angle);
-    float mrz = (orbitCenter.z + ssize + 1.52f * sizeScale) * std::sin(angle);
-    float mry = (orbitCenter.y + 2.5f) * std::sin(angle);
-    glm::vec3 mrPos = glm::vec3(mrx, mry, mrz);
-    model = glm::translate(model, mrPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(25.2f), glm::vec3(0.0f, 0.0f, 1.0f)); 
-    model = glm::rotate(model, angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(0.398f)); 
-    shader.setMat4("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mars);
-    shader.setInt("mars", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-
-    // Jupiter 
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 2.51f * timeScale; 
-    orbitCenter = lightPos; // move to Earth postiion
-    float jx = (orbitCenter.x + 5.20f * sizeScale) * std::cos(angle);
-    float jz = (orbitCenter.z + 5.20f * sizeScale) * std::sin(angle);
-    float jy = (orbitCenter.y + 2.5f) * std::sin(angle);
-    glm::vec3 jPos = glm::vec3(jx, jy, jz);
-    model = glm::translate(model, jPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(3.13f), glm::vec3(0.0f, 0.0f, 1.0f)); 
-    model = glm::rotate(model, angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(8.210f)); 
-    shader.setMat4("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, jupiter);
-    shader.setInt("jupiter", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-
-    // Saturn 
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 1.01f * timeScale; 
-    orbitCenter = lightPos; // move to Earth postiion
-    float sx = (orbitCenter.x + 9.58f * sizeScale) * std::cos(angle);
-    float sz = (orbitCenter.z + 9.58f * sizeScale) * std::sin(angle);
-    float sy = (orbitCenter.y + 2.5f) * std::sin(angle);
-    glm::vec3 sPos = glm::vec3(sx, sy, sz);
-    model = glm::translate(model, sPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(26.7f), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::rotate(model, angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(6.844f)); 
-    shader.setMat4("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, saturn);
-    shader.setInt("saturn", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-
-    glm::mat4 ringModel = glm::mat4(1.0f); // Saturn ring 
-    ringModel = glm::translate(ringModel, sPos);  // Position the rings at Saturn's location
-    ringModel = glm::rotate(ringModel, glm::radians(26.7f), glm::vec3(0.0f, 0.0f, 1.0f)); // Align with Saturn's tilt
-    ringModel = glm::rotate(ringModel, angle * 4.7f, glm::vec3(0.0f, 1.0f, 0.0f));  // Rotate rings around the Y axis (same as Saturn)
-    ringModel = glm::scale(ringModel, glm::vec3(10.0f, 1.0f, 10.0f)); 
-    shader.setMat4("model", ringModel); 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, saturnRing); 
-    shader.setInt("saturnRing", 0);
-    glBindVertexArray(VAO); // Ensure you have a separate VAO for the rings
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-
-    // Uranus 
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 0.355f * timeScale; 
-    orbitCenter = lightPos; // move to Earth postiion
-    float ux = (orbitCenter.x + 19.18f * sizeScale) * std::cos(angle);
-    float uz = (orbitCenter.z + 19.18f * sizeScale) * std::sin(angle);
-    float uy = (orbitCenter.y + 2.5f) * std::sin(angle);
-    glm::vec3 uPos = glm::vec3(ux, uy, uz);
-    model = glm::translate(model, uPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(97.77f), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::rotate(model, -angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(2.986f)); 
-    shader.setMat4("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, uranus);
-    shader.setInt("uranus", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
-
-    // Neptune scaled to 2.901f
-    model = glm::scale(model, glm::vec3());
-    model = glm::mat4(1.0f); 
-    angle = glfwGetTime() * 0.181f * timeScale; 
-    orbitCenter = lightPos; // move to Earth postiion
-    float nx = (orbitCenter.x + 30.07f * sizeScale) * std::cos(angle);
-    float nz = (orbitCenter.z + 30.07f * sizeScale) * std::sin(angle);
-    float ny = (orbitCenter.y + 2.5f) * std::sin(angle);
-    glm::vec3 nPos = glm::vec3(nx, ny, nz);
-    model = glm::translate(model, nPos); // move at circumference of radius 
-    model = glm::rotate(model, glm::radians(28.3f), glm::vec3(0.0f, 0.0f, 1.0f)); 
-    model = glm::rotate(model, angle * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(2.901f)); 
-    shader.setMat4("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, neptune);
-    shader.setInt("neptune", 0);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+    int getPicked() const { return picked; }
+
+    // Late latch: overwrite this frame's camera block with `camera` after draw() (returns false if unsupported)
+    bool latchCamera(Camera &camera) {
+        return latchCamera(cameraBlock(camera));
+    }
+
+    bool latchCamera(const CameraBlock &block) {
+        return cameraBuffer.latch(block);
+    }
+
+    bool supportsLateLatch() const { return cameraBuffer.isLateLatch(); }
+
+    CameraBlock cameraBlock(Camera &camera) const {
+        CameraBlock block;
+        block.view = camera.GetViewMatrix();
+        block.projection = camera.GetProjectionMatrix(getAspect());
+        block.viewPos = glm::vec4(camera.Position, 1.0f);
+        return block;
+    }
+    const SolarSystem &getSolar() const { return solar; }
+
+    // Adds `count` asteroids between Mars and Jupiter (SolarSystem::addAsteroidBelt), drawn with the moon's texture.
+    // Call it before the first buildPacket().
+    void addAsteroidBelt(size_t count, uint32_t seed = 1234u) {
+        int first = solar.addAsteroidBelt(count, seed);
+        for (size_t i = static_cast<size_t>(first); i < solar.bodies.size(); ++i) solar.bodies[i].texture = moonTexture;
+    }
+
+    // Window framebuffer size (aspect ratio of the projection, viewport, particle size), e.g. after a resize
+    void setViewport(int width, int height) {
+        if (width <= 0 || height <= 0) return; // minimised
+        viewportWidth = width;
+        viewportHeight = height;
+    }
+
+    float getAspect() const { return static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight); }
+
+    // Dynamic resolution: keep the GPU frame time under budgetMs by drawing the scene at a lower resolution
+    // and stretching it onto the window. Only call it from the thread that renders.
+    void setDynamicResolution(bool on, float budgetMs) {
+        resolution.setEnabled(on);
+        resolution.setBudget(budgetMs);
+    }
+
+    const DynamicResolution &getResolution() const { return resolution; }
+
+    // Bloom: bright parts of the scene glow. Only call it from the thread that renders.
+    void setBloom(bool on) { bloom = on; }
+    bool getBloom() const { return bloom; }
+
+    // Star sky: fragments it shaded (read back a few frames late), and the old order to compare with.
+    // Only call it from the thread that renders.
+    const Skybox &getSkybox() const { return skybox; }
+    void setSkyFirst(bool on) { skybox.setFirst(on); }
+
+    // Occlusion culling on top of frustum culling. Only call it from the thread that builds the packets.
+    void setOcclusionCulling(bool on) { occlusion.setEnabled(on); }
+    bool getOcclusionCulling() const { return occlusion.isEnabled(); }
+
+    // Render target memory and pass statistics; aliasing can be turned off to compare
+    FrameGraph &getFrameGraph() { return graph; }
+    const FrameGraph &getFrameGraph() const { return graph; }
+
+    // Draw calls, triangles and culled bodies of the last render() (state changes come from GlTrace, see framestats.h)
+    const RenderCounters &getCounters() const { return counters; }
+
+    // GPU memory of the body and sky textures, and of the particle buffers. Only call it from the thread that renders.
+    size_t getTextureBytes() const {
+        size_t bytes = textureBytes(skybox.getTexture(), GL_TEXTURE_CUBE_MAP);
+        for (unsigned int texture : {earthDiffuseMap, earthSpecularMap, sunTexture, moonTexture, mercury, mars, venus,
+                                     uranus, neptune, saturn, saturnRing, jupiter}) {
+            bytes += textureBytes(texture);
+        }
+        return bytes;
+    }
+    size_t getParticleBytes() const { return particles->getBufferBytes(); }
+
+    // Per-pass GPU times. Only read it from the thread that renders (or after the render thread stopped).
+    const GpuProfiler &getProfiler() const { return profiler; }
+
+    void setTexture(const std::string &name, unsigned int texture) {
+        int index = solar.findBody(name);
+        if (index >= 0) solar.bodies[index].texture = texture;
+    }
+
+    // Single-threaded frame: simulate and draw right away
+    void draw(Shader &light, Shader &shader, Camera &camera) {
+        buildPacket(camera, glfwGetTime(), packet);
+        render(light, shader, packet);
+    }
+
+    // Simulation half of a frame (no GL calls, can run on a different thread than render()):
+    // moves the bodies to `time`, culls them against the camera and copies what has to be drawn into `out`.
+    // out.frame and out.inputTime are left to the caller.
+    void buildPacket(Camera &camera, double time, FramePacket &out) {
+        PROFILE_ZONE("buildPacket");
+        {
+            // move planets, moon and ring (only dirty nodes get their world matrix rebuilt)
+            PROFILE_ZONE("update bodies");
+            solar.update(static_cast<float>(time), jobs);
+        }
+        {
+            PROFILE_ZONE("refit BVH");
+            bvh.refit(solar, jobs);
+        }
+
+        out.time = time;
+        out.camera = cameraBlock(camera);
+        out.fov = camera.Fov;
+        out.viewportWidth = viewportWidth;
+        out.viewportHeight = viewportHeight;
+        out.lightPos = solar.lightPos;
+
+        // skip bodies that are off screen, then the ones hidden behind the sun or a planet
+        PROFILE_ZONE("cull and copy");
+        solar.cull(Frustum(out.camera.projection * out.camera.view), visible, jobs);
+        out.frustumCulled = static_cast<unsigned int>(solar.bodies.size() - visible.size());
+        out.occlusionCulled = static_cast<unsigned int>(occlusion.cull(solar, out.camera, visible, jobs));
+        out.occluders = occlusion.getOccluderCount();
+        out.suns.clear();
+        out.bodies.clear();
+        for (int index : visible) {
+            const Body &body = solar.bodies[index];
+            DrawItem item;
+            item.model = solar.getModel(body);
+            item.texture = body.texture;
+            item.body = index;
+            (body.emissive ? out.suns : out.bodies).push_back(item);
+        }
+    }
+
+    // GL half of a frame: only reads the packet, so the next one can be built meanwhile.
+    // Draws into the framebuffer bound when it is called (the window's, or an offscreen one).
+    // The passes go through the frame graph, which orders them, skips what doesn't reach the window and
+    // binds the framebuffer each one draws into.
+    void render(Shader &light, Shader &shader, const FramePacket &frame) {
+        PROFILE_ZONE("render");
+        const uint64_t sphereTriangles = indexCount / 3;
+        counters = RenderCounters();
+        counters.frustumCulled = frame.frustumCulled;
+        counters.occlusionCulled = frame.occlusionCulled;
+        profiler.beginFrame();
+        profiler.push("frame");
+
+        GLint output = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output);
+        graph.reset();
+        FrameGraph::Resource window = graph.importFramebuffer("window", static_cast<GLuint>(output), frame.viewportWidth, frame.viewportHeight);
+        FrameGraph::Resource windowDepth = graph.importFramebuffer("window depth", static_cast<GLuint>(output), frame.viewportWidth, frame.viewportHeight);
+        FrameGraph::Resource particlePool = graph.importResource("particle pool");
+
+        // With dynamic resolution (at the current scale) or bloom the scene goes to offscreen textures first
+        bool offscreen = resolution.isEnabled() || bloom;
+        FrameGraph::Resource colour = window, depth = windowDepth;
+        if (offscreen) {
+            FrameGraph::TextureDesc scene;
+            scene.width = resolution.scaledSize(frame.viewportWidth);
+            scene.height = resolution.scaledSize(frame.viewportHeight);
+            colour = graph.createTexture("scene colour", scene);
+            scene.format = GL_DEPTH24_STENCIL8;
+            depth = graph.createTexture("scene depth", scene);
+        }
+        int sceneHeight = graph.getHeight(colour);
+
+        // the first pass clears the offscreen targets (the window is cleared by the caller)
+        auto clearScene = [&] {
+            if (!offscreen) return;
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        };
+
+        // The sky is drawn after the sun and planets, at the far plane: covered pixels are never shaded.
+        // (setSkyFirst: before them without a depth test instead, shading every pixel, to compare.)
+        auto skyPass = [&] {
+            PROFILE_ZONE("sky");
+            if (skybox.isFirst()) clearScene();
+            if (!skybox.draw()) return;
+            counters.drawCalls += 1;
+            counters.triangles += 1;
+        };
+        if (skybox.isFirst()) {
+            FrameGraph::PassBuilder firstSkyPass = graph.addPass("sky", skyPass);
+            colour = firstSkyPass.write(colour);
+            depth = firstSkyPass.write(depth); // cleared there
+        }
+
+        FrameGraph::PassBuilder sunPass = graph.addPass("sun", [&] {
+            PROFILE_ZONE("sun");
+            if (!skybox.isFirst()) clearScene();
+            light.use(); // light shader for sun
+            light.setInt("sunTexture", 0);
+            glBindVertexArray(lightVAO);
+            for (const DrawItem &item : frame.suns) {
+                light.setMat4("model", item.model);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, item.texture);
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), indexType, 0);
+            }
+            counters.drawCalls += static_cast<unsigned int>(frame.suns.size());
+            counters.triangles += sphereTriangles * frame.suns.size();
+        });
+        colour = sunPass.write(colour);
+        depth = sunPass.write(depth);
+
+        FrameGraph::PassBuilder planetsPass = graph.addPass("planets", [&] {
+            PROFILE_ZONE("planets");
+            shader.use();  // Use the main shader for colored object (earth, moon, etc)
+            shader.setVec3("lightPos", frame.lightPos);  // Make sure this matches your fragment shader
+            shader.setInt("normalEncoding", normalEncoding);
+
+            // Earth's specular map is shared by every planet
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, earthSpecularMap);
+
+            // Set texture uniforms
+            shader.setInt("material.diffuse", 0);
+            shader.setInt("material.specular", 1);
+            shader.setFloat("material.shininess", 32.0f);
+
+            // Light properties
+            shader.setVec3("light.ambient", 0.25f, 0.25f, 0.25f);   // Reduced ambient for more dramatic lighting
+            shader.setVec3("light.diffuse", 0.8f, 0.8f, 0.8f);   // Brighter diffuse
+            shader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
+
+            // Planets, moon and Saturn's ring
+            glBindVertexArray(VAO);
+            for (const DrawItem &item : frame.bodies) {
+                // the named bodies get their own GPU timer, an asteroid belt is too many to time one by one
+                bool timed = item.body >= 0 && static_cast<size_t>(item.body) < bodyNames.size();
+                if (timed) profiler.push(bodyNames[item.body]);
+                shader.setMat4("model", item.model);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, item.texture);
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), indexType, 0);
+                if (timed) profiler.pop();
+            }
+            counters.drawCalls += static_cast<unsigned int>(frame.bodies.size());
+            counters.triangles += sphereTriangles * frame.bodies.size();
+        });
+        colour = planetsPass.write(colour);
+        depth = planetsPass.write(depth);
+
+        if (!skybox.isFirst()) {
+            FrameGraph::PassBuilder lastSkyPass = graph.addPass("sky", skyPass);
+            lastSkyPass.readAttachment(depth); // depth tested against the bodies, never written
+            colour = lastSkyPass.write(colour);
+        }
+
+        // Corona and solar wind: update on the GPU, then draw on top of the planets (additive, no depth writes).
+        // The time step comes from the packets, so skipped packets do not slow the particles down.
+        float deltaTime = lastFrame < 0.0 ? 0.0f : static_cast<float>(frame.time - lastFrame);
+        lastFrame = frame.time;
+        FrameGraph::PassBuilder updatePass = graph.addPass("particles update", [&] {
+            PROFILE_ZONE("particles update");
+            particles->step(deltaTime);
+            counters.drawCalls += 1; // dispatch or transform feedback
+        });
+        particlePool = updatePass.write(particlePool);
+
+        FrameGraph::PassBuilder particlesPass = graph.addPass("particles draw", [&] {
+            PROFILE_ZONE("particles draw");
+            particles->draw(static_cast<float>(sceneHeight), glm::radians(frame.fov));
+            counters.drawCalls += 1; // point draw
+        });
+        particlesPass.read(particlePool);
+        particlesPass.readAttachment(depth); // depth tested against the planets, never written
+        colour = particlesPass.write(colour);
+
+        if (bloom) {
+            // bright parts at half resolution, blurred both ways, added back onto the scene
+            FrameGraph::TextureDesc half;
+            half.width = std::max(1, graph.getWidth(colour) / 2);
+            half.height = std::max(1, sceneHeight / 2);
+            FrameGraph::Resource bright = graph.createTexture("bloom bright", half);
+            FrameGraph::Resource blurred = graph.createTexture("bloom blur", half);
+            FrameGraph::Resource glow = graph.createTexture("bloom", half);
+
+            FrameGraph::Resource scene = colour;
+            FrameGraph::PassBuilder brightPass = graph.addPass("bloom bright", [&, scene] {
+                PROFILE_ZONE("bloom bright");
+                postProcess.bright(graph.getTexture(scene), graph.getUsedScale(scene), graph.getTexelSize(scene), 0.8f);
+            });
+            brightPass.read(colour);
+            bright = brightPass.write(bright);
+
+            FrameGraph::PassBuilder blurX = graph.addPass("bloom blur x", [&, bright] {
+                PROFILE_ZONE("bloom blur");
+                postProcess.blur(graph.getTexture(bright), graph.getUsedScale(bright), graph.getTexelSize(bright), glm::vec2(1.0f, 0.0f));
+            });
+            blurX.read(bright);
+            blurred = blurX.write(blurred);
+
+            FrameGraph::PassBuilder blurY = graph.addPass("bloom blur y", [&, blurred] {
+                PROFILE_ZONE("bloom blur");
+                postProcess.blur(graph.getTexture(blurred), graph.getUsedScale(blurred), graph.getTexelSize(blurred), glm::vec2(0.0f, 1.0f));
+            });
+            blurY.read(blurred);
+            glow = blurY.write(glow);
+
+            FrameGraph::PassBuilder compositePass = graph.addPass("bloom composite", [&, glow] {
+                PROFILE_ZONE("bloom composite");
+                postProcess.composite(graph.getTexture(glow), graph.getUsedScale(glow), graph.getTexelSize(glow), 1.0f);
+            });
+            compositePass.read(glow);
+            colour = compositePass.write(colour);
+            counters.drawCalls += 4;
+            counters.triangles += 4;
+        }
+
+        if (offscreen) {
+            // stretch the scene over the whole window
+            FrameGraph::Resource scene = colour;
+            FrameGraph::PassBuilder upscalePass = graph.addPass("upscale", [&, scene] {
+                PROFILE_ZONE("upscale");
+                postProcess.upscale(graph.getTexture(scene), graph.getUsedScale(scene), graph.getTexelSize(scene), resolution.getSharpness());
+            });
+            upscalePass.read(colour);
+            window = upscalePass.write(window);
+            counters.drawCalls += 1;
+            counters.triangles += 1;
+        } else {
+            window = colour;
+        }
+        graph.markOutput(window);
+        graph.compile();
+
+        // camera matrices go to the shaders through the Camera uniform block
+        cameraBuffer.begin(frame.camera);
+        graph.execute(&profiler);
+        cameraBuffer.end(); // last draw that reads the camera
+
+        profiler.pop(); // frame
+        profiler.endFrame();
+        resolution.update(profiler.getLastMs("frame"));
+
+        // GPU time of each pass (read back a few frames late), once every few seconds
+        if (frame.time - reportTime > 5.0) {
+            reportTime = frame.time;
+            profiler.printSummary(1);
+            if (resolution.isEnabled()) {
+                std::cout << "Resolution " << static_cast<int>(resolution.getScale() * 100.0f + 0.5f) << "% ("
+                          << resolution.scaledSize(frame.viewportWidth) << "x" << resolution.scaledSize(frame.viewportHeight)
+                          << ", budget " << resolution.getBudget() << " ms), " << resolution.getChanges() << " changes\n";
+            }
+            graph.printSummary();
+            std::cout << "Culled: " << frame.frustumCulled << " off screen, " << frame.occlusionCulled << " hidden behind "
+                      << frame.occluders << " occluders\n";
+            if (skybox.isLoaded()) {
+                std::cout << "Sky: " << skybox.getLast().samples << " pixels drawn";
+                if (skybox.hasInvocationCount()) std::cout << ", " << skybox.getLast().invocations << " fragment shader invocations";
+                std::cout << "\n";
+            }
+        }
+    }
 
-}
-    
     void del() {  // cal this by object.del();
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
         glDeleteVertexArrays(1, &lightVAO);
         glDeleteVertexArrays(1, &moonVAO);
-        glDeleteTextures(1, &earthDiffuseMap);
-        glDeleteTextures(1, &earthSpecularMap); 
-        glDeleteVertexArrays(1, &backgroundVAO);
-        glDeleteBuffers(1, &backgroundVBO);
-        glDeleteTextures(1, &backgroundTexture);
+        unsigned int textures[] = {earthDiffuseMap, earthSpecularMap, sunTexture, moonTexture, mercury, mars, venus,
+                                   uranus, neptune, saturn, saturnRing, jupiter};
+        glDeleteTextures(12, textures); // every texture the constructor loaded (bench_scene makes a Tri per run)
+        skybox.del();
+        particles->del();
+        cameraBuffer.del();
+        profiler.del();
+        graph.del();
+        postProcess.del();
+        delete particles;
+        particles = nullptr;
     }
 };
  
-void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
-               const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
-               unsigned int &lightVAO, unsigned int &backgroundVAO, unsigned int &backgroundVBO,  const float* quadVertices, size_t quadSizeBytes) {
+void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO, const PackedMesh &mesh,
+               unsigned int &lightVAO) {
+    PROFILE_ZONE("setupMesh");
         // Generate buffers
     glGenVertexArrays(1, &VAO); 
     glGenBuffers(1, &VBO);
@@ -410,25 +749,16 @@ void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
 
     glBindVertexArray(VAO);  
 
-    // Upload vertex data
+    // Upload vertex data (already in the mesh's vertex format)
     glBindBuffer(GL_ARRAY_BUFFER, VBO); 
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size(), mesh.vertices.data(), GL_STATIC_DRAW);
 
-    // Upload index data
+    // Upload index data (16 or 32 bits, mesh.indexType)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO); 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size(), mesh.indices.data(), GL_STATIC_DRAW);
 
-    // Position attribute (location = 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    // Normal attribute (location = 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    
-    // Texture coordinate attribute (location = 2)
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // Position (location = 0), normal (location = 1), texture coordinates (location = 2)
+    mesh.setAttributes(0, 1, 2);
 
     // Setup light VAO using same VBO and EBO
     glGenVertexArrays(1, &lightVAO);
@@ -436,24 +766,8 @@ void setupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0); // sun vertices
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(1); // sun texture
-
-    // Set up background
-    glGenVertexArrays(1, &backgroundVAO);
-    glGenBuffers(1, &backgroundVBO);
-    glBindVertexArray(backgroundVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, backgroundVBO);
-    glBufferData(GL_ARRAY_BUFFER, quadSizeBytes, quadVertices, GL_STATIC_DRAW);
+    mesh.setAttributes(0, -1, 1); // sun vertices and texture, no normal
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
     // Cleanup
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
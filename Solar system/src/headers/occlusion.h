@@ -0,0 +1,235 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "solar.h"
+#include "jobs.h"
+#include "camerabuffer.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+// Occlusion culling: skips bodies hidden behind the big spheres (sun, planets) before they are submitted.
+//
+// 1. Occluders: the frustum-visible bodies that look big on screen (uniformly scaled, so not the ring) are
+//    rasterized on the CPU into a small buffer (WIDTH x HEIGHT texels over the whole screen). A texel is only
+//    covered when all 4 of its corners see the sphere, and it stores the distance from the camera to the sphere's
+//    centre: every point of the sphere the camera can see is closer than that, so the buffer never claims more
+//    than the sphere really hides.
+// 2. Hi-Z pyramid: each level halves the buffer, keeping the farthest distance of the 4 texels below.
+// 3. Test: a body's bounding sphere is projected to a texel rectangle, the level where that rectangle is about
+//    2x2 texels is read, and the body is hidden if its nearest point is farther than everything stored there.
+//
+// The buffer is built from this frame's positions and camera, so nothing has to be reprojected from an older
+// frame. The camera may still move a little after culling (late latch), so the tested rectangle is grown by
+// `margin` texels on every side: a body is only culled when it stays hidden from slightly around that view too.
+//
+// Usage (after the frustum cull):
+//   int hidden = occlusion.cull(solar, camera, visible, jobs); // removes hidden bodies, keeps the order
+class OcclusionCuller {
+public:
+    static const int WIDTH = 128, HEIGHT = 64; // level 0; powers of two so every level halves exactly
+    static const int MAX_OCCLUDERS = 32;       // the biggest ones on screen
+    static constexpr float MIN_OCCLUDER_TEXELS = 2.0f; // projected radius below this can't cover a texel
+
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+
+    // Extra texels around each tested body (absorbs camera movement between culling and drawing)
+    void setMargin(int texels) { margin = std::max(0, texels); }
+    int getMargin() const { return margin; }
+
+    // Removes the bodies hidden behind occluders from `visible` (body indices, as left by SolarSystem::cull).
+    // Returns how many were removed.
+    int cull(const SolarSystem &solar, const CameraBlock &camera, std::vector<int> &visible, JobSystem *jobs = nullptr) {
+        occluders = 0;
+        if (!enabled || visible.empty()) return 0;
+        setProjection(camera.projection);
+        if (!buildOccluders(solar, camera.view, visible)) return 0; // nothing big on screen
+        buildPyramid();
+
+        // test in parallel into a flag per visible body, then compact in order on this thread
+        hiddenFlags.resize(visible.size());
+        auto test = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Body &body = solar.bodies[visible[i]];
+                glm::vec3 centre = glm::vec3(camera.view * glm::vec4(solar.getPosition(body), 1.0f));
+                hiddenFlags[i] = isHidden(centre, solar.getRadius(body)) ? 1 : 0;
+            }
+        };
+        if (jobs) jobs->parallelFor(visible.size(), test);
+        else test(0, visible.size());
+
+        size_t kept = 0;
+        for (size_t i = 0; i < visible.size(); ++i) {
+            if (!hiddenFlags[i]) visible[kept++] = visible[i];
+        }
+        int hidden = static_cast<int>(visible.size() - kept);
+        visible.resize(kept);
+        return hidden;
+    }
+
+    int getOccluderCount() const { return occluders; } // spheres drawn into the buffer by the last cull()
+
+    // Level 0 (WIDTH x HEIGHT, row 0 at the bottom of the screen), FLT_MAX where nothing is covered
+    const std::vector<float> &getDepth() const { return levels[0]; }
+
+private:
+    bool enabled = true;
+    int margin = 1;
+    int occluders = 0;
+    glm::mat4 projection = glm::mat4(0.0f);
+    float nearPlane = 0.1f;
+    std::vector<glm::vec3> cornerRays;  // (WIDTH + 1) x (HEIGHT + 1) unit view space directions through texel corners
+    std::vector<std::vector<float>> levels; // Hi-Z pyramid, levels[0] = full size
+    std::vector<int> levelWidth, levelHeight;
+    std::vector<unsigned char> inside;  // scratch: corners inside the occluder being drawn
+    std::vector<unsigned char> hiddenFlags;
+    struct Occluder {
+        int body;
+        float texels; // projected radius
+    };
+    std::vector<Occluder> candidates;
+
+    // Corner rays only change with the projection (aspect ratio, field of view)
+    void setProjection(const glm::mat4 &newProjection) {
+        if (newProjection == projection && !cornerRays.empty()) return;
+        projection = newProjection;
+        nearPlane = projection[3][2] / (projection[2][2] - 1.0f); // glm::perspective's near plane
+
+        cornerRays.resize((WIDTH + 1) * (HEIGHT + 1));
+        for (int y = 0; y <= HEIGHT; ++y) {
+            for (int x = 0; x <= WIDTH; ++x) {
+                float ndcX = -1.0f + 2.0f * x / WIDTH, ndcY = -1.0f + 2.0f * y / HEIGHT;
+                cornerRays[y * (WIDTH + 1) + x] = glm::normalize(glm::vec3(ndcX / projection[0][0], ndcY / projection[1][1], -1.0f));
+            }
+        }
+
+        levels.clear();
+        levelWidth.clear();
+        levelHeight.clear();
+        for (int w = WIDTH, h = HEIGHT; ; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+            levels.emplace_back(w * h);
+            levelWidth.push_back(w);
+            levelHeight.push_back(h);
+            if (w == 1 && h == 1) break;
+        }
+    }
+
+    // Texel rectangle covered by a view space sphere, false if it reaches the near plane (no sensible rectangle)
+    bool screenRect(const glm::vec3 &centre, float radius, int &x0, int &y0, int &x1, int &y1) const {
+        if (centre.z + radius > -nearPlane) return false;
+        float minX = 1e9f, minY = 1e9f, maxX = -1e9f, maxY = -1e9f;
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 p = centre + radius * glm::vec3(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+            float x = projection[0][0] * p.x / -p.z, y = projection[1][1] * p.y / -p.z;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+        x0 = std::max(0, static_cast<int>(std::floor((minX + 1.0f) * 0.5f * WIDTH)));
+        y0 = std::max(0, static_cast<int>(std::floor((minY + 1.0f) * 0.5f * HEIGHT)));
+        x1 = std::min(WIDTH - 1, static_cast<int>(std::floor((maxX + 1.0f) * 0.5f * WIDTH)));
+        y1 = std::min(HEIGHT - 1, static_cast<int>(std::floor((maxY + 1.0f) * 0.5f * HEIGHT)));
+        return true;
+    }
+
+    bool buildOccluders(const SolarSystem &solar, const glm::mat4 &view, const std::vector<int> &visible) {
+        // the biggest uniformly scaled bodies on screen (a flattened body like the ring hides almost nothing)
+        candidates.clear();
+        for (int index : visible) {
+            const Body &body = solar.bodies[index];
+            if (body.size.x != body.size.y || body.size.y != body.size.z) continue;
+            glm::vec3 centre = glm::vec3(view * glm::vec4(solar.getPosition(body), 1.0f));
+            float distance = glm::length(centre);
+            float radius = solar.getRadius(body);
+            if (distance <= radius * 1.01f) continue; // camera inside (or touching) it
+            float texels = radius / distance * projection[1][1] * 0.5f * HEIGHT;
+            if (texels >= MIN_OCCLUDER_TEXELS) candidates.push_back({index, texels});
+        }
+        if (candidates.empty()) return false;
+        if (candidates.size() > static_cast<size_t>(MAX_OCCLUDERS)) {
+            std::nth_element(candidates.begin(), candidates.begin() + MAX_OCCLUDERS, candidates.end(),
+                             [](const Occluder &a, const Occluder &b) { return a.texels > b.texels; });
+            candidates.resize(MAX_OCCLUDERS);
+        }
+
+        std::vector<float> &depth = levels[0];
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+        for (const Occluder &occluder : candidates) {
+            const Body &body = solar.bodies[occluder.body];
+            glm::vec3 centre = glm::vec3(view * glm::vec4(solar.getPosition(body), 1.0f));
+            float distance = glm::length(centre);
+            float radius = solar.getRadius(body);
+            glm::vec3 axis = centre / distance;
+            float cosAngle = std::sqrt(1.0f - (radius / distance) * (radius / distance)); // edge of the sphere's cone
+
+            int x0 = 0, y0 = 0, x1 = WIDTH - 1, y1 = HEIGHT - 1; // crosses the near plane: try every texel
+            screenRect(centre, radius, x0, y0, x1, y1);
+            if (x0 > x1 || y0 > y1) continue;
+
+            // corners first (shared by up to 4 texels), then the texels with all 4 corners inside
+            int cornersX = x1 - x0 + 2;
+            inside.resize(cornersX * (y1 - y0 + 2));
+            for (int y = y0; y <= y1 + 1; ++y) {
+                for (int x = x0; x <= x1 + 1; ++x) {
+                    inside[(y - y0) * cornersX + (x - x0)] = glm::dot(cornerRays[y * (WIDTH + 1) + x], axis) > cosAngle;
+                }
+            }
+            for (int y = y0; y <= y1; ++y) {
+                const unsigned char *below = &inside[(y - y0) * cornersX], *above = below + cornersX;
+                for (int x = x0; x <= x1; ++x) {
+                    int i = x - x0;
+                    if (below[i] && below[i + 1] && above[i] && above[i + 1]) {
+                        float &texel = depth[y * WIDTH + x];
+                        texel = std::min(texel, distance);
+                    }
+                }
+            }
+            ++occluders;
+        }
+        return occluders > 0;
+    }
+
+    void buildPyramid() {
+        for (size_t level = 1; level < levels.size(); ++level) {
+            const std::vector<float> &below = levels[level - 1];
+            std::vector<float> &above = levels[level];
+            int belowWidth = levelWidth[level - 1], belowHeight = levelHeight[level - 1];
+            for (int y = 0; y < levelHeight[level]; ++y) {
+                for (int x = 0; x < levelWidth[level]; ++x) {
+                    int bx = std::min(x * 2 + 1, belowWidth - 1), by = std::min(y * 2 + 1, belowHeight - 1);
+                    above[y * levelWidth[level] + x] = std::max(std::max(below[y * 2 * belowWidth + x * 2], below[y * 2 * belowWidth + bx]),
+                                                                std::max(below[by * belowWidth + x * 2], below[by * belowWidth + bx]));
+                }
+            }
+        }
+    }
+
+    bool isHidden(const glm::vec3 &centre, float radius) const {
+        float nearest = glm::length(centre) - radius;
+        int x0, y0, x1, y1;
+        if (nearest <= 0.0f || !screenRect(centre, radius, x0, y0, x1, y1)) return false;
+        x0 -= margin;
+        y0 -= margin;
+        x1 += margin;
+        y1 += margin;
+        if (x0 < 0 || y0 < 0 || x1 >= WIDTH || y1 >= HEIGHT) return false; // reaches past the screen edge: nothing known there
+
+        // coarsest level where the rectangle still spans at most 2x2 texels
+        size_t level = 0;
+        while (level + 1 < levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) ++level;
+        const std::vector<float> &depth = levels[level];
+        int width = levelWidth[level];
+        for (int y = y0 >> level; y <= y1 >> level; ++y) {
+            for (int x = x0 >> level; x <= x1 >> level; ++x) {
+                if (depth[y * width + x] >= nearest) return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif
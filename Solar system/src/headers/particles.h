@@ -0,0 +1,204 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include "camerabuffer.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// GPU particle system for the sun's corona and the solar wind.
+// Particles live in two GPU buffers that swap roles every frame (ping-pong): one is read, the other written.
+// Emission, movement and death all happen on the GPU, the CPU only sets a few uniforms.
+//
+// - OpenGL 4.3+: compute shader. Survivors and new particles are packed to the front of the destination buffer,
+//   an atomic counter inside the indirect draw command counts them and glDrawArraysIndirect draws exactly that many.
+// - OpenGL 3.3: transform feedback. The pool is always full (dead particles respawn in the shader),
+//   dead / unborn particles are moved out of clip space by the vertex shader.
+class ParticleSystem {
+public:
+    // Each particle: vec4 position + age, vec4 velocity + lifetime (32 bytes, same layout for both paths)
+    struct Particle {
+        glm::vec4 positionAge;
+        glm::vec4 velocityLife;
+    };
+
+    // DrawArraysIndirectCommand
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    glm::vec3 sunCenter;
+    float sunRadius;
+    float gravity = 8.0f;
+    float windFraction = 0.25f;
+    float intensity = 0.12f;
+
+    ParticleSystem(size_t capacity, const glm::vec3 &center, float radius)
+        : sunCenter(center), sunRadius(radius), capacity(capacity) {
+        useCompute = GLAD_GL_VERSION_4_3 != 0;
+
+        render = new Shader("asset/shaders/particle.vs", "asset/shaders/particle.fs");
+        render->setBlockBinding("Camera", CameraBuffer::BINDING);
+        if (useCompute) {
+            update = new Shader("asset/shaders/particle_update.cs");
+        } else {
+            update = new Shader("asset/shaders/particle_update.vs", {"outPositionAge", "outVelocityLife"});
+        }
+
+        // Start with every particle unborn. Transform feedback: staggered negative ages spread the first wave out.
+        // Compute: the count starts at 0 and emission fills the buffer up.
+        std::vector<Particle> initial(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            float stagger = static_cast<float>(i) / static_cast<float>(capacity) * meanLife();
+            initial[i].positionAge = glm::vec4(sunCenter, -stagger);
+            initial[i].velocityLife = glm::vec4(0.0f);
+        }
+
+        glGenVertexArrays(2, VAO);
+        glGenBuffers(2, VBO);
+        for (int i = 0; i < 2; ++i) {
+            glBindVertexArray(VAO[i]);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO[i]);
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Particle), initial.data(), GL_DYNAMIC_COPY);
+
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)(sizeof(glm::vec4)));
+            glEnableVertexAttribArray(1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        if (useCompute) {
+            DrawCommand command = {0, 1, 0, 0};
+            glGenBuffers(2, commandBuffer);
+            for (int i = 0; i < 2; ++i) {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer[i]);
+                glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand), &command, GL_DYNAMIC_COPY);
+            }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+
+        std::cout << "Particles: " << capacity << " (" << (useCompute ? "compute shader" : "transform feedback") << ")\n";
+    }
+
+    ~ParticleSystem() {
+        delete render;
+        delete update;
+    }
+
+    ParticleSystem(const ParticleSystem &) = delete;
+    ParticleSystem &operator=(const ParticleSystem &) = delete;
+
+    // Emit, move and kill particles for `deltaTime` seconds (GPU only)
+    void step(float deltaTime) {
+        deltaTime = std::min(deltaTime, 0.1f); // don't explode after a hitch
+        int source = current;
+        int destination = 1 - current;
+
+        update->use();
+        update->setFloat("deltaTime", deltaTime);
+        update->setInt("seed", static_cast<int>(frame++));
+        update->setVec3("sunCenter", sunCenter);
+        update->setFloat("sunRadius", sunRadius);
+        update->setFloat("gravity", gravity);
+        update->setFloat("windFraction", windFraction);
+
+        if (useCompute) {
+            // steady state: capacity particles alive, so emit capacity / mean lifetime per second
+            emitBudget += static_cast<float>(capacity) * deltaTime / meanLife();
+            GLuint emitCount = static_cast<GLuint>(emitBudget);
+            emitBudget -= static_cast<float>(emitCount);
+
+            glUniform1ui(glGetUniformLocation(update->ID, "capacity"), static_cast<GLuint>(capacity));
+            glUniform1ui(glGetUniformLocation(update->ID, "emitCount"), emitCount);
+
+            GLuint zero = 0;
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer[destination]);
+            glClearBufferSubData(GL_DRAW_INDIRECT_BUFFER, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, VBO[source]);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, VBO[destination]);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer[source]);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, commandBuffer[destination]);
+            glDispatchCompute(static_cast<GLuint>((capacity + 255) / 256), 1, 1);
+
+            // the results are read next as vertex data and as draw parameters
+            glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        } else {
+            glEnable(GL_RASTERIZER_DISCARD);
+            glBindVertexArray(VAO[source]);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, VBO[destination]);
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(capacity));
+            glEndTransformFeedback();
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+            glDisable(GL_RASTERIZER_DISCARD);
+        }
+
+        current = destination;
+    }
+
+    // Additive point sprites. Depth tested against the planets but never written, so particles don't hide each other.
+    // View and projection come from the Camera uniform block (CameraBuffer).
+    void draw(float viewportHeight, float fovRadians) {
+        render->use();
+        render->setFloat("pointScale", 0.15f * viewportHeight / (2.0f * std::tan(fovRadians * 0.5f)));
+        render->setFloat("intensity", intensity);
+
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glDepthMask(GL_FALSE);
+
+        glBindVertexArray(VAO[current]);
+        if (useCompute) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer[current]);
+            glDrawArraysIndirect(GL_POINTS, 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        } else {
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(capacity));
+        }
+
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+
+    size_t getCapacity() const { return capacity; }
+    // both particle buffers, plus the indirect draw commands with the compute shader
+    size_t getBufferBytes() const { return 2 * capacity * sizeof(Particle) + (useCompute ? 2 * sizeof(DrawCommand) : 0); }
+    bool usesCompute() const { return useCompute; }
+
+    void del() {
+        glDeleteVertexArrays(2, VAO);
+        glDeleteBuffers(2, VBO);
+        if (useCompute) glDeleteBuffers(2, commandBuffer);
+        glDeleteProgram(render->ID);
+        glDeleteProgram(update->ID);
+    }
+
+private:
+    size_t capacity;
+    bool useCompute;
+    Shader *render;
+    Shader *update;
+    GLuint VAO[2], VBO[2];
+    GLuint commandBuffer[2] = {0, 0};
+    int current = 0;
+    unsigned int frame = 0;
+    float emitBudget = 0.0f;
+
+    // average lifetime of a particle (mix of corona 0.8-2.5s and solar wind 4-8s)
+    float meanLife() const { return windFraction * 6.0f + (1.0f - windFraction) * 1.65f; }
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef POSTPROCESS_H
+#define POSTPROCESS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "shader.h"
+
+// Full-screen passes drawn on top of the scene: the dynamic resolution upscale and bloom.
+// Each one draws a single triangle covering the viewport (no vertex buffer, the corners come from gl_VertexID)
+// into whatever framebuffer is bound, and samples the used part of its input texture:
+// `usedSize` is the used part in texture coordinates, `texelSize` 1 / the texture's full size
+// (FrameGraph::getUsedScale / getTexelSize).
+class PostProcess {
+public:
+    void create() {
+        upscaleShader = new Shader("asset/shaders/fullscreen.vs", "asset/shaders/upscale.fs");
+        brightShader = new Shader("asset/shaders/fullscreen.vs", "asset/shaders/bloom_bright.fs");
+        blurShader = new Shader("asset/shaders/fullscreen.vs", "asset/shaders/bloom_blur.fs");
+        compositeShader = new Shader("asset/shaders/fullscreen.vs", "asset/shaders/bloom_composite.fs");
+        glGenVertexArrays(1, &emptyVAO);
+    }
+
+    // Stretches the scene over the viewport, optionally sharpened (0 = plain bilinear)
+    void upscale(GLuint scene, glm::vec2 usedSize, glm::vec2 texelSize, float sharpness) {
+        begin(*upscaleShader, scene, usedSize, texelSize);
+        upscaleShader->setInt("scene", 0);
+        upscaleShader->setFloat("sharpness", sharpness);
+        end();
+    }
+
+    // Bloom 1/3: the parts of the scene brighter than `threshold`, drawn at half resolution
+    void bright(GLuint scene, glm::vec2 usedSize, glm::vec2 texelSize, float threshold) {
+        begin(*brightShader, scene, usedSize, texelSize);
+        brightShader->setInt("scene", 0);
+        brightShader->setFloat("threshold", threshold);
+        end();
+    }
+
+    // Bloom 2/3: one direction of a gaussian blur, run once horizontally (1, 0) and once vertically (0, 1)
+    void blur(GLuint image, glm::vec2 usedSize, glm::vec2 texelSize, glm::vec2 direction) {
+        begin(*blurShader, image, usedSize, texelSize);
+        blurShader->setInt("image", 0);
+        glUniform2f(glGetUniformLocation(blurShader->ID, "direction"), direction.x, direction.y);
+        end();
+    }
+
+    // Bloom 3/3: adds the blurred glow to the scene
+    void composite(GLuint glow, glm::vec2 usedSize, glm::vec2 texelSize, float intensity) {
+        begin(*compositeShader, glow, usedSize, texelSize);
+        compositeShader->setInt("glow", 0);
+        compositeShader->setFloat("intensity", intensity);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        end();
+        glDisable(GL_BLEND);
+    }
+
+    void del() {
+        if (emptyVAO) glDeleteVertexArrays(1, &emptyVAO);
+        emptyVAO = 0;
+        for (Shader **shader : {&upscaleShader, &brightShader, &blurShader, &compositeShader}) {
+            if (!*shader) continue;
+            glDeleteProgram((*shader)->ID);
+            delete *shader;
+            *shader = nullptr;
+        }
+    }
+
+private:
+    Shader *upscaleShader = nullptr, *brightShader = nullptr, *blurShader = nullptr, *compositeShader = nullptr;
+    GLuint emptyVAO = 0;
+
+    void begin(Shader &shader, GLuint texture, glm::vec2 usedSize, glm::vec2 texelSize) {
+        glDisable(GL_DEPTH_TEST);
+        shader.use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glUniform2f(glGetUniformLocation(shader.ID, "usedSize"), usedSize.x, usedSize.y);
+        glUniform2f(glGetUniformLocation(shader.ID, "texelSize"), texelSize.x, texelSize.y);
+    }
+
+    void end() {
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glEnable(GL_DEPTH_TEST);
+    }
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <iostream>
+#include "window.h"
+#include "shader.h"
+#include "mesh.h"
+#include "framepacket.h"
+#include "framepacer.h"
+#include "latency.h"
+#include "profiler.h"
+#include "framestats.h"
+#include "gltrace.h"
+
+// Triple-buffered mailbox between one producer and one consumer.
+// Three slots: the consumer reads `front`, the producer writes `back`, and `ready` holds the newest
+// published one. publish() and acquire() swap slots with a single atomic exchange, so neither side ever
+// copies a packet or touches the slot the other one is using. If the producer publishes twice before the
+// consumer looks, the older packet is replaced (latest wins).
+// The mutex / condition variable are only used to sleep while there is nothing to do.
+template <typename T>
+class Mailbox {
+public:
+    // producer: the slot to fill next (invisible to the consumer until publish)
+    T &writeSlot() { return slots[back]; }
+
+    // producer: makes the written slot the newest one
+    void publish() {
+        back = ready.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+        wake();
+    }
+
+    // producer: sleeps until the consumer has taken the last published slot (or close() was called)
+    void waitUntilTaken() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return !(ready.load(std::memory_order_acquire) & FRESH) || closed; });
+    }
+
+    // consumer: sleeps until a new slot is published, then makes it readSlot().
+    // Returns false once closed and everything published has been taken.
+    bool acquire() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return (ready.load(std::memory_order_acquire) & FRESH) || closed; });
+            if (!(ready.load(std::memory_order_acquire) & FRESH)) return false;
+        }
+        front = ready.exchange(front, std::memory_order_acq_rel) & INDEX;
+        wake();
+        return true;
+    }
+
+    // consumer: the slot returned by the last acquire()
+    const T &readSlot() const { return slots[front]; }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        changed.notify_all();
+    }
+
+private:
+    static const int INDEX = 3; // low bits of `ready`: slot index
+    static const int FRESH = 4; // set by publish, cleared by acquire
+
+    T slots[3];
+    int back = 0;               // producer only
+    int front = 1;              // consumer only
+    std::atomic<int> ready{2};
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool closed = false;
+
+    // the lock makes sure a waiter between checking its condition and sleeping still gets the notification
+    void wake() {
+        { std::lock_guard<std::mutex> lock(mutex); }
+        changed.notify_all();
+    }
+};
+
+// Render thread: owns the window's OpenGL context and turns frame packets into GL calls, while the main
+// thread polls input, simulates and builds the next packet. Frame N+1 is simulated while frame N is submitted,
+// so a frame costs about max(simulation, rendering) instead of their sum.
+// Pacing, late latch, latency queries and swapBuffers all happen here, since they need the context.
+//
+// Usage:
+//   ... create the window, Tri and shaders on the main thread ...
+//   renderer.start();                       // the main thread must not make GL calls until stop()
+//   while (...) {
+//       glfwPollEvents(); ... input ...
+//       FramePacket &packet = renderer.beginFrame();
+//       tri.buildPacket(camera, glfwGetTime(), packet);
+//       renderer.submit();                  // returns as soon as the render thread has picked it up
+//   }
+//   renderer.stop();                        // the context is current on the main thread again
+class RenderThread {
+public:
+    RenderThread(Window &window, Tri &tri, Shader &light, Shader &shader,
+                 FramePacer &pacer, LatencyTracker &latency)
+        : window(window), tri(tri), light(light), shader(shader),
+          pacer(pacer), latency(latency) {}
+
+    RenderThread(const RenderThread &) = delete;
+    RenderThread &operator=(const RenderThread &) = delete;
+
+    ~RenderThread() {
+        if (thread.joinable()) stop();
+    }
+
+    // Hands the GL context (current on the calling thread) over to the render thread
+    void start() {
+        Window::releaseCurrent();
+        thread = std::thread(&RenderThread::run, this);
+    }
+
+    // The packet to fill for the next frame
+    FramePacket &beginFrame() { return mailbox.writeSlot(); }
+
+    // Sends the packet, then waits until the render thread has taken it (so at most one frame is queued
+    // behind the one being drawn)
+    void submit() {
+        PROFILE_ZONE("submit");
+        mailbox.writeSlot().frame = ++submitted;
+        mailbox.publish();
+        mailbox.waitUntilTaken();
+    }
+
+    // Late latch: newest camera from the main thread. If it arrives while an older packet is still being drawn,
+    // the render thread writes it into that frame's camera block just before swapBuffers.
+    void latchCamera(const CameraBlock &block, double inputTime) {
+        std::lock_guard<std::mutex> lock(latchMutex);
+        latest.block = block;
+        latest.inputTime = inputTime;
+        latest.frame = submitted + 1; // the packet it will also go into
+    }
+
+    void setLateLatch(bool on) { lateLatch.store(on); }
+
+    // Records every frame into `stats` (call before start(), read it after stop())
+    void setFrameStats(FrameStats *frameStats) { stats = frameStats; }
+
+    // Applied by the render thread before its next frame (it prints the old mode's report first).
+    // targetFps must be given (e.g. FramePacer::getRefreshRate()) because monitors can only be queried on the main thread.
+    void setPacing(FramePacer::Mode mode, double targetFps) {
+        std::lock_guard<std::mutex> lock(latchMutex);
+        pacingFps = targetFps;
+        pacingMode.store(mode);
+    }
+
+    // Dynamic resolution on / off (see Tri::setDynamicResolution), applied by the render thread before its next frame
+    void setDynamicResolution(bool on, float budgetMs) {
+        std::lock_guard<std::mutex> lock(latchMutex);
+        resolutionBudget = budgetMs;
+        resolutionMode.store(on ? 1 : 0);
+    }
+
+    // GL call tracing on / off (see gltrace.h), applied by the render thread before its next frame.
+    // While on, the last frame's GL calls are printed every 5 seconds.
+    void setGlTrace(bool on) { glTraceMode.store(on ? 1 : 0); }
+
+    // Bloom on / off (see Tri::setBloom), applied by the render thread before its next frame
+    void setBloom(bool on) { bloomMode.store(on ? 1 : 0); }
+
+    unsigned long getFramesRendered() const { return rendered.load(); }
+
+    // Lets the render thread finish the last packet, then takes the GL context back
+    void stop() {
+        mailbox.close();
+        thread.join();
+        window.makeCurrent();
+    }
+
+private:
+    struct Latch {
+        CameraBlock block;
+        double inputTime = 0.0;
+        unsigned long frame = 0;
+    };
+
+    Window &window;
+    Tri &tri;
+    Shader &light, &shader;
+    FramePacer &pacer;
+    LatencyTracker &latency;
+
+    std::thread thread;
+    Mailbox<FramePacket> mailbox;
+    unsigned long submitted = 0;            // main thread only
+    std::atomic<unsigned long> rendered{0};
+    std::atomic<bool> lateLatch{false};
+    std::atomic<int> pacingMode{-1};        // requested mode, -1 = no change
+    double pacingFps = 0.0;                 // guarded by latchMutex
+    std::atomic<int> resolutionMode{-1};    // requested dynamic resolution: 1 on, 0 off, -1 = no change
+    float resolutionBudget = 0.0f;          // guarded by latchMutex
+    std::atomic<int> glTraceMode{-1};       // requested GL tracing: 1 on, 0 off, -1 = no change
+    std::atomic<int> bloomMode{-1};         // requested bloom: 1 on, 0 off, -1 = no change
+    std::mutex latchMutex;
+    Latch latest;                           // guarded by latchMutex
+    FrameStats *stats = nullptr;            // render thread only while running
+
+    void run() {
+        PROFILE_THREAD("render");
+        window.makeCurrent();
+        double lastShownInput = 0.0; // newest input already shown by a frame (latched or not)
+        double lastPresent = 0.0;
+        double lastTraceReport = 0.0;
+
+        while (mailbox.acquire()) {
+            const FramePacket &packet = mailbox.readSlot();
+            applyPacing();
+            applyResolution();
+            applyGlTrace();
+            applyBloom();
+
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            double renderStart = glfwGetTime();
+            tri.render(light, shader, packet);
+            double renderEnd = glfwGetTime();
+
+            // Limiter: wait for this frame's present time (the main thread keeps reading input meanwhile)
+            {
+                PROFILE_ZONE("wait for present");
+                pacer.waitForPresent();
+            }
+
+            // input that was already shown through a late latch does not count again
+            double inputTime = packet.inputTime > lastShownInput ? packet.inputTime : 0.0;
+            if (lateLatch.load() && tri.supportsLateLatch()) {
+                Latch newest;
+                {
+                    std::lock_guard<std::mutex> lock(latchMutex);
+                    newest = latest;
+                }
+                if (newest.frame > packet.frame && tri.latchCamera(newest.block) && newest.inputTime > lastShownInput) {
+                    if (inputTime == 0.0) inputTime = newest.inputTime;
+                    lastShownInput = newest.inputTime;
+                }
+            }
+            if (packet.inputTime > lastShownInput) lastShownInput = packet.inputTime;
+            latency.endFrame(inputTime, glfwGetTime());
+
+            {
+                PROFILE_ZONE("swapBuffers");
+                window.swapBuffers();
+            }
+            pacer.presented();
+            rendered.fetch_add(1);
+            GlTrace::endFrame();
+
+            double presentTime = glfwGetTime();
+            if (GlTrace::isInstalled() && presentTime - lastTraceReport > 5.0) {
+                lastTraceReport = presentTime;
+                GlTrace::printFrame();
+            }
+            if (stats && lastPresent > 0.0) {
+                FrameSample sample;
+                sample.time = presentTime;
+                sample.frameMs = static_cast<float>((presentTime - lastPresent) * 1000.0);
+                sample.simMs = packet.simMs;
+                sample.renderMs = static_cast<float>((renderEnd - renderStart) * 1000.0);
+                sample.gpuMs = tri.getProfiler().getLastMs("frame");
+                sample.counters = tri.getCounters();
+                sample.counters.stateChanges = GlTrace::getLastStateChanges(); // -1 unless G turned tracing on
+                stats->record(sample);
+            }
+            lastPresent = presentTime;
+        }
+
+        Window::releaseCurrent();
+    }
+
+    void applyPacing() {
+        int mode = pacingMode.exchange(-1);
+        if (mode < 0) return;
+        double fps;
+        {
+            std::lock_guard<std::mutex> lock(latchMutex);
+            fps = pacingFps;
+        }
+        pacer.printReport();
+        pacer.setMode(static_cast<FramePacer::Mode>(mode), fps);
+        std::cout << "Frame pacing: " << FramePacer::getModeName(pacer.getMode()) << "\n";
+    }
+
+    void applyResolution() {
+        int mode = resolutionMode.exchange(-1);
+        if (mode < 0) return;
+        float budget;
+        {
+            std::lock_guard<std::mutex> lock(latchMutex);
+            budget = resolutionBudget;
+        }
+        tri.setDynamicResolution(mode == 1, budget);
+        std::cout << "Dynamic resolution " << (mode == 1 ? "on" : "off") << "\n";
+    }
+
+    // the GL function pointers are swapped here, between frames, so no call is half traced
+    void applyGlTrace() {
+        int mode = glTraceMode.exchange(-1);
+        if (mode < 0) return;
+        if (mode == 1) GlTrace::install();
+        else GlTrace::uninstall();
+        std::cout << "GL call tracing " << (mode == 1 ? "on" : "off") << "\n";
+    }
+
+    void applyBloom() {
+        int mode = bloomMode.exchange(-1);
+        if (mode < 0) return;
+        tri.setBloom(mode == 1);
+        std::cout << "Bloom " << (mode == 1 ? "on" : "off") << "\n";
+    }
+};
+
+#endif
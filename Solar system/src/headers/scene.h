@@ -0,0 +1,107 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include <vector>
+#include <cstddef>
+
+// Flat scene graph: every node lives at an index inside plain arrays (parent, local TRS, world matrix).
+// A node can only be parented to a node that already exists, so the arrays are always in
+// topological order (parent index < child index) and one linear pass updates the whole hierarchy.
+class SceneGraph {
+public:
+    // Add a node under `parentNode` (-1 = root). Returns the new node index.
+    int addNode(int parentNode = -1) {
+        int index = static_cast<int>(parent.size());
+        parent.push_back(parentNode);
+        translation.push_back(glm::vec3(0.0f));
+        rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        scaling.push_back(glm::vec3(1.0f));
+        world.push_back(glm::mat4(1.0f));
+        dirty.push_back(1);
+        changedPass.push_back(0);
+        markDirty(index);
+        return index;
+    }
+
+    // Setters only flag the node; nothing is recomputed until updateWorld()
+    void setTranslation(int node, const glm::vec3 &value) { translation[node] = value; markDirty(node); }
+    void setRotation(int node, const glm::quat &value) { rotation[node] = value; markDirty(node); }
+    void setScale(int node, const glm::vec3 &value) { scaling[node] = value; markDirty(node); }
+
+    // Parallel-friendly variants: they only touch the node's own slots, so different threads can write
+    // different nodes at the same time. Call markDirtyFrom(lowest node written) once everyone is done.
+    void writeTranslation(int node, const glm::vec3 &value) { translation[node] = value; dirty[node] = 1; }
+    void writeRotation(int node, const glm::quat &value) { rotation[node] = value; dirty[node] = 1; }
+    void markDirtyFrom(int node) {
+        if (static_cast<size_t>(node) < firstDirty) {
+            firstDirty = node;
+        }
+    }
+
+    const glm::mat4 &getWorld(int node) const { return world[node]; }
+    glm::vec3 getWorldPosition(int node) const { return glm::vec3(world[node][3]); }
+    int getParent(int node) const { return parent[node]; }
+    size_t size() const { return parent.size(); }
+
+    // number of world matrices rebuilt by the last updateWorld() call
+    size_t getUpdatedCount() const { return updatedCount; }
+
+    // Recompute world matrices for dirty nodes and everything below them.
+    // Nodes before the first dirty node cannot be affected (parents come first), so they are skipped,
+    // and a frame where nothing moved returns straight away.
+    void updateWorld() {
+        updatedCount = 0;
+        if (firstDirty >= parent.size()) {
+            return;
+        }
+
+        ++pass;
+        for (size_t i = firstDirty; i < parent.size(); ++i) {
+            int p = parent[i];
+            bool parentChanged = p >= 0 && changedPass[p] == pass;
+
+            if (!dirty[i] && !parentChanged) {
+                continue;
+            }
+
+            glm::mat4 local = localMatrix(i);
+            world[i] = p >= 0 ? world[p] * local : local;
+            dirty[i] = 0;
+            changedPass[i] = pass;
+            ++updatedCount;
+        }
+
+        firstDirty = parent.size();
+    }
+
+private:
+    std::vector<int> parent;
+    std::vector<glm::vec3> translation;
+    std::vector<glm::quat> rotation;
+    std::vector<glm::vec3> scaling;
+    std::vector<glm::mat4> world;
+    std::vector<unsigned char> dirty;   // local TRS edited since last update
+    std::vector<unsigned int> changedPass; // pass number in which the world matrix was last rebuilt
+    unsigned int pass = 0;
+    size_t firstDirty = 0;
+    size_t updatedCount = 0;
+
+    void markDirty(int node) {
+        dirty[node] = 1;
+        markDirtyFrom(node);
+    }
+
+    // T * R * S built directly instead of chaining glm::translate/rotate/scale
+    glm::mat4 localMatrix(size_t i) const {
+        glm::mat4 m = glm::mat4_cast(rotation[i]);
+        m[0] *= scaling[i].x;
+        m[1] *= scaling[i].y;
+        m[2] *= scaling[i].z;
+        m[3] = glm::vec4(translation[i], 1.0f);
+        return m;
+    }
+};
+
+#endif
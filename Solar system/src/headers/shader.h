@@ -9,6 +9,8 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include "profiler.h"
 
 //`Shader anything` to call constructor of Shader() class
 //TL;TR: Creates a new shader object called "anything" in main.cpp from shader() constructor
@@ -18,6 +20,7 @@ public:
 
     // Constructor using file paths
     Shader(const char* vertexPath, const char* fragmentPath) {
+        PROFILE_ZONE("Shader");
         // empty boxes to store stuff (variables)
         std::string vertexCode; 
         std::string fragmentCode;
@@ -86,6 +89,44 @@ public:
         glDeleteShader(fragment);
     }
 
+    // Compute shader program (needs OpenGL 4.3)
+    explicit Shader(const char* computePath) {
+        PROFILE_ZONE("Shader (compute)");
+        std::string computeCode = readFile(computePath);
+        const char* ComputeShader = computeCode.c_str();
+
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &ComputeShader, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(compute);
+    }
+
+    // Vertex-only program whose outputs are captured with transform feedback (interleaved into one buffer)
+    Shader(const char* vertexPath, const std::vector<const char*>& feedbackVaryings) {
+        PROFILE_ZONE("Shader (transform feedback)");
+        std::string vertexCode = readFile(vertexPath);
+        const char* VertexShader = vertexCode.c_str();
+
+        unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &VertexShader, NULL);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        // must be declared before linking
+        glTransformFeedbackVaryings(ID, static_cast<GLsizei>(feedbackVaryings.size()), feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(vertex);
+    }
+
     //`shader.use()` (in main.cpp) to activate this shader render program
     void use() const { // const to make it "read-only"
         glUseProgram(ID); 
@@ -113,8 +154,33 @@ public:
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
 
+    // Connects a uniform block (e.g "Camera") to a buffer binding point. Does nothing if the program has no such block.
+    void setBlockBinding(const std::string &name, unsigned int binding) const {
+        GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(ID, index, binding);
+        }
+    }
+
 //Error checking...
 private:
+    // Whole file as a string (prints an error and returns "" if it can't be read)
+    std::string readFile(const char* path) {
+        std::ifstream file;
+        file.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            return stream.str();
+        }
+        catch (std::ifstream::failure& e) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << " " << e.what() << std::endl;
+        }
+        return "";
+    }
+
     void checkCompileErrors(unsigned int shader, std::string type)
     {
         int success;
@@ -0,0 +1,223 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "shader.h"
+#include "camerabuffer.h"
+
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS
+#define GL_FRAGMENT_SHADER_INVOCATIONS 0x82F4 // OpenGL 4.6 / ARB_pipeline_statistics_query
+#endif
+
+// Star sky as a cubemap, drawn after the opaque bodies.
+//
+// The cubemap comes from the equirectangular space.png, converted offline by make_skybox (src/make_skybox.cpp) into
+// a .cubemap file with every mip level already made, so startup only reads and uploads it. The file is not in the
+// repository: when it is missing, Tri converts space.png at startup (Cubemap::build) and saves the file for next time.
+//
+// The sky is one full-screen triangle at the far plane (depth exactly 1.0, drawn with GL_LEQUAL against the cleared
+// depth and no depth writes). Drawn after the sun and planets, every pixel they cover fails the depth test before the
+// fragment shader runs (early-Z), so only the visible sky is shaded. The direction of each pixel comes from the
+// inverse projection and the view's rotation, so the sky turns with the camera but never moves with it.
+//
+// Two queries count the sky's fragments, read back FRAMES frames late like GpuProfiler: GL_SAMPLES_PASSED (pixels the
+// sky was written to) and, when the driver has pipeline statistics queries, GL_FRAGMENT_SHADER_INVOCATIONS (times the
+// sky shader ran). With early-Z they match; a driver that shades before testing depth shows more invocations.
+// setFirst(true) draws the sky the old way for comparison: first, without a depth test, shading every pixel.
+//
+// .cubemap file (native byte order):
+//   char[8] "CUBEMAP1", int32 face size, int32 levels
+//   then for each level (full size first), the 6 faces in GL order (+X, -X, +Y, -Y, +Z, -Z),
+//   each size x size RGB8 texels, rows in GL order (t = 0 first), size halving every level
+class Skybox {
+public:
+    static const int FRAMES = 3; // frames between issuing a fragment query and reading it back
+
+    struct Count {
+        unsigned long long samples = 0;     // GL_SAMPLES_PASSED
+        unsigned long long invocations = 0; // GL_FRAGMENT_SHADER_INVOCATIONS
+    };
+
+    // Bytes of a file, empty if it can't be read
+    static std::vector<char> readFile(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    // Checks the layout of a .cubemap file's bytes
+    static bool isValid(const std::vector<char> &data) {
+        return parseHeader(data, nullptr, nullptr);
+    }
+
+    // Reads the cubemap and compiles the shader. false (and nothing drawn) if the file is missing or broken.
+    bool create(const std::string &path) { return create(readFile(path), path); }
+
+    // Same, from the bytes of a .cubemap file (`name` is only for the error message)
+    bool create(const std::vector<char> &data, const std::string &name) {
+        shader = new Shader("asset/shaders/skybox.vs", "asset/shaders/skybox.fs");
+        shader->setBlockBinding("Camera", CameraBuffer::BINDING);
+        glGenVertexArrays(1, &emptyVAO);
+        glGenQueries(FRAMES * 2, &queries[0][0]);
+        invocations = hasPipelineStatistics();
+
+        int32_t size = 0, levels = 0;
+        if (!parseHeader(data, &size, &levels)) {
+            std::cout << "Skybox failed to load: " << name << " (make it from space.png with make_skybox)\n";
+            return false;
+        }
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of the small levels aren't a multiple of 4 bytes
+        const char *texels = data.data() + 16;
+        for (int level = 0, s = size; level < levels; ++level, s = s > 1 ? s / 2 : 1) {
+            for (int face = 0; face < 6; ++face) {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB8, s, s, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+                texels += static_cast<size_t>(s) * s * 3;
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS); // filter across face edges (no seams in the mip levels)
+        faceSize = size;
+        return true;
+    }
+
+    bool isLoaded() const { return texture != 0; }
+    GLuint getTexture() const { return texture; } // the cubemap, 0 = not loaded
+
+    // true: drawn first with the depth test off (every pixel shaded, like the old background)
+    void setFirst(bool on) { first = on; }
+    bool isFirst() const { return first; }
+
+    // Draws the sky into the bound framebuffer (camera from the Camera uniform block). false if there is no sky.
+    bool draw() {
+        if (!texture) return false;
+        collect();
+        if (first) {
+            glDisable(GL_DEPTH_TEST);
+        } else {
+            glDepthFunc(GL_LEQUAL); // the sky's depth is exactly the cleared 1.0
+            glDepthMask(GL_FALSE);
+        }
+        shader->use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        shader->setInt("sky", 0);
+        glBindVertexArray(emptyVAO);
+        GLuint *query = queries[frameIndex % FRAMES];
+        glBeginQuery(GL_SAMPLES_PASSED, query[0]);
+        if (invocations) glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, query[1]);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        if (invocations) glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+        glEndQuery(GL_SAMPLES_PASSED);
+        issued[frameIndex % FRAMES] = true;
+        ++frameIndex;
+        if (first) {
+            glEnable(GL_DEPTH_TEST);
+        } else {
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LESS);
+        }
+        return true;
+    }
+
+    // Pixels written / fragment shader runs of the newest sky draw read back, and the means over every one read back.
+    // The invocation counts stay 0 without pipeline statistics queries (hasInvocationCount()).
+    const Count &getLast() const { return last; }
+    double getMeanSamples() const { return frames ? static_cast<double>(total.samples) / frames : 0.0; }
+    double getMeanInvocations() const { return frames ? static_cast<double>(total.invocations) / frames : 0.0; }
+    bool hasInvocationCount() const { return invocations; }
+    int getFaceSize() const { return faceSize; }
+
+    void del() {
+        if (texture) glDeleteTextures(1, &texture);
+        if (emptyVAO) glDeleteVertexArrays(1, &emptyVAO);
+        if (queries[0][0]) glDeleteQueries(FRAMES * 2, &queries[0][0]);
+        texture = emptyVAO = 0;
+        for (GLuint *query : queries) query[0] = query[1] = 0;
+        if (shader) {
+            glDeleteProgram(shader->ID);
+            delete shader;
+            shader = nullptr;
+        }
+    }
+
+private:
+    Shader *shader = nullptr;
+    GLuint texture = 0, emptyVAO = 0;
+    GLuint queries[FRAMES][2] = {}; // samples passed, invocations
+    bool issued[FRAMES] = {};
+    bool invocations = false; // pipeline statistics queries available
+    unsigned long frameIndex = 0;
+    Count last, total;
+    unsigned long frames = 0; // frames read back
+    int faceSize = 0;
+    bool first = false;
+
+    // Reads the queries about to be reused (issued FRAMES draws ago), skipped if the GPU isn't done with them
+    void collect() {
+        int slot = static_cast<int>(frameIndex % FRAMES);
+        if (!issued[slot]) return;
+        issued[slot] = false;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot][0], GL_QUERY_RESULT_AVAILABLE, &available); // ended last, so done last
+        if (!available) return;
+        GLuint64 samples = 0, shaded = 0;
+        glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &samples);
+        if (invocations) glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &shaded);
+        last.samples = samples;
+        last.invocations = shaded;
+        total.samples += samples;
+        total.invocations += shaded;
+        ++frames;
+    }
+
+    // Size and mip levels from the header, and whether the bytes are exactly that many levels (size and levels may be null)
+    static bool parseHeader(const std::vector<char> &data, int32_t *sizeOut, int32_t *levelsOut) {
+        char magic[8];
+        int32_t size = 0, levels = 0;
+        if (data.size() < 16) return false;
+        std::memcpy(magic, data.data(), 8);
+        std::memcpy(&size, data.data() + 8, 4);
+        std::memcpy(&levels, data.data() + 12, 4);
+        if (std::memcmp(magic, "CUBEMAP1", 8) != 0 || size <= 0 || levels <= 0 || levels > 16) return false;
+        size_t expected = 16;
+        for (int level = 0, s = size; level < levels; ++level, s = s > 1 ? s / 2 : 1) {
+            expected += static_cast<size_t>(6) * s * s * 3;
+        }
+        if (data.size() != expected) return false;
+        if (sizeOut) *sizeOut = size;
+        if (levelsOut) *levelsOut = levels;
+        return true;
+    }
+
+    static bool hasPipelineStatistics() {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 6)) return true;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+            if (name && std::strcmp(name, "GL_ARB_pipeline_statistics_query") == 0) return true;
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef SOLAR_H
+#define SOLAR_H
+
+#include "scene.h"
+#include "frustum.h"
+#include "jobs.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include <vector>
+#include <string>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+
+// Elliptical orbit around the parent's orbit pivot:
+// x = radius.x * cos(angle), y = radius.y * sin(time * heightSpeed + phase), z = radius.z * sin(angle)
+// negative speed = clockwise orbit
+struct Orbit {
+    glm::vec3 radius = glm::vec3(0.0f);
+    float speed = 0.0f;       // angle = time * speed + phase (radians)
+    float heightSpeed = 0.0f; // how fast it bobs up and down
+};
+
+// One drawable body (sun, planet, moon, ring).
+// Each body owns two nodes: an orbit pivot (translation only, children such as moons and rings attach here)
+// and the body itself (axial tilt, spin and size) so that a planet's spin is never inherited by its moon.
+struct Body {
+    std::string name;
+    int parent = -1;          // index into SolarSystem::bodies, -1 = orbits the world origin
+    Orbit orbit;
+    float phase = 0.0f;       // starting angle on the orbit
+    glm::vec3 offset = glm::vec3(0.0f); // fixed pivot position for bodies without an orbit (e.g the sun)
+    float tilt = 0.0f;        // axial tilt in degrees (around Z)
+    float spinSpeed = 0.0f;   // spin around own Y axis (radians per second), negative = clockwise
+    glm::vec3 size = glm::vec3(1.0f);
+    bool emissive = false;    // drawn with the light (sun) shader
+    unsigned int texture = 0; // diffuse map, set by the renderer
+
+    int orbitNode = -1;
+    int bodyNode = -1;
+
+    bool orbits() const { return orbit.speed != 0.0f || orbit.heightSpeed != 0.0f; }
+};
+
+class SolarSystem {
+public:
+    SceneGraph scene;
+    std::vector<Body> bodies;
+    glm::vec3 lightPos = glm::vec3(1.2f, 1.0f, 0.0f);
+
+    SolarSystem() {
+        float timeScale = 0.01f; // Slow down time for better visual (or else all planets rotate too fast to preview)
+        float sizeScale = 10.0f; // increase planet size for better visual
+        float ssize = 12.8f;     // Sun size
+
+        // Sun: fixed at the light position, only spins
+        Body sun;
+        sun.name = "Sun";
+        sun.offset = lightPos;
+        sun.tilt = 7.25f;
+        sun.spinSpeed = 0.12f;
+        sun.size = glm::vec3(ssize);
+        sun.emissive = true;
+        addBody(sun);
+
+        // Inner planets orbit just outside the sun's diameter, the outer ones (Jupiter onwards) are far enough already.
+        // name, distance (AU), angular velocity (rad/s), tilt, spin direction, scale
+        int earth = addBody(planet("Earth", lightPos.x + ssize + 1.00f * sizeScale, lightPos.z + ssize + 1.00f * sizeScale,
+                                   lightPos.y + 3.5f, 29.78f * timeScale, 23.5f, 1.0f, 0.75f));
+        addBody(planet("Mercury", lightPos.x + ssize + 0.39f * sizeScale, lightPos.z + ssize + 0.39f * sizeScale,
+                       lightPos.y + 2.5f, 122.8f * timeScale, 0.034f, 1.0f, 0.287f));
+        addBody(planet("Venus", lightPos.x + ssize + 0.72f * sizeScale, lightPos.z + ssize + 0.72f * sizeScale,
+                       lightPos.y + 2.5f, 48.6f * timeScale, 177.4f, -1.0f, 0.712f)); // clockwise
+        addBody(planet("Mars", lightPos.x + ssize + 1.52f * sizeScale, lightPos.z + ssize + 1.52f * sizeScale,
+                       lightPos.y + 2.5f, 15.8f * timeScale, 25.2f, 1.0f, 0.398f));
+        addBody(planet("Jupiter", lightPos.x + 5.20f * sizeScale, lightPos.z + 5.20f * sizeScale,
+                       lightPos.y + 2.5f, 2.51f * timeScale, 3.13f, 1.0f, 8.210f));
+        int saturn = addBody(planet("Saturn", lightPos.x + 9.58f * sizeScale, lightPos.z + 9.58f * sizeScale,
+                                    lightPos.y + 2.5f, 1.01f * timeScale, 26.7f, 1.0f, 6.844f));
+        addBody(planet("Uranus", lightPos.x + 19.18f * sizeScale, lightPos.z + 19.18f * sizeScale,
+                       lightPos.y + 2.5f, 0.355f * timeScale, 97.77f, -1.0f, 2.986f)); // clockwise
+        addBody(planet("Neptune", lightPos.x + 30.07f * sizeScale, lightPos.z + 30.07f * sizeScale,
+                       lightPos.y + 2.5f, 0.181f * timeScale, 28.3f, 1.0f, 2.901f));
+
+        // Moon: parented to Earth's orbit pivot, orbits in the opposite direction
+        Body moon;
+        moon.name = "Moon";
+        moon.parent = earth;
+        moon.orbit.radius = glm::vec3(1.2f, 0.75f, 1.2f);
+        moon.orbit.speed = -1.022f;     // moves slightly faster than earth
+        moon.orbit.heightSpeed = 0.5f;
+        moon.tilt = 5.1f;
+        moon.spinSpeed = 1.022f * 2.0f;
+        moon.size = glm::vec3(0.204f);  // one-quarter the diameter of Earth
+        addBody(moon);
+
+        // Saturn's ring: sits on Saturn's orbit pivot, shares its tilt and spins faster
+        Body ring;
+        ring.name = "Saturn Ring";
+        ring.parent = saturn;
+        ring.tilt = 26.7f;
+        ring.spinSpeed = 1.01f * timeScale * 4.7f;
+        ring.size = glm::vec3(10.0f, 1.0f, 10.0f);
+        addBody(ring);
+    }
+
+    // Adds the body's orbit pivot and body node. Returns the body index.
+    int addBody(Body body) {
+        int parentNode = body.parent >= 0 ? bodies[body.parent].orbitNode : -1;
+        body.orbitNode = scene.addNode(parentNode);
+        body.bodyNode = scene.addNode(body.orbitNode);
+
+        scene.setTranslation(body.orbitNode, body.offset);
+        scene.setRotation(body.bodyNode, glm::angleAxis(glm::radians(body.tilt), glm::vec3(0.0f, 0.0f, 1.0f)));
+        scene.setScale(body.bodyNode, body.size);
+
+        bodies.push_back(body);
+        return static_cast<int>(bodies.size()) - 1;
+    }
+
+    int findBody(const std::string &name) const {
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            if (bodies[i].name == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Moves every animated node to `time` (seconds) and refreshes world matrices.
+    // Bodies without orbit or spin are never touched again after addBody().
+    // With a job system the per-body orbit/spin maths is spread over its workers.
+    void update(float time, JobSystem *jobs = nullptr) {
+        if (bodies.empty()) return;
+
+        auto animate = [this, time](size_t begin, size_t end) {
+            glm::vec3 zAxis(0.0f, 0.0f, 1.0f);
+            glm::vec3 yAxis(0.0f, 1.0f, 0.0f);
+
+            for (size_t i = begin; i < end; ++i) {
+                const Body &body = bodies[i];
+                if (body.orbits()) {
+                    float angle = time * body.orbit.speed + body.phase;
+                    glm::vec3 pos = body.offset;
+                    pos.x += body.orbit.radius.x * std::cos(angle);
+                    pos.y += body.orbit.radius.y * std::sin(time * body.orbit.heightSpeed + body.phase);
+                    pos.z += body.orbit.radius.z * std::sin(angle);
+                    scene.writeTranslation(body.orbitNode, pos);
+                }
+
+                if (body.spinSpeed != 0.0f) {
+                    glm::quat tilt = glm::angleAxis(glm::radians(body.tilt), zAxis);
+                    glm::quat spin = glm::angleAxis(time * body.spinSpeed, yAxis);
+                    scene.writeRotation(body.bodyNode, tilt * spin);
+                }
+            }
+        };
+
+        if (jobs) {
+            jobs->parallelFor(bodies.size(), animate);
+        } else {
+            animate(0, bodies.size());
+        }
+
+        // bodies are stored in node order, so nothing before the first body's orbit node can be dirty
+        scene.markDirtyFrom(bodies[0].orbitNode);
+        scene.updateWorld();
+    }
+
+    // Random small rocks between Mars and Jupiter (same seed = same belt). Returns the first new body index.
+    int addAsteroidBelt(size_t count, uint32_t seed = 1234u, float innerRadius = 35.0f, float outerRadius = 45.0f) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> radius(innerRadius, outerRadius);
+        std::uniform_real_distribution<float> phase(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> height(-1.5f, 1.5f);
+        std::uniform_real_distribution<float> size(0.03f, 0.12f);
+        std::uniform_real_distribution<float> tilt(0.0f, 180.0f);
+
+        int first = static_cast<int>(bodies.size());
+        bodies.reserve(bodies.size() + count);
+        for (size_t i = 0; i < count; ++i) {
+            float r = radius(rng);
+            Body rock;
+            rock.name = "Asteroid";
+            rock.orbit.radius = glm::vec3(r, height(rng), r);
+            rock.orbit.speed = 0.158f * std::pow(29.2f / r, 1.5f); // Kepler's third law, scaled from Mars' orbit
+            rock.orbit.heightSpeed = rock.orbit.speed;
+            rock.tilt = tilt(rng);
+            rock.spinSpeed = 0.5f + phase(rng);
+            rock.size = glm::vec3(size(rng));
+            rock.phase = phase(rng); // start each rock at a different point of its orbit
+            addBody(rock);
+        }
+        return first;
+    }
+
+    const glm::mat4 &getModel(const Body &body) const { return scene.getWorld(body.bodyNode); }
+    glm::vec3 getPosition(const Body &body) const { return scene.getWorldPosition(body.bodyNode); }
+
+    // Bodies are unit spheres, so the bounding radius is the longest scaled axis of the world matrix
+    float getRadius(const Body &body) const {
+        const glm::mat4 &m = getModel(body);
+        float x = glm::dot(glm::vec3(m[0]), glm::vec3(m[0]));
+        float y = glm::dot(glm::vec3(m[1]), glm::vec3(m[1]));
+        float z = glm::dot(glm::vec3(m[2]), glm::vec3(m[2]));
+        return std::sqrt(std::max(x, std::max(y, z)));
+    }
+
+    // Fills `visible` with the indices of bodies whose bounding sphere touches the frustum (in body order)
+    void cull(const Frustum &frustum, std::vector<int> &visible, JobSystem *jobs = nullptr) {
+        visible.clear();
+        if (!jobs) {
+            for (size_t i = 0; i < bodies.size(); ++i) {
+                if (frustum.sphereVisible(getPosition(bodies[i]), getRadius(bodies[i]))) {
+                    visible.push_back(static_cast<int>(i));
+                }
+            }
+            return;
+        }
+
+        // test in parallel into a flag per body, then compact in order on this thread
+        visibleFlags.resize(bodies.size());
+        jobs->parallelFor(bodies.size(), [this, &frustum](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                visibleFlags[i] = frustum.sphereVisible(getPosition(bodies[i]), getRadius(bodies[i])) ? 1 : 0;
+            }
+        });
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            if (visibleFlags[i]) visible.push_back(static_cast<int>(i));
+        }
+    }
+
+private:
+    std::vector<unsigned char> visibleFlags; // scratch for the parallel cull
+
+    // Planet around the origin: spins twice per orbit angle (direction = +1 counter-clockwise, -1 clockwise)
+    static Body planet(const std::string &name, float radiusX, float radiusZ, float height,
+                       float speed, float tilt, float direction, float scale) {
+        Body body;
+        body.name = name;
+        body.orbit.radius = glm::vec3(radiusX, height, radiusZ);
+        body.orbit.speed = speed;
+        body.orbit.heightSpeed = speed;
+        body.tilt = tilt;
+        body.spinSpeed = direction * speed * 2.0f;
+        body.size = glm::vec3(scale);
+        return body;
+    }
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Vertex formats: how a mesh built in the demo's layout (8 floats a vertex: position, normal, texture coordinates)
+// is stored on the GPU. The smaller formats quantize every attribute, the vertex shader turns them back into floats:
+//
+//   float    position 3x float, normal 3x float, UV 2x float (the layout as built)             32 bytes
+//   snorm16  position 3x snorm16 (+2 unused bytes), normal octahedral 2x snorm16, UV 2x half   16 bytes
+//   snorm8   position 3x snorm16, normal octahedral 2x snorm8, UV 2x half                      12 bytes
+//   derived  position 3x snorm16 (+2 unused bytes), UV 2x half, no normal:                     12 bytes
+//            the vertex shader uses the normalised position, which is exact for a sphere around the origin
+//
+// snorm16 positions step 1/32767 across -1..1 (the unit sphere and cube fit; anything outside is clamped, with a
+// warning). An octahedral normal folds the unit sphere onto a square, so two numbers are enough for a direction.
+// Half floats hold the UVs to about 1/2048, a tenth of a texel of the biggest planet texture.
+// The packed formats also store the indices in 16 bits whenever the mesh has at most 65536 vertices (the 128x128
+// sphere has 16641); float keeps them 32 bits, so it is exactly the layout before packing to compare against.
+//
+// The vertex shaders read the normal through the `normalEncoding` uniform (normalEncoding()); 0, the value a
+// program starts with, is the plain float normal.
+//
+// Usage:
+//   PackedMesh mesh = PackedMesh::pack(vertices, indices, VertexFormat::Derived, "sphere"); // prints the sizes
+//   glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size(), mesh.vertices.data(), GL_STATIC_DRAW);
+//   mesh.setAttributes(0, 1, 2);   // with the VAO and the vertex buffer bound
+//   glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, 0);
+enum class VertexFormat { Float, Snorm16, Snorm8, Derived };
+
+inline const char *vertexFormatName(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Snorm16: return "snorm16";
+    case VertexFormat::Snorm8: return "snorm8";
+    case VertexFormat::Derived: return "derived";
+    default: return "float";
+    }
+}
+
+// "float", "snorm16", "snorm8" or "derived"; false (format unchanged) for anything else
+inline bool parseVertexFormat(const std::string &name, VertexFormat &format) {
+    for (VertexFormat f : {VertexFormat::Float, VertexFormat::Snorm16, VertexFormat::Snorm8, VertexFormat::Derived}) {
+        if (name == vertexFormatName(f)) {
+            format = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct PackedMesh {
+    VertexFormat format = VertexFormat::Float;
+    GLsizei stride = 0;                  // bytes per vertex
+    size_t vertexCount = 0, indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;  // GL_UNSIGNED_SHORT when packed and every index fits in 16 bits
+    float normalError = 0.0f;            // largest angle (degrees) between a built normal and the one the shader gets
+    std::vector<unsigned char> vertices, indices; // ready for glBufferData
+
+    static PackedMesh pack(const std::vector<float> &built, const std::vector<unsigned int> &builtIndices,
+                           VertexFormat format, const char *name = nullptr) {
+        PackedMesh mesh;
+        mesh.format = format;
+        mesh.stride = strideOf(format);
+        mesh.vertexCount = built.size() / 8;
+        mesh.indexCount = builtIndices.size();
+        mesh.vertices.resize(mesh.vertexCount * mesh.stride);
+
+        bool clamped = false;
+        for (size_t i = 0; i < mesh.vertexCount; ++i) {
+            const float *v = &built[i * 8];
+            unsigned char *out = &mesh.vertices[i * mesh.stride];
+            if (format == VertexFormat::Float) {
+                std::memcpy(out, v, 8 * sizeof(float));
+                continue;
+            }
+
+            int16_t position[4] = {0, 0, 0, 0};
+            for (int c = 0; c < 3; ++c) {
+                clamped = clamped || std::fabs(v[c]) > 1.0f;
+                position[c] = static_cast<int16_t>(toSnorm(v[c], 32767.0f));
+            }
+            uint16_t uv[2] = {glm::packHalf1x16(v[6]), glm::packHalf1x16(v[7])};
+            glm::vec3 normal = glm::normalize(glm::vec3(v[3], v[4], v[5]));
+            glm::vec3 decoded;
+            if (format == VertexFormat::Derived) {
+                std::memcpy(out, position, 8);
+                std::memcpy(out + 8, uv, 4);
+                decoded = glm::normalize(glm::vec3(position[0], position[1], position[2]));
+            } else if (format == VertexFormat::Snorm16) {
+                int encoded[2];
+                decoded = octEncode(normal, 32767.0f, encoded);
+                int16_t packed[2] = {static_cast<int16_t>(encoded[0]), static_cast<int16_t>(encoded[1])};
+                std::memcpy(out, position, 8);
+                std::memcpy(out + 8, packed, 4);
+                std::memcpy(out + 12, uv, 4);
+            } else {
+                int encoded[2];
+                decoded = octEncode(normal, 127.0f, encoded);
+                int8_t packed[2] = {static_cast<int8_t>(encoded[0]), static_cast<int8_t>(encoded[1])};
+                std::memcpy(out, position, 6);
+                std::memcpy(out + 6, packed, 2);
+                std::memcpy(out + 8, uv, 4);
+            }
+            float angle = std::acos(std::min(1.0f, glm::dot(normal, decoded))) * 57.2957795f;
+            mesh.normalError = std::max(mesh.normalError, angle);
+        }
+        if (clamped) std::cout << "PackedMesh: positions outside -1..1 were clamped" << (name ? std::string(" in ") + name : "") << "\n";
+
+        // 16-bit indices when they all fit (no primitive restart, so 65535 is an ordinary index)
+        if (format != VertexFormat::Float && mesh.vertexCount <= 65536) {
+            mesh.indexType = GL_UNSIGNED_SHORT;
+            mesh.indices.resize(mesh.indexCount * sizeof(uint16_t));
+            for (size_t i = 0; i < mesh.indexCount; ++i) {
+                uint16_t index = static_cast<uint16_t>(builtIndices[i]);
+                std::memcpy(&mesh.indices[i * sizeof(uint16_t)], &index, sizeof(uint16_t));
+            }
+        } else {
+            mesh.indices.resize(mesh.indexCount * sizeof(unsigned int));
+            std::memcpy(mesh.indices.data(), builtIndices.data(), mesh.indices.size());
+        }
+
+        if (name) {
+            size_t floatBytes = mesh.vertexCount * 8 * sizeof(float), intBytes = mesh.indexCount * sizeof(unsigned int);
+            std::cout << "Mesh " << name << ": " << vertexFormatName(format) << " vertices " << mesh.vertices.size() / 1024
+                      << " KB (" << mesh.stride << " bytes each, float " << floatBytes / 1024 << " KB), "
+                      << (mesh.indexType == GL_UNSIGNED_SHORT ? 16 : 32) << "-bit indices " << mesh.indices.size() / 1024
+                      << " KB (32-bit " << intBytes / 1024 << " KB), normals within " << mesh.normalError << " degrees\n";
+        }
+        return mesh;
+    }
+
+    // Points the bound VAO at the bound GL_ARRAY_BUFFER: position at location `position`, the normal at `normal`
+    // (-1 = not read, like the sun's shader) and the texture coordinates at `texCoord`
+    void setAttributes(GLuint position, GLint normal, GLuint texCoord) const {
+        if (format == VertexFormat::Float) {
+            glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+            if (normal >= 0) glVertexAttribPointer(normal, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+            glVertexAttribPointer(texCoord, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+        } else {
+            glVertexAttribPointer(position, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+            if (normal >= 0 && format == VertexFormat::Snorm16) glVertexAttribPointer(normal, 2, GL_SHORT, GL_TRUE, stride, (void*)8);
+            if (normal >= 0 && format == VertexFormat::Snorm8) glVertexAttribPointer(normal, 2, GL_BYTE, GL_TRUE, stride, (void*)6);
+            glVertexAttribPointer(texCoord, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)static_cast<size_t>(format == VertexFormat::Snorm16 ? 12 : 8));
+        }
+        glEnableVertexAttribArray(position);
+        if (normal >= 0 && format != VertexFormat::Derived) glEnableVertexAttribArray(normal);
+        glEnableVertexAttribArray(texCoord);
+    }
+
+    // The vertex shaders' normalEncoding uniform: 0 = float normal, 1 = octahedral, 2 = from the position
+    int normalEncoding() const {
+        return format == VertexFormat::Float ? 0 : format == VertexFormat::Derived ? 2 : 1;
+    }
+
+    static GLsizei strideOf(VertexFormat format) {
+        switch (format) {
+        case VertexFormat::Snorm16: return 16;
+        case VertexFormat::Snorm8: return 12;
+        case VertexFormat::Derived: return 12;
+        default: return 8 * sizeof(float);
+        }
+    }
+
+private:
+    static int toSnorm(float value, float range) {
+        return static_cast<int>(std::round(std::min(1.0f, std::max(-1.0f, value)) * range));
+    }
+
+    // Same decode as the vertex shaders
+    static glm::vec3 octDecode(float x, float y) {
+        glm::vec3 n(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+        float t = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    // Octahedral encoding of a unit normal into two snorm values of `range` steps. Of the 4 roundings around the
+    // exact point the one decoding closest to the normal is kept (plain rounding can be off by twice as much).
+    // Returns the decoded normal.
+    static glm::vec3 octEncode(const glm::vec3 &n, float range, int out[2]) {
+        float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        float x = n.x / sum, y = n.y / sum;
+        if (n.z < 0.0f) { // lower half: fold over the diagonals
+            float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+        glm::vec3 best(0.0f);
+        float bestDot = -2.0f;
+        for (int corner = 0; corner < 4; ++corner) {
+            int ex = static_cast<int>(corner & 1 ? std::ceil(x * range) : std::floor(x * range));
+            int ey = static_cast<int>(corner & 2 ? std::ceil(y * range) : std::floor(y * range));
+            ex = std::min(static_cast<int>(range), std::max(-static_cast<int>(range), ex));
+            ey = std::min(static_cast<int>(range), std::max(-static_cast<int>(range), ey));
+            glm::vec3 decoded = octDecode(ex / range, ey / range);
+            float d = glm::dot(decoded, n);
+            if (d > bestDot) {
+                bestDot = d;
+                best = decoded;
+                out[0] = ex;
+                out[1] = ey;
+            }
+        }
+        return best;
+    }
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <memory>
+#include "input.h"
 
 class Window
 {
@@ -10,19 +12,38 @@ public:
     Window();
     Window(GLint windowWidth, GLint windowHeight); // get window's width, height and keys
 
-    int Initialise(); // create window screen
+    int Initialise(bool visible = true); // create window screen (hidden for benchmarks)
 
     GLint getBufferWidth() { return bufferWidth; }
     GLint getBufferHeight() { return bufferHeight; }
 
+    // True once after the framebuffer was resized (then read getBufferWidth / getBufferHeight)
+    bool takeResize() {
+        bool wasResized = resized;
+        resized = false;
+        return wasResized;
+    }
+
     bool getShouldClose() { return glfwWindowShouldClose(mainWindow); }
 
     bool* getsKeys() { return keys; } // WASD controls
+    bool* getMouseButtons() { return mouseButtons; } // GLFW_MOUSE_BUTTON_LEFT etc
+
+    // Timestamped key / mouse events in arrival order. Only one thread may read it (see InputState).
+    InputQueue& getInputQueue() { return *inputQueue; }
+
+    // Synthetic input (benchmarks): goes through the same queue as real events, stamped now if event.time is 0.
+    // Must not be called while real callbacks can fire on another thread (the queue has one producer).
+    void injectEvent(InputEvent event);
     GLfloat getXChange();
     GLfloat getYChange();
 
     void swapBuffers() { glfwSwapBuffers(mainWindow); }
 
+    // The OpenGL context belongs to one thread at a time (see RenderThread)
+    void makeCurrent() { glfwMakeContextCurrent(mainWindow); }
+    static void releaseCurrent() { glfwMakeContextCurrent(nullptr); }
+
     ~Window();
 
 private:
@@ -30,8 +51,10 @@ private:
 
     GLint width, height;
     GLint bufferWidth, bufferHeight;
+    bool resized = false;
 
     bool keys[1024];
+    bool mouseButtons[8];
 
     GLfloat lastX;
     GLfloat lastY;
@@ -39,9 +62,15 @@ private:
     GLfloat yChange;
     bool mouseFirstMoved;
 
+    std::shared_ptr<InputQueue> inputQueue; // shared so the Window stays copyable
+
     void createCallbacks();
     static void handleKeys(GLFWwindow* window, int key, int code, int action, int mode);
     static void handleMouse(GLFWwindow* window, double xPos, double yPos);
+    static void handleMouseButton(GLFWwindow* window, int button, int action, int mods);
+    static void handleScroll(GLFWwindow* window, double xOffset, double yOffset);
+    static void handleFramebufferSize(GLFWwindow* window, int newWidth, int newHeight);
+    void pushEvent(InputEvent::Type type, int code, int action, float x, float y);
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,5 @@
 // To run this code: navigate to SRC folder -> copy/paste below
-// g++ -g -std=c++17 -I../include -L../include/lib glad.c window.cpp main.cpp -lglfw3dll -lopengl32 -o ../build/run.exe && ../build/run.exe
+// g++ -g -std=c++17 -pthread -I../include -L../include/lib glad.c window.cpp main.cpp -lglfw3dll -lopengl32 -o ../build/run.exe && ../build/run.exe
 
 #include <iostream>
 #include <vector>
@@ -10,21 +10,111 @@
 #include "headers/shader.h"
 #include "headers/mesh.h"
 #include "headers/camera.h"
+#include "headers/jobs.h"
+#include "headers/input.h"
+#include "headers/latency.h"
+#include "headers/framepacer.h"
+#include "headers/renderthread.h"
+#include "headers/profiler.h"
+#include "headers/framestats.h"
 
 // Global variables
 Window mainWindow; // create object and run Window();
 Camera camera;
+JobSystem jobs; // worker threads for texture decoding, mesh building, body updates and culling
 
 GLfloat deltaTime = 0.0f;
 GLfloat lastTime = 0.0f;
 
+InputState input; // key / mouse state rebuilt from the window's event queue
+LatencyTracker latency; // input-to-photon latency of camera movement
+bool lateLatch = true;  // rewrite the camera with the newest mouse movement just before swapBuffers
+FramePacer pacer;       // vsync / adaptive vsync / software frame limiter (used by the render thread)
+FramePacer::Mode pacing = FramePacer::Limiter; // main thread's copy of the pacing mode
+FrameStats frameStats;  // frame / CPU / GPU times and draw counts of the last frames, written out on exit
+bool dynamicResolution = true; // lower the scene resolution when the GPU can't keep up with the refresh rate
+float gpuBudgetMs = 0.0f;      // GPU time per frame dynamic resolution aims for
+bool glTrace = false;          // count every GL call per frame (and binds that change nothing)
+bool bloom = false;            // glow around the sun (extra frame graph passes)
+
 // User input
-void userinput() {
-        camera.keyControl(mainWindow.getsKeys(), deltaTime); // getKeys() returns bool keys[1024];
-        camera.mouseControl(mainWindow.getXChange(), mainWindow.getYChange());
+void userinput(Tri &tri, RenderThread &renderer) {
+        PROFILE_ZONE("userinput");
+        // apply every event since last frame: mouse movement is summed, so none is lost at low frame rates
+        input.drain(mainWindow.getInputQueue());
+        double inputTime = input.takeInputTime(); // when the oldest of these events arrived
+        camera.keyControl(input.keys, deltaTime, inputTime); // keys[1024]
+        camera.mouseControl(input.takeXChange(), input.takeYChange(), true, inputTime);
+
+        // Left click: pick the body under the crosshair and print its orbit info
+        if (input.takeButtonPress(GLFW_MOUSE_BUTTON_LEFT)) {
+            int index = tri.pick(camera);
+            if (index >= 0) {
+                const SolarSystem &solar = tri.getSolar();
+                const Body &body = solar.bodies[index];
+                std::cout << "Picked " << body.name
+                          << ": distance " << glm::length(solar.getPosition(body) - camera.Position)
+                          << ", orbit radius " << body.orbit.radius.x
+                          << ", orbit speed " << body.orbit.speed << " rad/s"
+                          << (body.parent >= 0 ? ", orbits " + solar.bodies[body.parent].name : std::string()) << "\n";
+            }
+        }
+
+        // L: toggle the late-latched camera
+        if (input.takeKeyPress(GLFW_KEY_L)) {
+            lateLatch = !lateLatch;
+            renderer.setLateLatch(lateLatch);
+            std::cout << "Late latch " << (lateLatch && tri.supportsLateLatch() ? "on" : "off") << "\n";
+        }
+
+        // P: next frame pacing mode (prints how even the frames were in the previous one)
+        if (input.takeKeyPress(GLFW_KEY_P)) {
+            pacing = static_cast<FramePacer::Mode>((pacing + 1) % FramePacer::ModeCount);
+            renderer.setPacing(pacing, FramePacer::getRefreshRate()); // the render thread switches and reports
+        }
+
+        // R: toggle dynamic resolution
+        if (input.takeKeyPress(GLFW_KEY_R)) {
+            dynamicResolution = !dynamicResolution;
+            renderer.setDynamicResolution(dynamicResolution, gpuBudgetMs);
+        }
+
+        // G: toggle GL call tracing
+        if (input.takeKeyPress(GLFW_KEY_G)) {
+            glTrace = !glTrace;
+            renderer.setGlTrace(glTrace);
+        }
+
+        // B: toggle bloom
+        if (input.takeKeyPress(GLFW_KEY_B)) {
+            bloom = !bloom;
+            renderer.setBloom(bloom);
+        }
+
+        // O: toggle occlusion culling (the frame still looks the same, fewer bodies are drawn)
+        if (input.takeKeyPress(GLFW_KEY_O)) {
+            tri.setOcclusionCulling(!tri.getOcclusionCulling());
+            std::cout << "Occlusion culling " << (tri.getOcclusionCulling() ? "on" : "off") << "\n";
+        }
+
+#ifdef PROFILE
+        // T: write the CPU zones recorded so far (open in chrome://tracing or ui.perfetto.dev)
+        if (input.takeKeyPress(GLFW_KEY_T)) {
+            PROFILE_DUMP("trace.json");
+        }
+#endif
+
+        // F: fly to the picked body
+        if (input.keys[GLFW_KEY_F] && tri.getPicked() >= 0) {
+            const SolarSystem &solar = tri.getSolar();
+            const Body &body = solar.bodies[tri.getPicked()];
+            camera.focusOn(solar.getPosition(body), solar.getRadius(body) * 4.0f);
+        }
 }
 
 int main() {
+    PROFILE_THREAD("main");
+
     // 1. Initialize Window using the new Window class
     mainWindow = Window(1200, 800);
     if (mainWindow.Initialise() != 0) {
@@ -32,44 +122,78 @@ int main() {
     }
 
     // 2. Create objects and shaders
-    Tri tri;
+    Tri tri(&jobs);
     Shader shader("asset/shaders/vertex.vs","asset/shaders/fragment.fs");
     Shader light("asset/shaders/lightver.vs","asset/shaders/lightfrag.fs");
-    Shader background("asset/shaders/background.vs","asset/shaders/background.fs");
+    shader.setBlockBinding("Camera", CameraBuffer::BINDING); // view / projection come from the camera uniform buffer
+    light.setBlockBinding("Camera", CameraBuffer::BINDING);
 
     // 3. Initialize camera and shader
     camera = Camera();
-  
+    latency.create(glfwGetTime());
+    pacer.setMode(pacing); // steady frames at the monitor's refresh rate without blocking in the driver
+    gpuBudgetMs = static_cast<float>(900.0 / FramePacer::getRefreshRate()); // 90% of a refresh interval
+    tri.setViewport(mainWindow.getBufferWidth(), mainWindow.getBufferHeight());
+    tri.setDynamicResolution(dynamicResolution, gpuBudgetMs);
+
     // 4. Render loop
+    // This thread reads input and simulates, the render thread owns the GL context and draws:
+    // frame N+1 is built while frame N is being submitted to the GPU.
+    RenderThread renderer(mainWindow, tri, light, shader, pacer, latency);
+    renderer.setLateLatch(lateLatch);
+    renderer.setFrameStats(&frameStats);
+    renderer.start();
     while (!mainWindow.getShouldClose()) {
         // Calculate delta time
         GLfloat now = glfwGetTime();
         deltaTime = now - lastTime;
         lastTime = now;
+        double simStart = glfwGetTime(); // frame statistics: CPU time of input + simulation
 
         // updates key states and mouse changes after reading userinput();
-        glfwPollEvents();  // call this first before userinput();
+        {
+            PROFILE_ZONE("glfwPollEvents");
+            glfwPollEvents();  // call this first before userinput();
+        }
 
         // read / process each user inputs
-        userinput(); 
+        userinput(tri, renderer);
 
-        // Set background clear color
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f); 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // window resized: new aspect ratio and viewport from the next packet on
+        if (mainWindow.takeResize()) {
+            tri.setViewport(mainWindow.getBufferWidth(), mainWindow.getBufferHeight());
+        }
 
-        // Draw 
-        tri.draw(light, shader, background, camera);
+        // Late latch: the frame still being drawn can pick up this camera just before its swapBuffers
+        double inputTime = camera.takeInputTime();
+        renderer.latchCamera(tri.cameraBlock(camera), inputTime);
 
-        // Swap buffers
-        mainWindow.swapBuffers();
-        glfwSwapInterval(0); // Disable VSync
+        // Simulate, cull and hand the frame to the render thread
+        FramePacket &packet = renderer.beginFrame();
+        packet.inputTime = inputTime; // stamps the GPU finish of frames that moved the camera
+        tri.buildPacket(camera, glfwGetTime(), packet);
+        packet.simMs = static_cast<float>((glfwGetTime() - simStart) * 1000.0);
+        renderer.submit();
     }
+    renderer.stop(); // GL context is back on this thread
 
     // 5. Cleanup
+    pacer.printReport();
+    latency.finish();
+    latency.printReport("camera");
+    tri.getProfiler().printReport();
+    frameStats.printReport();
+    GlTrace::printReport(); // only if G was used
+    GlTrace::uninstall();
+    frameStats.writeCsv("frame_stats.csv");
+    frameStats.writeJson("frame_stats.json");
+    latency.del();
+
     std::cerr << "Freeing up memory...\n";
     tri.del();
     glDeleteProgram(shader.ID);
     glDeleteProgram(light.ID);
+    PROFILE_DUMP("trace.json");
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Offline skybox converter: turns the equirectangular star map (space.png, longitude across, latitude down)
+// into the mipmapped cubemap the demo draws as its sky (src/headers/skybox.h has the .cubemap layout).
+// Run it after changing space.png; the demo reads the result instead of converting at every start.
+//
+// The conversion itself is Cubemap::build (src/headers/cubemap.h); the demo runs the same code at startup if the
+// .cubemap file is missing, so this is only needed to make it ahead of time or at another size.
+//
+// To run this code (Linux): navigate to "Solar system" folder -> copy/paste below
+// g++ -O2 -std=c++17 -pthread -Iinclude src/make_skybox.cpp -o build/make_skybox && build/make_skybox
+//
+// Usage: make_skybox [--size N] [input] [output]
+//   --size N   face size in texels (power of two), default 1024
+//   input      default asset/textures/space.png
+//   output     default asset/textures/space.cubemap
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "headers/stb_image.h"
+#include "headers/cubemap.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+    int size = Cubemap::FACE_SIZE;
+    std::string input = "asset/textures/space.png", output = "asset/textures/space.cubemap";
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) size = std::atoi(argv[++i]);
+        else if (arg.compare(0, 2, "--") != 0 && positional == 0) { input = arg; ++positional; }
+        else if (arg.compare(0, 2, "--") != 0 && positional == 1) { output = arg; ++positional; }
+        else {
+            std::cerr << "usage: make_skybox [--size N] [input] [output]\n";
+            return 1;
+        }
+    }
+    if (size <= 0 || (size & (size - 1)) != 0) {
+        std::cerr << "make_skybox: --size must be a power of two\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    int width = 0, height = 0, channels = 0;
+    unsigned char *pixels = stbi_load(input.c_str(), &width, &height, &channels, 3);
+    if (!pixels) {
+        std::cerr << "make_skybox: cannot read " << input << " (" << stbi_failure_reason() << ")\n";
+        return 1;
+    }
+    int samples = Cubemap::samplesPerTexel(width, size);
+    std::cout << input << ": " << width << "x" << height << " -> 6 faces of " << size << "x" << size
+              << " (" << samples << "x" << samples << " samples a texel)\n";
+
+    JobSystem jobs;
+    std::vector<char> cubemap = Cubemap::build(pixels, width, height, size, &jobs);
+    stbi_image_free(pixels);
+
+    std::ofstream file(output, std::ios::binary);
+    file.write(cubemap.data(), static_cast<std::streamsize>(cubemap.size()));
+    if (!file) {
+        std::cerr << "make_skybox: writing " << output << " failed\n";
+        return 1;
+    }
+    std::cout << output << ": " << Cubemap::levelCount(size) << " levels, " << cubemap.size() / (1024 * 1024) << " MB, "
+              << std::chrono::duration<float>(Clock::now() - start).count() << " s\n";
+    return 0;
+}
@@ -0,0 +1,150 @@
+// Replays a GL capture (see headers/glcapture.h) headless, as fast as possible, and reports per-frame timings.
+// Only the recorded GL calls run: no simulation, no culling, no texture decoding, so changes to the driver or the
+// GL back end can be compared on exactly the same command stream. The replay is deterministic: the same calls
+// with the same data in the same order every run.
+//
+// To run this code (Linux): navigate to "Solar system" folder -> copy/paste below
+// g++ -O2 -std=c++17 -pthread -Iinclude src/glad.c src/replay_trace.cpp -lEGL -lz -ldl -o build/replay_trace && build/replay_trace capture.glcap
+//
+// Make a capture with run_headless --capture capture.glcap [--capture-range FIRST-LAST].
+//
+// Options:
+//   --finish          wait for the GPU after every frame (frames don't overlap, frame time = that frame's full cost)
+//   --stats PATH      per-frame statistics of the timed frames (CSV if PATH ends in .csv, JSON otherwise)
+//   --dump-every K    write every K-th frame as replay_NNNNN.ppm (default 0 = never)
+//   --dump-dir DIR    where the frames go, default "."
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include "headers/headless.h"
+#include "headers/glcapture.h"
+#include "headers/framestats.h"
+
+int main(int argc, char **argv) {
+    std::string tracePath;
+    bool finish = false;
+    std::string statsPath;
+    int dumpEvery = 0;
+    std::string dumpDir = ".";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--finish") finish = true;
+        else if (arg == "--stats" && i + 1 < argc) statsPath = argv[++i];
+        else if (arg == "--dump-every" && i + 1 < argc) dumpEvery = std::atoi(argv[++i]);
+        else if (arg == "--dump-dir" && i + 1 < argc) dumpDir = argv[++i];
+        else if (tracePath.empty() && arg[0] != '-') tracePath = arg;
+        else {
+            tracePath.clear();
+            break;
+        }
+    }
+    if (tracePath.empty()) {
+        std::cerr << "usage: replay_trace TRACE [--finish] [--stats PATH] [--dump-every K] [--dump-dir DIR]\n";
+        return 1;
+    }
+
+    int width = 0, height = 0;
+    if (!GlReplay::readSize(tracePath, width, height)) {
+        return 1;
+    }
+
+    HeadlessContext context(width, height);
+    if (context.Initialise() != 0) {
+        return 1;
+    }
+    GlReplay replay;
+    if (!replay.open(tracePath)) {
+        return 1;
+    }
+    replay.setDefaultFramebuffer(context.getFramebuffer());
+    std::cout << "Replaying " << tracePath << ": " << replay.getFrames() << " frames, the first "
+              << replay.getWarmupFrames() << " untimed\n";
+
+    // GPU time per frame: a timestamp before and after, read back a few frames later so nothing stalls
+    const int QUERY_FRAMES = 4;
+    GLuint queries[QUERY_FRAMES][2];
+    glGenQueries(QUERY_FRAMES * 2, &queries[0][0]);
+    std::vector<FrameSample> samples;
+    size_t gpuTimed = 0; // samples whose GPU time has been read back
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastFrame = start;
+    Clock::time_point timedStart = start;
+    uint32_t frame = 0;
+    for (;; ++frame) {
+        bool timed = frame >= replay.getWarmupFrames();
+        if (frame == replay.getWarmupFrames()) {
+            glFinish(); // warm-up work must not count towards the first timed frame
+            timedStart = lastFrame = Clock::now();
+        }
+        GLuint *query = queries[frame % QUERY_FRAMES];
+        size_t sample = samples.size();
+        if (timed && sample >= QUERY_FRAMES) { // the queries about to be reused belong to frame `sample - QUERY_FRAMES`
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(query[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(query[1], GL_QUERY_RESULT, &end);
+            samples[sample - QUERY_FRAMES].gpuMs = static_cast<float>(end - begin) / 1e6f;
+            gpuTimed = sample - QUERY_FRAMES + 1;
+        }
+
+        Clock::time_point renderStart = Clock::now();
+        if (timed) glQueryCounter(query[0], GL_TIMESTAMP);
+        if (!replay.replayFrame()) break;
+        if (timed) glQueryCounter(query[1], GL_TIMESTAMP);
+        Clock::time_point renderEnd = Clock::now();
+        if (finish) glFinish();
+
+        if (dumpEvery > 0 && frame % dumpEvery == 0) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/replay_%05u.ppm", frame);
+            context.saveFrame(dumpDir + name);
+        }
+
+        Clock::time_point now = Clock::now();
+        if (timed) {
+            FrameSample s;
+            s.time = std::chrono::duration<double>(now - timedStart).count();
+            s.frameMs = std::chrono::duration<float, std::milli>(now - lastFrame).count();
+            s.renderMs = std::chrono::duration<float, std::milli>(renderEnd - renderStart).count();
+            samples.push_back(s);
+        }
+        lastFrame = now;
+    }
+    glFinish();
+    Clock::time_point stop = Clock::now();
+
+    // GPU times of the last frames
+    for (size_t i = gpuTimed; i < samples.size(); ++i) {
+        GLuint *query = queries[(replay.getWarmupFrames() + i) % QUERY_FRAMES];
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(query[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(query[1], GL_QUERY_RESULT, &end);
+        samples[i].gpuMs = static_cast<float>(end - begin) / 1e6f;
+    }
+    glDeleteQueries(QUERY_FRAMES * 2, &queries[0][0]);
+
+    if (frame != replay.getFrames()) std::cout << "replayed " << frame << " of " << replay.getFrames() << " frames\n";
+    if (replay.getSkippedCalls()) std::cout << replay.getSkippedCalls() << " calls of functions this build doesn't know were skipped\n";
+    if (samples.empty()) {
+        std::cout << "no timed frames\n";
+        return 0;
+    }
+
+    FrameStats stats(samples.size());
+    for (const FrameSample &s : samples) stats.record(s);
+    double seconds = std::chrono::duration<double>(stop - timedStart).count();
+    std::cout << "timed " << samples.size() << " frames in " << seconds * 1000.0 << " ms, "
+              << seconds * 1000.0 / samples.size() << " ms/frame, " << samples.size() / seconds << " fps\n";
+    stats.printReport();
+    if (!statsPath.empty()) {
+        bool csv = statsPath.size() > 4 && statsPath.compare(statsPath.size() - 4, 4, ".csv") == 0;
+        if (csv ? stats.writeCsv(statsPath) : stats.writeJson(statsPath)) std::cout << "frame statistics written to " << statsPath << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,258 @@
+// Headless run: renders the solar system without a window (surfaceless EGL, works on Mesa's llvmpipe without
+// a GPU or display server) for a fixed number of frames with a fixed timestep, so every run sees the same frames.
+// The camera circles the sun once over the run. Optionally writes frames to disk as PPM images.
+//
+// To run this code (Linux): navigate to "Solar system" folder -> copy/paste below
+// g++ -O2 -std=c++17 -pthread -Iinclude src/glad.c src/run_headless.cpp -lEGL -lz -ldl -o build/run_headless && build/run_headless
+//
+// Options:
+//   --frames N        frames to render, default 300
+//   --size WxH        framebuffer size, default 1200x800
+//   --timestep S      simulated seconds per frame, default 1/60
+//   --dump-every K    write every K-th frame as frame_NNNNN.ppm (default 0 = never)
+//   --dump-dir DIR    where the frames go, default "."
+//   --stats PATH      per-frame statistics (CSV if PATH ends in .csv, JSON otherwise)
+//   --budget MS       dynamic resolution: lower the scene resolution to keep the GPU frame time under MS
+//   --gl-trace        count every GL call (and redundant binds) per frame, print the averages at the end
+//   --capture PATH    write the GL calls to PATH for replay_trace (everything up to the last captured frame)
+//   --capture-range A-B  frames to time on replay, default all; frames before A are replayed as warm-up
+//   --bloom           glow around the sun (extra frame graph passes)
+//   --no-aliasing     give every transient render target its own texture (compare the memory report)
+//   --no-occlusion    frustum culling only (the frames must come out identical, only fewer bodies are drawn)
+//   --sky-first       draw the sky before the bodies without a depth test (the old background order), to compare the
+//                     sky's shaded fragments
+//   --vertex-format F float, snorm16, snorm8 or derived: how the sphere is stored (vertexformat.h), default derived
+//   --input-rate HZ   a thread injects mouse movement at HZ events a second (like bench_latency) and the input
+//                     latency (LatencyTracker) is printed and added to the --stats JSON. The mouse turns the view by
+//                     the movement that arrived since the last frame, so the frames are no longer repeatable.
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "headers/headless.h"
+#include "headers/shader.h"
+#include "headers/mesh.h"
+#include "headers/camera.h"
+#include "headers/jobs.h"
+#include "headers/framestats.h"
+#include "headers/gltrace.h"
+#include "headers/glcapture.h"
+#include "headers/input.h"
+#include "headers/latency.h"
+
+int main(int argc, char **argv) {
+    int frames = 300;
+    int width = 1200, height = 800;
+    double timestep = 1.0 / 60.0;
+    int dumpEvery = 0;
+    std::string dumpDir = ".";
+    std::string statsPath;
+    float budgetMs = 0.0f;
+    bool glTrace = false;
+    std::string capturePath;
+    int captureFirst = 0, captureLast = -1; // -1 = up to the last frame
+    bool bloom = false;
+    bool aliasing = true;
+    bool occlusion = true;
+    bool skyFirst = false;
+    VertexFormat vertexFormat = VertexFormat::Derived;
+    double inputRate = 0.0; // 0 = no synthetic input
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) frames = std::atoi(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2) width = height = 0;
+        }
+        else if (arg == "--timestep" && i + 1 < argc) timestep = std::atof(argv[++i]);
+        else if (arg == "--dump-every" && i + 1 < argc) dumpEvery = std::atoi(argv[++i]);
+        else if (arg == "--dump-dir" && i + 1 < argc) dumpDir = argv[++i];
+        else if (arg == "--stats" && i + 1 < argc) statsPath = argv[++i];
+        else if (arg == "--budget" && i + 1 < argc) budgetMs = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--gl-trace") glTrace = true;
+        else if (arg == "--capture" && i + 1 < argc) capturePath = argv[++i];
+        else if (arg == "--capture-range" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d-%d", &captureFirst, &captureLast) != 2) captureFirst = -1;
+        }
+        else if (arg == "--bloom") bloom = true;
+        else if (arg == "--no-aliasing") aliasing = false;
+        else if (arg == "--no-occlusion") occlusion = false;
+        else if (arg == "--sky-first") skyFirst = true;
+        else if (arg == "--vertex-format" && i + 1 < argc) {
+            if (!parseVertexFormat(argv[++i], vertexFormat)) {
+                std::cerr << "run_headless: unknown vertex format " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--input-rate" && i + 1 < argc) inputRate = std::atof(argv[++i]);
+        else {
+            std::cerr << "usage: run_headless [--frames N] [--size WxH] [--timestep S] [--dump-every K] [--dump-dir DIR] [--stats PATH] [--budget MS] [--gl-trace] [--capture PATH] [--capture-range A-B] [--bloom] [--no-aliasing] [--no-occlusion] [--sky-first] [--vertex-format F] [--input-rate HZ]\n";
+            return 1;
+        }
+    }
+    if (frames <= 0 || width <= 0 || height <= 0 || timestep <= 0.0 || inputRate < 0.0) {
+        std::cerr << "run_headless: need at least one frame, a positive size and timestep, and an input rate of 0 or more\n";
+        return 1;
+    }
+    if (captureLast < 0) captureLast = frames - 1;
+    if (captureFirst < 0 || captureFirst > captureLast || captureLast >= frames) {
+        std::cerr << "run_headless: --capture-range needs 0 <= A <= B < frames\n";
+        return 1;
+    }
+
+    HeadlessContext context(width, height, timestep);
+    if (context.Initialise() != 0) {
+        return 1;
+    }
+    if (glTrace) GlTrace::install();
+    if (!capturePath.empty() && !GlCapture::start(capturePath, width, height, context.getFramebuffer(),
+                                                  static_cast<uint32_t>(captureFirst), static_cast<uint32_t>(captureLast + 1))) {
+        return 1;
+    }
+
+    JobSystem jobs;
+    Tri tri(&jobs, vertexFormat);
+    tri.setViewport(width, height);
+    tri.setDynamicResolution(budgetMs > 0.0f, budgetMs);
+    tri.setBloom(bloom);
+    tri.getFrameGraph().setAliasing(aliasing);
+    tri.setOcclusionCulling(occlusion);
+    tri.setSkyFirst(skyFirst);
+    Shader shader("asset/shaders/vertex.vs", "asset/shaders/fragment.fs");
+    Shader light("asset/shaders/lightver.vs", "asset/shaders/lightfrag.fs");
+    shader.setBlockBinding("Camera", CameraBuffer::BINDING);
+    light.setBlockBinding("Camera", CameraBuffer::BINDING);
+
+    const SolarSystem &solar = tri.getSolar();
+    glm::vec3 sun = solar.getPosition(solar.bodies[solar.findBody("Sun")]);
+    Camera camera;
+    FramePacket packet;
+    FrameStats stats(static_cast<size_t>(frames));
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastFrame = start;
+    // wall clock seconds since the start (input events and LatencyTracker need the same clock; the simulation
+    // keeps its fixed timestep)
+    auto seconds = [&]() { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    // synthetic input: the same path as bench_latency (queue -> InputState -> Camera -> frame -> GL_TIMESTAMP / fence)
+    InputQueue inputQueue;
+    InputState input;
+    LatencyTracker latency;
+    std::atomic<bool> injecting{inputRate > 0.0};
+    std::thread injector;
+    if (injecting.load()) {
+        latency.create(seconds());
+        injector = std::thread([&]() {
+            auto period = std::chrono::duration<double>(1.0 / inputRate);
+            Clock::time_point next = Clock::now();
+            while (injecting.load()) {
+                InputEvent event;
+                event.type = InputEvent::MouseMove;
+                event.x = 0.5f; // slow constant pan
+                event.time = seconds();
+                inputQueue.push(event);
+                next += std::chrono::duration_cast<Clock::duration>(period);
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+
+    for (int frame = 0; frame < frames; ++frame) {
+        double time = context.getTime();
+
+        // scripted camera: one circle around the sun over the run, slightly above the orbits
+        float angle = 2.0f * 3.14159265f * static_cast<float>(frame) / static_cast<float>(frames);
+        camera.Position = sun + glm::vec3(std::cos(angle) * 60.0f, 18.0f, std::sin(angle) * 60.0f);
+        camera.focusOn(sun, 63.0f);
+        if (inputRate > 0.0) {
+            input.drain(inputQueue);
+            camera.mouseControl(input.takeXChange(), input.takeYChange(), true, input.takeInputTime());
+        }
+
+        FrameSample sample;
+        Clock::time_point simStart = Clock::now();
+        tri.buildPacket(camera, time, packet);
+        Clock::time_point renderStart = Clock::now();
+
+        context.bind();
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        tri.render(light, shader, packet);
+        Clock::time_point renderEnd = Clock::now();
+        if (inputRate > 0.0) latency.endFrame(camera.takeInputTime(), seconds()); // after the frame's last draw
+
+        if (dumpEvery > 0 && frame % dumpEvery == 0) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%05d.ppm", frame);
+            context.saveFrame(dumpDir + name);
+        }
+        context.endFrame();
+        GlTrace::endFrame();
+        GlCapture::endFrame(); // stops by itself after the last captured frame
+
+        Clock::time_point now = Clock::now();
+        sample.time = time;
+        sample.frameMs = std::chrono::duration<float, std::milli>(now - lastFrame).count();
+        sample.simMs = std::chrono::duration<float, std::milli>(renderStart - simStart).count();
+        sample.renderMs = std::chrono::duration<float, std::milli>(renderEnd - renderStart).count();
+        sample.gpuMs = tri.getProfiler().getLastMs("frame");
+        sample.counters = tri.getCounters();
+        sample.counters.stateChanges = GlTrace::getLastStateChanges(); // -1 without --gl-trace
+        stats.record(sample);
+        lastFrame = now;
+    }
+    injecting.store(false);
+    if (injector.joinable()) injector.join();
+    glFinish();
+    double runSeconds = seconds();
+
+    std::cout << "frames " << frames << ", " << runSeconds * 1000.0 / frames << " ms/frame (wall clock)\n";
+    stats.printReport();
+    if (inputRate > 0.0) {
+        latency.finish();
+        latency.printReport("synthetic mouse");
+        FrameStats::Summary inputLatency;
+        inputLatency.mean = latency.getMeanMs();
+        inputLatency.p50 = latency.getPercentileMs(50.0);
+        inputLatency.p90 = latency.getPercentileMs(90.0);
+        inputLatency.p99 = latency.getPercentileMs(99.0);
+        inputLatency.max = latency.getPercentileMs(100.0);
+        stats.setInputLatency(inputLatency, latency.getSampleCount());
+        std::cout << "dropped input events " << inputQueue.getDropped() << "\n";
+    }
+    tri.getProfiler().printReport();
+    if (budgetMs > 0.0f) {
+        std::cout << "Dynamic resolution: final scale " << tri.getResolution().getScale() << ", "
+                  << tri.getResolution().getChanges() << " changes\n";
+    }
+    tri.getFrameGraph().printSummary();
+    if (tri.getSkybox().isLoaded()) {
+        const Skybox &sky = tri.getSkybox();
+        double pixels = static_cast<double>(width) * height;
+        std::cout << "Sky (" << (skyFirst ? "first, no depth test" : "last, depth tested") << "), a frame: "
+                  << sky.getMeanSamples() << " pixels drawn (" << 100.0 * sky.getMeanSamples() / pixels << "%)";
+        if (sky.hasInvocationCount()) {
+            std::cout << ", " << sky.getMeanInvocations() << " fragment shader invocations ("
+                      << 100.0 * sky.getMeanInvocations() / pixels << "%)";
+        }
+        std::cout << "\n";
+    }
+    GlTrace::printReport();
+    if (!statsPath.empty()) {
+        bool csv = statsPath.size() > 4 && statsPath.compare(statsPath.size() - 4, 4, ".csv") == 0;
+        if (csv ? stats.writeCsv(statsPath) : stats.writeJson(statsPath)) std::cout << "frame statistics written to " << statsPath << "\n";
+    }
+
+    latency.del();
+    tri.del();
+    glDeleteProgram(shader.ID);
+    glDeleteProgram(light.ID);
+    return 0;
+}
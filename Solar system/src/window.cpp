@@ -1,14 +1,19 @@
 #include "headers/window.h"
+#include "headers/profiler.h"
 #include <iostream>
 
 Window::Window() {
     for (int i = 0; i < 1024; i++) {
         keys[i] = false;
     }
+    for (int i = 0; i < 8; i++) {
+        mouseButtons[i] = false;
+    }
 
     xChange = 0.0f;
     yChange = 0.0f;
     mouseFirstMoved = true;
+    inputQueue = std::make_shared<InputQueue>();
 }
 
 Window::Window(GLint windowWidth, GLint windowHeight) {
@@ -18,13 +23,18 @@ Window::Window(GLint windowWidth, GLint windowHeight) {
     for (int i = 0; i < 1024; i++) {
         keys[i] = false;
     }
+    for (int i = 0; i < 8; i++) {
+        mouseButtons[i] = false;
+    }
 
     xChange = 0.0f;
     yChange = 0.0f;
     mouseFirstMoved = true;
+    inputQueue = std::make_shared<InputQueue>();
 }
 
-int Window::Initialise() {
+int Window::Initialise(bool visible) {
+    PROFILE_ZONE("Window::Initialise");
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "GLFW initialization failed!\n";
@@ -37,6 +47,7 @@ int Window::Initialise() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // For Mac compatibility
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
     // Create window
     mainWindow = glfwCreateWindow(width, height, "OpenGL Window", NULL, NULL);
@@ -55,6 +66,10 @@ int Window::Initialise() {
     // Handle user input
     createCallbacks();
     glfwSetInputMode(mainWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    // unscaled, unaccelerated mouse motion for the camera (only works while the cursor is disabled)
+    if (glfwRawMouseMotionSupported()) {
+        glfwSetInputMode(mainWindow, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+    }
 
 
     // Load OpenGL function pointers using GLAD
@@ -73,6 +88,9 @@ void Window::createCallbacks() {
     glfwSetWindowUserPointer(mainWindow, this); // allows `->` to be use inside function
     glfwSetKeyCallback(mainWindow, handleKeys);
     glfwSetCursorPosCallback(mainWindow, handleMouse);
+    glfwSetMouseButtonCallback(mainWindow, handleMouseButton);
+    glfwSetScrollCallback(mainWindow, handleScroll);
+    glfwSetFramebufferSizeCallback(mainWindow, handleFramebufferSize);
 }
 GLfloat Window::getXChange() {
     GLfloat theChange = xChange;
@@ -93,6 +111,8 @@ void Window::handleKeys(GLFWwindow* window, int key, int code, int action, int m
         glfwSetWindowShouldClose(window, true);
     }
 
+    theWindow->pushEvent(InputEvent::Key, key, action, 0.0f, 0.0f);
+
     if (key >= 0 && key < 1024) {
         if (action == GLFW_PRESS) {
             theWindow->keys[key] = true;
@@ -111,13 +131,59 @@ void Window::handleMouse(GLFWwindow* window, double xPos, double yPos) {
         theWindow->mouseFirstMoved = false;
     }
 
-    theWindow->xChange = static_cast<GLfloat>(xPos) - theWindow->lastX;
-    theWindow->yChange = theWindow->lastY - static_cast<GLfloat>(yPos);
+    // add up: several cursor events can arrive within one glfwPollEvents()
+    GLfloat dx = static_cast<GLfloat>(xPos) - theWindow->lastX;
+    GLfloat dy = theWindow->lastY - static_cast<GLfloat>(yPos);
+    theWindow->xChange += dx;
+    theWindow->yChange += dy;
+    theWindow->pushEvent(InputEvent::MouseMove, 0, 0, dx, dy);
 
     theWindow->lastX = static_cast<GLfloat>(xPos);
     theWindow->lastY = static_cast<GLfloat>(yPos);
 }
 
+void Window::handleMouseButton(GLFWwindow* window, int button, int action, int mods) {
+    Window* theWindow = static_cast<Window*>(glfwGetWindowUserPointer(window));
+
+    theWindow->pushEvent(InputEvent::MouseButton, button, action, 0.0f, 0.0f);
+
+    if (button >= 0 && button < 8) {
+        if (action == GLFW_PRESS) {
+            theWindow->mouseButtons[button] = true;
+        } else if (action == GLFW_RELEASE) {
+            theWindow->mouseButtons[button] = false;
+        }
+    }
+}
+
+void Window::handleScroll(GLFWwindow* window, double xOffset, double yOffset) {
+    Window* theWindow = static_cast<Window*>(glfwGetWindowUserPointer(window));
+    theWindow->pushEvent(InputEvent::Scroll, 0, 0, static_cast<float>(xOffset), static_cast<float>(yOffset));
+}
+
+// Window resized (or minimised, then the size is 0 x 0): remembered until the main loop calls takeResize()
+void Window::handleFramebufferSize(GLFWwindow* window, int newWidth, int newHeight) {
+    Window* theWindow = static_cast<Window*>(glfwGetWindowUserPointer(window));
+    theWindow->bufferWidth = newWidth;
+    theWindow->bufferHeight = newHeight;
+    theWindow->resized = true;
+}
+
+void Window::pushEvent(InputEvent::Type type, int code, int action, float x, float y) {
+    InputEvent event;
+    event.type = type;
+    event.code = code;
+    event.action = action;
+    event.x = x;
+    event.y = y;
+    event.time = glfwGetTime();
+    inputQueue->push(event); // full queue = consumer stalled, the event is dropped (and counted)
+}
+
+void Window::injectEvent(InputEvent event) {
+    if (event.time == 0.0) event.time = glfwGetTime();
+    inputQueue->push(event);
+}
 
 Window::~Window() { // called this automatically when exiting main()
     glfwDestroyWindow(mainWindow);